@@ -0,0 +1,90 @@
+require 'socket'
+require 'sctp/socket'
+
+# Shows head-of-line relief from the priority stream scheduler on loopback.
+#
+# A bulk transfer on stream 1 competes with small "signalling" messages on
+# stream 0. With the default first come, first served scheduler the small
+# messages queue up behind the bulk data. With the priority scheduler, and
+# stream 0 given the higher priority, they are sent ahead of it.
+#
+# Run it as root, or after raising net.core.wmem_max, for the clearest result.
+
+port = 62325
+addresses = ['127.0.0.1']
+
+bulk_chunk = 'x' * 65536
+bulk_count = 200
+pings = 50
+
+def percentile(values, pct)
+  sorted = values.sort
+  sorted[((sorted.size - 1) * pct).round]
+end
+
+def run(label, addresses, port, bulk_chunk, bulk_count, pings)
+  server = SCTP::Socket.new
+  server.bindx(:addresses => addresses, :port => port, :reuse_addr => true)
+  server.set_initmsg(:output_streams => 2, :input_streams => 2, :max_attempts => 4)
+  server.subscribe(:data_io => true)
+  server.listen
+
+  client = SCTP::Socket.new
+  client.set_initmsg(:output_streams => 2, :input_streams => 2, :max_attempts => 4)
+  client.connectx(:addresses => addresses, :port => port)
+  sleep 0.1
+
+  yield client if block_given?
+
+  latencies = []
+
+  receiver = Thread.new do
+    remaining = bulk_count + pings
+
+    while remaining > 0
+      info = server.recvmsg(0, 65536, 1024 * 1024)
+      next if info.notification
+      remaining -= 1
+
+      if info.stream == 0
+        latencies << Process.clock_gettime(Process::CLOCK_MONOTONIC) - info.message.unpack1('G')
+      end
+    end
+  end
+
+  bulk = Thread.new do
+    bulk_count.times{ client.send(:message => bulk_chunk, :stream => 1) }
+  end
+
+  pings.times do
+    client.send(:message => [Process.clock_gettime(Process::CLOCK_MONOTONIC)].pack('G'), :stream => 0)
+    sleep 0.002
+  end
+
+  bulk.join
+  receiver.join
+
+  printf(
+    "%-10s signalling latency p50: %8.3fms  p99: %8.3fms\n",
+    label,
+    percentile(latencies, 0.5) * 1000,
+    percentile(latencies, 0.99) * 1000
+  )
+ensure
+  client.close if client
+  server.close if server
+end
+
+priority = if SCTP::Socket.const_defined?(:SCTP_SS_PRIO)
+  SCTP::Socket::SCTP_SS_PRIO
+else
+  SCTP::Socket::SCTP_SS_PRIORITY
+end
+
+run('fcfs', addresses, port, bulk_chunk, bulk_count, pings)
+
+run('priority', addresses, port + 1, bulk_chunk, bulk_count, pings) do |client|
+  client.set_stream_scheduler(:scheduler => priority)
+  client.set_stream_scheduler_value(:stream => 0, :value => 0)
+  client.set_stream_scheduler_value(:stream => 1, :value => 10)
+end
@@ -34,6 +34,9 @@ else
   header = 'usrsctp.h'
   have_library('usrsctp')
 
+  # Used to initialize usrsctp exactly once, even from several Ractors
+  have_header('pthread.h')
+
   # usrsctp always provides sendv/recvv (as usrsctp_sendv/usrsctp_recvv),
   # so define the feature macros so those code paths compile in.
   $defs << '-DHAVE_SCTP_SENDV=1'
@@ -42,6 +45,20 @@ end
 
 have_header('sys/param.h')
 
+# Static tracepoints (USDT) for bpftrace, systemtap and friends
+have_header('sys/sdt.h')
+
+# Ruby 3.0+ lets extensions declare themselves safe to use from Ractors
+have_func('rb_ext_ractor_safe', 'ruby.h')
+
+# Ruby 3.0+ can deduplicate frozen strings, used for peer address strings
+have_func('rb_str_to_interned_str', 'ruby.h')
+
+# IO::Buffer (Ruby 3.2+) allows zero-copy send and receive
+if have_header('ruby/io/buffer.h')
+  have_func('rb_io_buffer_get_bytes_for_reading', 'ruby/io/buffer.h')
+end
+
 have_struct_member('struct sctp_event_subscribe', 'sctp_send_failure_event', header)
 have_struct_member('struct sctp_event_subscribe', 'sctp_stream_reset_event', header)
 have_struct_member('struct sctp_event_subscribe', 'sctp_assoc_reset_event', header)
@@ -50,8 +67,25 @@ have_struct_member('struct sctp_event_subscribe', 'sctp_send_failure_event_event
 
 have_struct_member('struct sctp_send_failed_event', 'ssfe_length', header)
 
+# Per-event, per-association subscriptions (RFC 6458 SCTP_EVENT)
+have_struct_member('struct sctp_event', 'se_assoc_id', header)
+
 have_struct_member('union sctp_notification', 'sn_auth_event', header)
 
 have_const('SCTP_EMPTY', header)
+have_const('SCTP_PARTIAL_DELIVERY_ABORTED', header)
+have_const('SCTP_PR_SCTP_ALL', header)
+
+# Peer address states beyond RFC 6458. Linux defines these as enums.
+have_const('SCTP_ADDR_CONFIRMED', header)
+have_const('SCTP_ADDR_POTENTIALLY_FAILED', header)
+
+# Stream schedulers. Linux defines these as enums, usrsctp as macros, and
+# the names differ between them.
+%w[
+  SCTP_SS_FCFS SCTP_SS_PRIO SCTP_SS_RR SCTP_SS_FC SCTP_SS_WFQ
+  SCTP_SS_DEFAULT SCTP_SS_ROUND_ROBIN SCTP_SS_ROUND_ROBIN_PACKET
+  SCTP_SS_PRIORITY SCTP_SS_FAIR_BANDWITH SCTP_SS_FIRST_COME
+].each{ |const| have_const(const, header) }
 
 create_makefile('sctp/socket')
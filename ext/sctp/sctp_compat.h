@@ -50,6 +50,24 @@ struct sctp_sndrcvinfo {
  */
 #define SCTP_DEFAULT_SEND_PARAM  0xF00D
 
+/*
+ * The PR-SCTP policy is carried in the low bits of the send flags, as with
+ * the old sctp_sndrcvinfo API. usrsctp has no name for the mask, so provide
+ * one. The send wrappers below move it into an sctp_prinfo.
+ */
+#ifndef SCTP_PR_SCTP_MASK
+#define SCTP_PR_SCTP_MASK  0x000f
+#endif
+
+/*
+ * usrsctp calls the stream scheduler sockopts SCTP_PLUGGABLE_SS and
+ * SCTP_SS_VALUE. They take the same structs as the Linux options.
+ */
+#if !defined(SCTP_STREAM_SCHEDULER) && defined(SCTP_PLUGGABLE_SS)
+#define SCTP_STREAM_SCHEDULER        SCTP_PLUGGABLE_SS
+#define SCTP_STREAM_SCHEDULER_VALUE  SCTP_SS_VALUE
+#endif
+
 /*
  * Socket descriptor type: struct socket* for usrsctp
  */
@@ -113,10 +131,31 @@ static inline int sctp_sys_close(sctp_sock_t fd){
 #define sctp_sys_freeladdrs(addrs)                  usrsctp_freeladdrs(addrs)
 #define sctp_sys_opt_info(fd, assoc, opt, arg, sz)  usrsctp_opt_info(fd, assoc, opt, arg, sz)
 
+/* --- iov gather helper ---
+ * Copy each iov entry, in order, into a flat buffer that the caller has
+ * already sized to hold the sum of the iov lengths. Returns the number of
+ * bytes copied.
+ */
+static inline size_t sctp_sys_iov_gather(char* buf, const struct iovec* iov, int iovcnt){
+  size_t offset = 0;
+  int i;
+
+  for(i = 0; i < iovcnt; i++){
+    memcpy(buf + offset, iov[i].iov_base, iov[i].iov_len);
+    offset += iov[i].iov_len;
+  }
+
+  return offset;
+}
+
 /* --- sendv wrapper ---
  * Native sctp_sendv uses iov+iovlen; usrsctp_sendv uses buf+len.
  * This wrapper concatenates iov entries if needed.
  *
+ * The concatenation here allocates a temporary buffer on every call. The
+ * SCTP::Socket#sendv method avoids that path by gathering multi-part messages
+ * into a reusable per-socket buffer first, so this is only a fallback.
+ *
  * usrsctp_sendv only supports a single destination address (addrcnt<=1),
  * so we cap addrcnt at 1.  This is not a practical limitation: SCTP's
  * multihoming addresses are exchanged during association setup (INIT/INIT-ACK)
@@ -152,13 +191,7 @@ static inline ssize_t sctp_sys_sendv(sctp_sock_t fd, const struct iovec* iov, in
     return -1;
   }
 
-  {
-    size_t offset = 0;
-    for(i = 0; i < iovcnt; i++){
-      memcpy(buf + offset, iov[i].iov_base, iov[i].iov_len);
-      offset += iov[i].iov_len;
-    }
-  }
+  sctp_sys_iov_gather(buf, iov, iovcnt);
 
   result = usrsctp_sendv(fd, buf, total,
       addrs, addrcnt, info, infolen, infotype, flags);
@@ -206,24 +239,35 @@ static inline int sctp_sys_getsockname(sctp_sock_t fd, struct sockaddr* addr, so
 }
 
 /* --- sctp_send wrapper ---
- * usrsctp doesn't have sctp_send(); map to usrsctp_sendv with SCTP_SENDV_SNDINFO.
+ * usrsctp doesn't have sctp_send(); map to usrsctp_sendv with SCTP_SENDV_SPA
+ * so that a PR-SCTP policy in the flags can be passed along as an sctp_prinfo.
  */
 static inline ssize_t sctp_sys_send(sctp_sock_t fd, const void* msg, size_t len,
     const struct sctp_sndrcvinfo* sinfo, int flags)
 {
-  struct sctp_sndinfo sndinfo;
-  memset(&sndinfo, 0, sizeof(sndinfo));
+  struct sctp_sendv_spa spa;
+  memset(&spa, 0, sizeof(spa));
+
+  spa.sendv_flags = SCTP_SEND_SNDINFO_VALID;
 
   if(sinfo){
-    sndinfo.snd_sid = sinfo->sinfo_stream;
-    sndinfo.snd_flags = sinfo->sinfo_flags;
-    sndinfo.snd_ppid = sinfo->sinfo_ppid;
-    sndinfo.snd_context = sinfo->sinfo_context;
-    sndinfo.snd_assoc_id = sinfo->sinfo_assoc_id;
+    uint16_t policy = PR_SCTP_POLICY(sinfo->sinfo_flags);
+
+    spa.sendv_sndinfo.snd_sid = sinfo->sinfo_stream;
+    spa.sendv_sndinfo.snd_flags = sinfo->sinfo_flags & ~SCTP_PR_SCTP_MASK;
+    spa.sendv_sndinfo.snd_ppid = sinfo->sinfo_ppid;
+    spa.sendv_sndinfo.snd_context = sinfo->sinfo_context;
+    spa.sendv_sndinfo.snd_assoc_id = sinfo->sinfo_assoc_id;
+
+    if(policy != SCTP_PR_SCTP_NONE){
+      spa.sendv_prinfo.pr_policy = policy;
+      spa.sendv_prinfo.pr_value = sinfo->sinfo_timetolive;
+      spa.sendv_flags |= SCTP_SEND_PRINFO_VALID;
+    }
   }
 
   return usrsctp_sendv(fd, msg, len, NULL, 0,
-      &sndinfo, sizeof(sndinfo), SCTP_SENDV_SNDINFO, flags);
+      &spa, sizeof(spa), SCTP_SENDV_SPA, flags);
 }
 
 /* --- sctp_sendmsg wrapper ---
@@ -238,12 +282,17 @@ static inline ssize_t sctp_sys_sendmsg(sctp_sock_t fd, const void* msg, size_t l
   memset(&spa, 0, sizeof(spa));
 
   spa.sendv_sndinfo.snd_sid = stream;
-  spa.sendv_sndinfo.snd_flags = flags;
+  spa.sendv_sndinfo.snd_flags = flags & ~SCTP_PR_SCTP_MASK;
   spa.sendv_sndinfo.snd_ppid = ppid;
   spa.sendv_sndinfo.snd_context = context;
   spa.sendv_flags = SCTP_SEND_SNDINFO_VALID;
 
-  if(ttl > 0){
+  if(PR_SCTP_POLICY(flags) != SCTP_PR_SCTP_NONE){
+    spa.sendv_prinfo.pr_policy = PR_SCTP_POLICY(flags);
+    spa.sendv_prinfo.pr_value = ttl;
+    spa.sendv_flags |= SCTP_SEND_PRINFO_VALID;
+  }
+  else if(ttl > 0){
     spa.sendv_prinfo.pr_policy = SCTP_PR_SCTP_TTL;
     spa.sendv_prinfo.pr_value = ttl;
     spa.sendv_flags |= SCTP_SEND_PRINFO_VALID;
@@ -263,6 +312,10 @@ static inline ssize_t sctp_sys_sendmsg(sctp_sock_t fd, const void* msg, size_t l
 /* --- sctp_recvmsg wrapper ---
  * usrsctp doesn't have sctp_recvmsg(); map to usrsctp_recvv and translate
  * the rcvinfo back into an sctp_sndrcvinfo structure.
+ *
+ * The caller is responsible for enabling SCTP_RECVRCVINFO on the socket
+ * beforehand. Setting it here would cost a setsockopt, and the usrsctp
+ * socket lock that comes with it, on every message received.
  */
 static inline ssize_t sctp_sys_recvmsg(sctp_sock_t fd, void* buf, size_t len,
     struct sockaddr* from, socklen_t* fromlen,
@@ -273,10 +326,6 @@ static inline ssize_t sctp_sys_recvmsg(sctp_sock_t fd, void* buf, size_t len,
   unsigned int infotype = 0;
   ssize_t n;
 
-  /* Ensure rcvinfo is returned */
-  int on = 1;
-  usrsctp_setsockopt(fd, IPPROTO_SCTP, SCTP_RECVRCVINFO, &on, sizeof(on));
-
   memset(&rcvinfo, 0, sizeof(rcvinfo));
 
   n = usrsctp_recvv(fd, buf, len, from, fromlen,
@@ -299,6 +348,18 @@ static inline ssize_t sctp_sys_recvmsg(sctp_sock_t fd, void* buf, size_t len,
   return n;
 }
 
+/* --- recvmsg with a receive timestamp ---
+ * There is no kernel to timestamp arriving packets in userspace, so the
+ * stamp is always zeroed.
+ */
+static inline ssize_t sctp_sys_recvmsg_stamped(sctp_sock_t fd, void* buf, size_t len,
+    struct sockaddr* from, socklen_t* fromlen,
+    struct sctp_sndrcvinfo* sinfo, int* msg_flags, struct timespec* stamp)
+{
+  memset(stamp, 0, sizeof(*stamp));
+  return sctp_sys_recvmsg(fd, buf, len, from, fromlen, sinfo, msg_flags);
+}
+
 #else
 
 /* =========================================================================
@@ -344,9 +405,168 @@ static inline void sctp_sys_global_init(void){}
 #define sctp_sys_freeladdrs  sctp_freeladdrs
 #define sctp_sys_opt_info    sctp_opt_info
 #define sctp_sys_sendv       sctp_sendv
-#define sctp_sys_recvv       sctp_recvv
 #define sctp_sys_send        sctp_send
-#define sctp_sys_recvmsg     sctp_recvmsg
+
+/*
+ * sctp_recvmsg and sctp_recvv size their control buffer for the SCTP
+ * ancillary data alone. Once SO_TIMESTAMPNS is on the kernel writes the
+ * timestamp ahead of it, and the SCTP data is cut off (MSG_CTRUNC). The
+ * receive wrappers below call recvmsg directly with room for both.
+ */
+#define SCTP_SYS_CONTROL_SIZE 256
+
+/* --- recvmsg with a receive timestamp ---
+ * Also picks up the kernel timestamp enabled with SO_TIMESTAMPNS, or
+ * SO_TIMESTAMP where that is all there is. The stamp is zeroed if the
+ * message didn't carry one.
+ */
+static inline ssize_t sctp_sys_recvmsg_stamped(sctp_sock_t fd, void* buf, size_t len,
+    struct sockaddr* from, socklen_t* fromlen,
+    struct sctp_sndrcvinfo* sinfo, int* msg_flags, struct timespec* stamp)
+{
+  union {
+    struct cmsghdr align;
+    char buf[SCTP_SYS_CONTROL_SIZE];
+  } control;
+  struct msghdr msg;
+  struct iovec iov;
+  struct cmsghdr* cmsg;
+  ssize_t n;
+
+  memset(stamp, 0, sizeof(*stamp));
+  memset(&msg, 0, sizeof(msg));
+
+  iov.iov_base = buf;
+  iov.iov_len = len;
+
+  msg.msg_name = from;
+  msg.msg_namelen = fromlen != NULL ? *fromlen : 0;
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof(control.buf);
+
+  n = recvmsg(fd, &msg, msg_flags != NULL ? *msg_flags : 0);
+
+  if(n < 0)
+    return n;
+
+  if(fromlen != NULL)
+    *fromlen = msg.msg_namelen;
+
+  if(msg_flags != NULL)
+    *msg_flags = msg.msg_flags;
+
+  for(cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)){
+    if(cmsg->cmsg_level == IPPROTO_SCTP && cmsg->cmsg_type == SCTP_SNDRCV){
+      if(sinfo != NULL)
+        memcpy(sinfo, CMSG_DATA(cmsg), sizeof(*sinfo));
+    }
+#ifdef SCM_TIMESTAMPNS
+    else if(cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS){
+      memcpy(stamp, CMSG_DATA(cmsg), sizeof(*stamp));
+    }
+#endif
+#ifdef SCM_TIMESTAMP
+    else if(cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMP){
+      struct timeval tv;
+      memcpy(&tv, CMSG_DATA(cmsg), sizeof(tv));
+      stamp->tv_sec = tv.tv_sec;
+      stamp->tv_nsec = tv.tv_usec * 1000;
+    }
+#endif
+  }
+
+  return n;
+}
+
+/* --- sctp_recvmsg wrapper ---
+ * Same as sctp_recvmsg, but safe with timestamps turned on.
+ */
+static inline ssize_t sctp_sys_recvmsg(sctp_sock_t fd, void* buf, size_t len,
+    struct sockaddr* from, socklen_t* fromlen,
+    struct sctp_sndrcvinfo* sinfo, int* msg_flags)
+{
+  struct timespec stamp;
+  return sctp_sys_recvmsg_stamped(fd, buf, len, from, fromlen, sinfo, msg_flags, &stamp);
+}
+
+/* --- sctp_recvv wrapper ---
+ * Same as sctp_recvv, but safe with timestamps turned on. The rcvinfo and
+ * nxtinfo are returned the same way, as an sctp_recvv_rn when both came.
+ */
+static inline ssize_t sctp_sys_recvv(sctp_sock_t fd, const struct iovec* iov, int iovcnt,
+    struct sockaddr* from, socklen_t* fromlen,
+    void* info, socklen_t* infolen, unsigned int* infotype, int* flags)
+{
+  union {
+    struct cmsghdr align;
+    char buf[SCTP_SYS_CONTROL_SIZE];
+  } control;
+  struct sctp_recvv_rn rn;
+  struct msghdr msg;
+  struct cmsghdr* cmsg;
+  int have_rcvinfo = 0;
+  int have_nxtinfo = 0;
+  ssize_t n;
+
+  memset(&msg, 0, sizeof(msg));
+
+  msg.msg_name = from;
+  msg.msg_namelen = fromlen != NULL ? *fromlen : 0;
+  msg.msg_iov = (struct iovec*)iov;
+  msg.msg_iovlen = iovcnt;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof(control.buf);
+
+  n = recvmsg(fd, &msg, flags != NULL ? *flags : 0);
+
+  if(n < 0)
+    return n;
+
+  if(fromlen != NULL)
+    *fromlen = msg.msg_namelen;
+
+  if(flags != NULL)
+    *flags = msg.msg_flags;
+
+  if(info == NULL || infolen == NULL || infotype == NULL)
+    return n;
+
+  for(cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)){
+    if(cmsg->cmsg_level != IPPROTO_SCTP)
+      continue;
+
+    if(cmsg->cmsg_type == SCTP_RCVINFO){
+      memcpy(&rn.recvv_rcvinfo, CMSG_DATA(cmsg), sizeof(rn.recvv_rcvinfo));
+      have_rcvinfo = 1;
+    }
+    else if(cmsg->cmsg_type == SCTP_NXTINFO){
+      memcpy(&rn.recvv_nxtinfo, CMSG_DATA(cmsg), sizeof(rn.recvv_nxtinfo));
+      have_nxtinfo = 1;
+    }
+  }
+
+  *infotype = SCTP_RECVV_NOINFO;
+
+  if(have_rcvinfo && have_nxtinfo && *infolen >= sizeof(rn)){
+    memcpy(info, &rn, sizeof(rn));
+    *infolen = sizeof(rn);
+    *infotype = SCTP_RECVV_RN;
+  }
+  else if(have_rcvinfo && *infolen >= sizeof(rn.recvv_rcvinfo)){
+    memcpy(info, &rn.recvv_rcvinfo, sizeof(rn.recvv_rcvinfo));
+    *infolen = sizeof(rn.recvv_rcvinfo);
+    *infotype = SCTP_RECVV_RCVINFO;
+  }
+  else if(have_nxtinfo && *infolen >= sizeof(rn.recvv_nxtinfo)){
+    memcpy(info, &rn.recvv_nxtinfo, sizeof(rn.recvv_nxtinfo));
+    *infolen = sizeof(rn.recvv_nxtinfo);
+    *infotype = SCTP_RECVV_NXTINFO;
+  }
+
+  return n;
+}
 
 /* --- sctp_sendmsg wrapper ---
  * Unified interface: always takes addrcnt (count), not byte length.
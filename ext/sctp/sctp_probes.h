@@ -0,0 +1,86 @@
+/*
+ * sctp_probes.h - Static tracepoints for the send, receive and notification
+ * paths.
+ *
+ * When sys/sdt.h (systemtap-sdt-dev / systemtap-sdt-devel) is available the
+ * probes are compiled in as USDT probes under the "sctp" provider. A probe
+ * that no tracer is attached to is a single nop, so they cost nothing in
+ * production. Without sys/sdt.h every macro expands to nothing and its
+ * arguments are never evaluated.
+ *
+ * Probes and their arguments:
+ *
+ *   sctp:send, sctp:sendmsg, sctp:sendv
+ *     fd, assoc_id, stream, ppid, bytes, errno
+ *   sctp:recvmsg, sctp:recvv
+ *     fd, assoc_id, stream, ppid, bytes, errno
+ *   sctp:notification
+ *     type, state, assoc_id, length
+ *
+ * The byte count is the return value of the underlying call, so it is -1
+ * when it failed, in which case errno is set. Otherwise errno is 0.
+ *
+ * Every probe has a semaphore that tracers raise while they are attached.
+ * SCTP_PROBE_ENABLED(name) tests it, so arguments that cost something to
+ * work out are only worked out while somebody is listening.
+ *
+ * Example:
+ *
+ *   bpftrace -e 'usdt:/path/to/sctp/socket.so:sctp:recvmsg
+ *     { @bytes[arg1] = sum(arg4); }'
+ */
+#ifndef SCTP_PROBES_H
+#define SCTP_PROBES_H
+
+#ifdef HAVE_SYS_SDT_H
+
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+
+#define SCTP_PROBE_SEMAPHORE(name) \
+  __extension__ unsigned short sctp_##name##_semaphore \
+  __attribute__((unused)) __attribute__((section(".probes")))
+
+SCTP_PROBE_SEMAPHORE(send);
+SCTP_PROBE_SEMAPHORE(sendmsg);
+SCTP_PROBE_SEMAPHORE(sendv);
+SCTP_PROBE_SEMAPHORE(recvmsg);
+SCTP_PROBE_SEMAPHORE(recvv);
+SCTP_PROBE_SEMAPHORE(notification);
+
+#define SCTP_PROBE_ENABLED(name) __builtin_expect(sctp_##name##_semaphore, 0)
+
+#define SCTP_PROBE_ERRNO(result) ((result) < 0 ? errno : 0)
+
+#define SCTP_PROBE_SEND(fd, assoc_id, stream, ppid, bytes) \
+  DTRACE_PROBE6(sctp, send, fd, assoc_id, stream, ppid, bytes, SCTP_PROBE_ERRNO(bytes))
+
+#define SCTP_PROBE_SENDMSG(fd, assoc_id, stream, ppid, bytes) \
+  DTRACE_PROBE6(sctp, sendmsg, fd, assoc_id, stream, ppid, bytes, SCTP_PROBE_ERRNO(bytes))
+
+#define SCTP_PROBE_SENDV(fd, assoc_id, stream, ppid, bytes) \
+  DTRACE_PROBE6(sctp, sendv, fd, assoc_id, stream, ppid, bytes, SCTP_PROBE_ERRNO(bytes))
+
+#define SCTP_PROBE_RECVMSG(fd, assoc_id, stream, ppid, bytes, err) \
+  DTRACE_PROBE6(sctp, recvmsg, fd, assoc_id, stream, ppid, bytes, err)
+
+#define SCTP_PROBE_RECVV(fd, assoc_id, stream, ppid, bytes, err) \
+  DTRACE_PROBE6(sctp, recvv, fd, assoc_id, stream, ppid, bytes, err)
+
+#define SCTP_PROBE_NOTIFICATION(type, state, assoc_id, length) \
+  DTRACE_PROBE4(sctp, notification, type, state, assoc_id, length)
+
+#else
+
+#define SCTP_PROBE_ENABLED(name) 0
+
+#define SCTP_PROBE_SEND(fd, assoc_id, stream, ppid, bytes)
+#define SCTP_PROBE_SENDMSG(fd, assoc_id, stream, ppid, bytes)
+#define SCTP_PROBE_SENDV(fd, assoc_id, stream, ppid, bytes)
+#define SCTP_PROBE_RECVMSG(fd, assoc_id, stream, ppid, bytes, err)
+#define SCTP_PROBE_RECVV(fd, assoc_id, stream, ppid, bytes, err)
+#define SCTP_PROBE_NOTIFICATION(type, state, assoc_id, length)
+
+#endif
+
+#endif
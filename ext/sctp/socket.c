@@ -2,36 +2,57 @@
 #include <ruby/thread.h>
 #include <string.h>
 #include <errno.h>
+#include <time.h>
 #include <arpa/inet.h>
 
 #ifdef HAVE_SYS_PARAM_H
 #include <sys/param.h>
 #endif
 
-#include "sctp_compat.h"
+#ifdef HAVE_RUBY_IO_BUFFER_H
+#include <ruby/io/buffer.h>
+#endif
 
-VALUE mSCTP;
-VALUE cSocket;
-VALUE v_sndrcv_struct;
-VALUE v_assoc_change_struct;
-VALUE v_peeraddr_change_struct;
-VALUE v_remote_error_struct;
-VALUE v_send_failed_event_struct;
-VALUE v_shutdown_event_struct;
-VALUE v_sndinfo_struct;
-VALUE v_adaptation_event_struct;
-VALUE v_partial_delivery_event_struct;
-VALUE v_auth_event_struct;
-VALUE v_sockaddr_in_struct;
-VALUE v_sctp_status_struct;
-VALUE v_sctp_rtoinfo_struct;
-VALUE v_sctp_associnfo_struct;
-VALUE v_sctp_default_send_params_struct;
-VALUE v_sctp_event_subscribe_struct;
-VALUE v_sctp_receive_info_struct;
-VALUE v_sctp_peer_addr_params_struct;
-VALUE v_sender_dry_event_struct;
-VALUE v_sctp_initmsg_struct;
+#include "sctp_compat.h"
+#include "sctp_probes.h"
+
+static VALUE mSCTP;
+static VALUE cSocket;
+static VALUE cSendParams;
+static VALUE cMessage;
+static VALUE v_sndrcv_struct;
+static VALUE v_sctp_stream_value_struct;
+static VALUE v_sctp_default_prinfo_struct;
+static VALUE v_sctp_prstatus_struct;
+static VALUE v_buffer_sizes_struct;
+static VALUE v_sctp_next_info_struct;
+static VALUE v_assoc_change_struct;
+static VALUE v_peeraddr_change_struct;
+static VALUE v_remote_error_struct;
+static VALUE v_send_failed_event_struct;
+static VALUE v_shutdown_event_struct;
+static VALUE v_sndinfo_struct;
+static VALUE v_adaptation_event_struct;
+static VALUE v_partial_delivery_event_struct;
+static VALUE v_auth_event_struct;
+static VALUE v_sockaddr_in_struct;
+static VALUE v_sctp_status_struct;
+static VALUE v_sctp_rtoinfo_struct;
+static VALUE v_sctp_associnfo_struct;
+static VALUE v_sctp_default_send_params_struct;
+static VALUE v_sctp_event_subscribe_struct;
+static VALUE v_sctp_receive_info_struct;
+static VALUE v_sctp_peer_addr_params_struct;
+static VALUE v_sctp_peer_addr_thresholds_struct;
+static VALUE v_sender_dry_event_struct;
+static VALUE v_stream_reset_event_struct;
+static VALUE v_assoc_reset_event_struct;
+static VALUE v_stream_change_event_struct;
+static VALUE v_sctp_initmsg_struct;
+static VALUE v_association_struct;
+static VALUE v_latency_struct;
+
+static ID id_call;
 
 #if !defined(IOV_MAX)
 #if defined(_SC_IOV_MAX)
@@ -131,9 +152,10 @@ static void set_any_address_v6(int port, struct sockaddr_in6* sin6){
  * @param addr Pointer to sockaddr_in structure
  * @return Ruby struct representing the socket address
  */
-VALUE convert_sockaddr_in_to_struct(struct sockaddr_in* addr){
+static VALUE convert_sockaddr_in_to_struct(struct sockaddr_in* addr){
   char ipbuf[IP_BUFFER_SIZE];
   const char* result;
+  unsigned short port;
 
   if(addr == NULL)
     rb_raise(rb_eArgError, "null address pointer");
@@ -151,2641 +173,6614 @@ VALUE convert_sockaddr_in_to_struct(struct sockaddr_in* addr){
   if(result == NULL)
     rb_raise(rb_eSystemCallError, "inet_ntop: %s", strerror(errno));
 
+  if(addr->sin_family == AF_INET6)
+    port = ntohs(((struct sockaddr_in6 *)addr)->sin6_port);
+  else
+    port = ntohs(addr->sin_port);
+
   return rb_struct_new(v_sockaddr_in_struct,
     INT2NUM(addr->sin_family),
-    INT2NUM(ntohs(addr->sin_port)),
+    INT2NUM(port),
     rb_str_new2(ipbuf)
   );
 }
 
+#define CLIENT_CACHE_MAX 16
+#define CLIENT_CACHE_ASSOCIATIONS 1024
+
 /*
-* Helper function to get a hash value via string or symbol key.
-* This provides Ruby's flexible hash access pattern.
+* Freeze an address string, deduplicating it where the interpreter
+* supports it, so that cached addresses can be handed out as is.
+*/
+static VALUE freeze_address_str(VALUE v_address){
+#ifdef HAVE_RB_STR_TO_INTERNED_STR
+  return rb_str_to_interned_str(v_address);
+#else
+  return rb_obj_freeze(v_address);
+#endif
+}
+
+/*
+* Return the frozen client address struct for a message received on the
+* given association.
 *
-* @param v_hash Ruby hash object
-* @param key String key to look up
-* @return Ruby value or Qnil if not found
+* Each association keeps a short list of the raw addresses it has received
+* from, alongside the struct built for each one, in a hidden hash on the
+* socket. A message from a known address costs a hash lookup and a memcmp,
+* and the address String is only built once. Address strings are also
+* deduplicated across associations where the interpreter supports it.
+*
+* Associations are normally dropped from the cache when they go away, but
+* that relies on association change notifications, so the cache is also
+* kept in least recently used order and bounded to CLIENT_CACHE_ASSOCIATIONS
+* associations.
+*
+* @param self The SCTP::Socket instance
+* @param assoc_id The association the message was received on
+* @param addr The source address filled in by the receive call
+* @param len The length of the source address
+* @return A frozen SockAddrIn struct, or nil if there was no source address
 */
-VALUE rb_hash_aref2(VALUE v_hash, const char* key){
-  VALUE v_key, v_val;
+static VALUE get_cached_client(VALUE self, sctp_assoc_t assoc_id, struct sockaddr_storage* addr, socklen_t len){
+  VALUE v_cache, v_entries, v_raw, v_client, v_address;
+  long i;
 
-  if(key == NULL)
+  if(len == 0 || len > sizeof(struct sockaddr_storage))
     return Qnil;
 
-  // Try a string key first
-  v_key = rb_str_new2(key);
-  v_val = rb_hash_aref(v_hash, v_key);
+  if(addr->ss_family != AF_INET && addr->ss_family != AF_INET6)
+    return Qnil;
 
-  // If not found, try a symbol key
-  if(NIL_P(v_val))
-    v_val = rb_hash_aref(v_hash, ID2SYM(rb_intern(key)));
+  v_cache = rb_attr_get(self, rb_intern("client_cache"));
 
-  return v_val;
+  if(NIL_P(v_cache)){
+    v_cache = rb_hash_new();
+    rb_ivar_set(self, rb_intern("client_cache"), v_cache);
+  }
+
+  // Hashes keep insertion order, so reinserting marks it most recently used
+  v_entries = rb_hash_delete(v_cache, INT2NUM(assoc_id));
+
+  if(NIL_P(v_entries)){
+    v_entries = rb_ary_new();
+
+    if(RHASH_SIZE(v_cache) >= CLIENT_CACHE_ASSOCIATIONS)
+      rb_funcall(v_cache, rb_intern("shift"), 0);
+  }
+
+  rb_hash_aset(v_cache, INT2NUM(assoc_id), v_entries);
+
+  for(i = 0; i + 1 < RARRAY_LEN(v_entries); i += 2){
+    v_raw = RARRAY_AREF(v_entries, i);
+
+    if(RSTRING_LEN(v_raw) == (long)len && memcmp(RSTRING_PTR(v_raw), addr, len) == 0)
+      return RARRAY_AREF(v_entries, i + 1);
+  }
+
+  v_client = convert_sockaddr_in_to_struct((struct sockaddr_in*)addr);
+  v_address = rb_struct_aref(v_client, INT2FIX(2));
+  rb_struct_aset(v_client, INT2FIX(2), freeze_address_str(v_address));
+  rb_obj_freeze(v_client);
+
+  // Multihomed peers only have a handful of addresses, so this rarely fills
+  if(RARRAY_LEN(v_entries) >= CLIENT_CACHE_MAX * 2)
+    rb_ary_clear(v_entries);
+
+  rb_ary_push(v_entries, rb_obj_freeze(rb_str_new((const char*)addr, len)));
+  rb_ary_push(v_entries, v_client);
+
+  return v_client;
 }
 
 /*
-* Parse and convert SCTP notification messages into Ruby structures.
-* This function handles various types of SCTP notifications.
+* Convert the packed address list returned by sctp_getpaddrs or
+* sctp_getladdrs into an array of address strings. The addresses are
+* packed back to back, so each one is as long as its own family requires.
 *
-* @param buffer Raw notification buffer from SCTP
-* @return Ruby struct representing the notification
+* @param addrs The address list
+* @param num_addrs The number of addresses in the list
+* @param frozen Whether to freeze the strings and the array
+* @return An array of address strings
 */
-VALUE get_notification_info(char* buffer){
-  uint32_t i;
+static VALUE convert_packed_addrs_to_array(struct sockaddr* addrs, int num_addrs, int frozen){
   char str[IP_BUFFER_SIZE];
-  union sctp_notification* snp;
-  VALUE v_notification = Qnil;
-  VALUE v_str = Qnil;
-  VALUE* v_temp;
+  char* p = (char*)addrs;
+  VALUE v_array = rb_ary_new_capa(num_addrs);
+  VALUE v_str;
+  int i;
 
-  if(buffer == NULL)
-    rb_raise(rb_eArgError, "notification buffer is null");
+  for(i = 0; i < num_addrs; i++){
+    struct sockaddr* sa = (struct sockaddr*)p;
+    bzero(&str, sizeof(str));
 
-  snp = (union sctp_notification*)buffer;
+    if(sa->sa_family == AF_INET6){
+      struct sockaddr_in6* sin6 = (struct sockaddr_in6*)sa;
+      inet_ntop(AF_INET6, &sin6->sin6_addr, str, sizeof(str));
+      p += sizeof(struct sockaddr_in6);
+    }
+    else{
+      struct sockaddr_in* sin = (struct sockaddr_in*)sa;
+      inet_ntop(AF_INET, &sin->sin_addr, str, sizeof(str));
+      p += sizeof(struct sockaddr_in);
+    }
+
+    v_str = rb_str_new2(str);
+    rb_ary_push(v_array, frozen ? freeze_address_str(v_str) : v_str);
+  }
+
+  if(frozen)
+    rb_obj_freeze(v_array);
+
+  return v_array;
+}
+
+/*
+* Remove everything cached for an association once it has gone away.
+*/
+static void forget_association(VALUE self, sctp_assoc_t assoc_id){
+  VALUE v_cache;
+
+  v_cache = rb_attr_get(self, rb_intern("peer_addresses"));
+
+  if(!NIL_P(v_cache))
+    rb_hash_delete(v_cache, INT2NUM(assoc_id));
+
+  v_cache = rb_attr_get(self, rb_intern("client_cache"));
+
+  if(!NIL_P(v_cache))
+    rb_hash_delete(v_cache, INT2NUM(assoc_id));
+}
+
+#define LATENCY_SUB_BUCKETS 16
+#define LATENCY_BUCKETS (LATENCY_SUB_BUCKETS * 46)
+
+/*
+* A log-linear latency histogram in nanoseconds, in the style of an HDR
+* histogram. Values below 32ns get a bucket each, and every power of two
+* above that is split into 16 buckets, so a recorded value is off by at
+* most about 6% whatever its magnitude. Recording is a few shifts and an
+* increment.
+*/
+typedef struct {
+  uint64_t counts[LATENCY_BUCKETS];
+  uint64_t count;
+  uint64_t min;
+  uint64_t max;
+  double total;
+} sctp_histogram_t;
+
+/*
+* The latency histograms of a socket, allocated when timestamps are
+* turned on. The receive histogram holds the time from kernel arrival to
+* the receive method returning, and the send histogram the time spent in
+* the send call.
+*/
+typedef struct {
+  sctp_histogram_t receive;
+  sctp_histogram_t send;
+} sctp_latency_t;
+
+static size_t latency_memsize(const void* ptr){
+  return sizeof(sctp_latency_t);
+}
+
+static const rb_data_type_t latency_type = {
+  .wrap_struct_name = "SCTP::Latency",
+  .function = {
+    .dmark = NULL,
+    .dfree = RUBY_TYPED_DEFAULT_FREE,
+    .dsize = latency_memsize,
+  },
+  .flags = RUBY_TYPED_FREE_IMMEDIATELY
+};
+
+/*
+* Return the latency histograms of a socket, or NULL if timestamps are off.
+*/
+static sctp_latency_t* get_latency(VALUE self){
+  VALUE v_latency = rb_attr_get(self, rb_intern("latency"));
+
+  if(NIL_P(v_latency))
+    return NULL;
+
+  return (sctp_latency_t*)rb_check_typeddata(v_latency, &latency_type);
+}
+
+static int latency_bucket(uint64_t ns){
+  int shift = 0;
+  int index;
+
+  if(ns < LATENCY_SUB_BUCKETS * 2)
+    return (int)ns;
+
+  while((ns >> shift) >= LATENCY_SUB_BUCKETS * 2)
+    shift++;
+
+  index = LATENCY_SUB_BUCKETS * (shift + 1) + (int)((ns >> shift) - LATENCY_SUB_BUCKETS);
+
+  return index < LATENCY_BUCKETS ? index : LATENCY_BUCKETS - 1;
+}
+
+/*
+* Returns the highest value that falls in a bucket.
+*/
+static uint64_t latency_bucket_value(int index){
+  int shift;
+  uint64_t mantissa;
+
+  if(index < LATENCY_SUB_BUCKETS * 2)
+    return (uint64_t)index;
+
+  shift = index / LATENCY_SUB_BUCKETS - 1;
+  mantissa = LATENCY_SUB_BUCKETS + index % LATENCY_SUB_BUCKETS;
+
+  return ((mantissa + 1) << shift) - 1;
+}
+
+static void record_latency(sctp_histogram_t* histogram, uint64_t ns){
+  histogram->counts[latency_bucket(ns)]++;
+
+  if(histogram->count == 0 || ns < histogram->min)
+    histogram->min = ns;
+
+  if(ns > histogram->max)
+    histogram->max = ns;
+
+  histogram->count++;
+  histogram->total += (double)ns;
+}
+
+/*
+* Record the time elapsed since +start+ on the given clock.
+*/
+static void record_latency_since(sctp_histogram_t* histogram, clockid_t clock, const struct timespec* start){
+  struct timespec now;
+  int64_t ns;
+
+  clock_gettime(clock, &now);
+
+  ns = (int64_t)(now.tv_sec - start->tv_sec) * 1000000000 + (now.tv_nsec - start->tv_nsec);
+
+  // A realtime clock step could make this negative
+  if(ns >= 0)
+    record_latency(histogram, (uint64_t)ns);
+}
+
+/*
+* Returns the value in nanoseconds below which the given percentage of the
+* recorded values fall.
+*/
+static uint64_t latency_percentile(const sctp_histogram_t* histogram, double percent){
+  uint64_t target, seen = 0;
+  uint64_t value;
+  int i;
+
+  if(histogram->count == 0)
+    return 0;
+
+  target = (uint64_t)((percent / 100.0) * (double)histogram->count + 0.5);
+
+  if(target < 1)
+    target = 1;
+
+  for(i = 0; i < LATENCY_BUCKETS; i++){
+    seen += histogram->counts[i];
+
+    if(seen >= target){
+      value = latency_bucket_value(i);
+      return value < histogram->max ? value : histogram->max;
+    }
+  }
+
+  return histogram->max;
+}
+
+// Member offsets of the Association struct
+#define ASSOCIATION_STATE           1
+#define ASSOCIATION_OUTBOUND        2
+#define ASSOCIATION_INBOUND         3
+#define ASSOCIATION_PEER_ADDRESSES  4
+#define ASSOCIATION_LAST_ACTIVITY   5
+#define ASSOCIATION_PENDING         6
+
+/*
+* Return the current monotonic time in seconds as a Float.
+*/
+static VALUE monotonic_time(void){
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return DBL2NUM((double)ts.tv_sec + (double)ts.tv_nsec / 1e9);
+}
+
+/*
+* Return the entry for an association in the socket's association table,
+* or nil if the table is disabled or has no entry for it.
+*/
+static VALUE get_association_entry(VALUE self, sctp_assoc_t assoc_id){
+  VALUE v_table = rb_attr_get(self, rb_intern("associations"));
+
+  if(NIL_P(v_table))
+    return Qnil;
+
+  return rb_hash_lookup(v_table, INT2NUM(assoc_id));
+}
+
+/*
+* Record that a data message was received on an association.
+*/
+static void track_activity(VALUE self, sctp_assoc_t assoc_id){
+  VALUE v_entry = get_association_entry(self, assoc_id);
+
+  if(!NIL_P(v_entry))
+    rb_struct_aset(v_entry, INT2FIX(ASSOCIATION_LAST_ACTIVITY), monotonic_time());
+}
+
+/*
+* Record the bytes sent on an association. They are counted as pending
+* until the association reports that the sender is dry.
+*/
+static void track_sent(VALUE self, sctp_assoc_t assoc_id, ssize_t bytes){
+  VALUE v_entry = get_association_entry(self, assoc_id);
+  VALUE v_pending;
+
+  if(NIL_P(v_entry))
+    return;
+
+  v_pending = rb_struct_aref(v_entry, INT2FIX(ASSOCIATION_PENDING));
+  rb_struct_aset(v_entry, INT2FIX(ASSOCIATION_PENDING), LL2NUM(NUM2LL(v_pending) + bytes));
+}
+
+/*
+* Update the association table, if enabled, from a notification. This runs
+* after the peer address cache has been updated, so that an entry can share
+* its frozen address array.
+*/
+static void update_association_table(VALUE self, const union sctp_notification* snp){
+  VALUE v_table, v_entry, v_cache, v_addresses;
+  sctp_assoc_t assoc_id;
+
+  v_table = rb_attr_get(self, rb_intern("associations"));
+
+  if(NIL_P(v_table))
+    return;
 
   switch(snp->sn_header.sn_type){
     case SCTP_ASSOC_CHANGE:
+      assoc_id = snp->sn_assoc_change.sac_assoc_id;
+
       switch(snp->sn_assoc_change.sac_state){
-        case SCTP_COMM_LOST:
-          v_str = rb_str_new2("comm lost");
-          break;
         case SCTP_COMM_UP:
-          v_str = rb_str_new2("comm up");
-          break;
         case SCTP_RESTART:
-          v_str = rb_str_new2("restart");
+          v_cache = rb_attr_get(self, rb_intern("peer_addresses"));
+          v_addresses = NIL_P(v_cache) ? Qnil : rb_hash_lookup(v_cache, INT2NUM(assoc_id));
+
+          v_entry = rb_struct_new(v_association_struct,
+            INT2NUM(assoc_id),
+            INT2NUM(SCTP_ESTABLISHED),
+            UINT2NUM(snp->sn_assoc_change.sac_outbound_streams),
+            UINT2NUM(snp->sn_assoc_change.sac_inbound_streams),
+            v_addresses,
+            monotonic_time(),
+            INT2FIX(0)
+          );
+
+          rb_hash_aset(v_table, INT2NUM(assoc_id), v_entry);
           break;
+        case SCTP_COMM_LOST:
         case SCTP_SHUTDOWN_COMP:
-          v_str = rb_str_new2("shutdown complete");
-          break;
         case SCTP_CANT_STR_ASSOC:
-          v_str = rb_str_new2("association setup failed");
+          rb_hash_delete(v_table, INT2NUM(assoc_id));
           break;
-        default:
-          v_str = rb_str_new2("unknown");
       }
-
-      v_notification = rb_struct_new(v_assoc_change_struct,
-        UINT2NUM(snp->sn_assoc_change.sac_type),
-        UINT2NUM(snp->sn_assoc_change.sac_length),
-        UINT2NUM(snp->sn_assoc_change.sac_state),
-        UINT2NUM(snp->sn_assoc_change.sac_error),
-        UINT2NUM(snp->sn_assoc_change.sac_outbound_streams),
-        UINT2NUM(snp->sn_assoc_change.sac_inbound_streams),
-        UINT2NUM(snp->sn_assoc_change.sac_assoc_id),
-        v_str
-      );
       break;
     case SCTP_PEER_ADDR_CHANGE:
-      switch(snp->sn_paddr_change.spc_state){
-        case SCTP_ADDR_AVAILABLE:
-          v_str = rb_str_new2("available");
-          break;
-        case SCTP_ADDR_UNREACHABLE:
-          v_str = rb_str_new2("unreachable");
-          break;
-        case SCTP_ADDR_REMOVED:
-          v_str = rb_str_new2("removed from association");
-          break;
-        case SCTP_ADDR_ADDED:
-          v_str = rb_str_new2("added to association");
-          break;
-        case SCTP_ADDR_MADE_PRIM:
-          v_str = rb_str_new2("primary destination");
-          break;
-        default:
-          v_str = rb_str_new2("unknown");
-      }
+      assoc_id = snp->sn_paddr_change.spc_assoc_id;
+      v_entry = rb_hash_lookup(v_table, INT2NUM(assoc_id));
 
-      {
-        struct sockaddr* sa = (struct sockaddr*)&snp->sn_paddr_change.spc_aaddr;
+      if(!NIL_P(v_entry)){
+        v_cache = rb_attr_get(self, rb_intern("peer_addresses"));
 
-        if(sa->sa_family == AF_INET6){
-          struct sockaddr_in6* sin6 = (struct sockaddr_in6*)sa;
-          inet_ntop(AF_INET6, &sin6->sin6_addr, str, sizeof(str));
-        }
-        else{
-          struct sockaddr_in* sin = (struct sockaddr_in*)sa;
-          inet_ntop(AF_INET, &sin->sin_addr, str, sizeof(str));
-        }
+        if(!NIL_P(v_cache))
+          rb_struct_aset(v_entry, INT2FIX(ASSOCIATION_PEER_ADDRESSES), rb_hash_lookup(v_cache, INT2NUM(assoc_id)));
+
+        rb_struct_aset(v_entry, INT2FIX(ASSOCIATION_LAST_ACTIVITY), monotonic_time());
       }
+      break;
+    case SCTP_SHUTDOWN_EVENT:
+      v_entry = rb_hash_lookup(v_table, INT2NUM(snp->sn_shutdown_event.sse_assoc_id));
 
-      v_notification = rb_struct_new(v_peeraddr_change_struct,
-        UINT2NUM(snp->sn_paddr_change.spc_type),
-        UINT2NUM(snp->sn_paddr_change.spc_length),
-        rb_str_new2(str),
-        UINT2NUM(snp->sn_paddr_change.spc_state),
-        UINT2NUM(snp->sn_paddr_change.spc_error),
-        UINT2NUM(snp->sn_paddr_change.spc_assoc_id),
-        v_str
-      );
+      if(!NIL_P(v_entry)){
+        rb_struct_aset(v_entry, INT2FIX(ASSOCIATION_STATE), INT2NUM(SCTP_SHUTDOWN_RECEIVED));
+        rb_struct_aset(v_entry, INT2FIX(ASSOCIATION_LAST_ACTIVITY), monotonic_time());
+      }
       break;
-    case SCTP_REMOTE_ERROR:
-      {
-        size_t data_len = 0;
-        VALUE v_data_ary;
+    case SCTP_SENDER_DRY_EVENT:
+      v_entry = rb_hash_lookup(v_table, INT2NUM(snp->sn_sender_dry_event.sender_dry_assoc_id));
 
-        // Calculate actual data length (total length minus fixed header)
-        if(snp->sn_remote_error.sre_length > offsetof(struct sctp_remote_error, sre_data))
-          data_len = snp->sn_remote_error.sre_length - offsetof(struct sctp_remote_error, sre_data);
+      if(!NIL_P(v_entry)){
+        rb_struct_aset(v_entry, INT2FIX(ASSOCIATION_PENDING), INT2FIX(0));
+        rb_struct_aset(v_entry, INT2FIX(ASSOCIATION_LAST_ACTIVITY), monotonic_time());
+      }
+      break;
+  }
+}
 
-        // Bounds check to prevent stack overflow
-        if(data_len > MAX_NOTIFICATION_DATA)
-          data_len = MAX_NOTIFICATION_DATA;
+#ifdef HAVE_SYS_SDT_H
+/*
+* Fires the sctp:notification probe with the type, state and association of
+* a notification. The state is only meaningful for association and peer
+* address changes, and is 0 otherwise, as is the association id of
+* notification types that are not listed here.
+*
+* @param snp The raw notification
+*/
+static void probe_notification(const union sctp_notification* snp){
+  uint32_t state = 0;
+  sctp_assoc_t assoc_id = 0;
 
-        if(data_len > 0){
-          v_temp = ALLOCA_N(VALUE, data_len);
-          for(i = 0; i < data_len; i++){
-            v_temp[i] = UINT2NUM(snp->sn_remote_error.sre_data[i]);
-          }
-          v_data_ary = rb_ary_new4(data_len, v_temp);
-        }
-        else{
-          v_data_ary = rb_ary_new();
+  switch(snp->sn_header.sn_type){
+    case SCTP_ASSOC_CHANGE:
+      state = snp->sn_assoc_change.sac_state;
+      assoc_id = snp->sn_assoc_change.sac_assoc_id;
+      break;
+    case SCTP_PEER_ADDR_CHANGE:
+      state = snp->sn_paddr_change.spc_state;
+      assoc_id = snp->sn_paddr_change.spc_assoc_id;
+      break;
+    case SCTP_REMOTE_ERROR:
+      assoc_id = snp->sn_remote_error.sre_assoc_id;
+      break;
+    case SCTP_SHUTDOWN_EVENT:
+      assoc_id = snp->sn_shutdown_event.sse_assoc_id;
+      break;
+    case SCTP_ADAPTATION_INDICATION:
+      assoc_id = snp->sn_adaptation_event.sai_assoc_id;
+      break;
+    case SCTP_PARTIAL_DELIVERY_EVENT:
+      assoc_id = snp->sn_pdapi_event.pdapi_assoc_id;
+      break;
+    case SCTP_SENDER_DRY_EVENT:
+      assoc_id = snp->sn_sender_dry_event.sender_dry_assoc_id;
+      break;
+  }
+
+  SCTP_PROBE_NOTIFICATION(snp->sn_header.sn_type, state, assoc_id, snp->sn_header.sn_length);
+}
+#endif
+
+/*
+* Returns whether a notification was received whole. A notification that
+* does not fit the receive buffer arrives in pieces, and none of them can
+* be decoded on its own.
+*
+* @param buffer The raw notification
+* @param bytes The number of bytes received into the buffer
+* @param msg_flags The flags returned by the receive call
+* @return 1 if the whole notification is in the buffer, 0 if not
+*/
+static int notification_complete(const char* buffer, ssize_t bytes, int msg_flags){
+  const union sctp_notification* snp = (const union sctp_notification*)buffer;
+
+  if(!(msg_flags & MSG_EOR))
+    return 0;
+
+  if(bytes < (ssize_t)sizeof(snp->sn_header))
+    return 0;
+
+  return bytes >= (ssize_t)snp->sn_header.sn_length;
+}
+
+/*
+* Update the per-association caches from a notification that was just
+* received, before it is handed to the caller.
+*
+* Once the peer address cache is in use, i.e. SCTP::Socket#peer_addresses
+* has been called or the association table is on, the peer addresses of an
+* association are looked up when it comes up or restarts, and kept in a
+* hidden hash on the socket as a frozen array. Address added and removed
+* events replace that array, and the association is dropped from every
+* cache when it is lost or shut down.
+*
+* This is also where the sctp:notification probe fires, so it sees the
+* notifications that the filter goes on to swallow. Notifications that were
+* not received whole are ignored.
+*
+* @param self The SCTP::Socket instance
+* @param buffer The raw notification
+* @param bytes The number of bytes received into the buffer
+* @param msg_flags The flags returned by the receive call
+*/
+static void track_notification(VALUE self, const char* buffer, ssize_t bytes, int msg_flags){
+  const union sctp_notification* snp = (const union sctp_notification*)buffer;
+  VALUE v_cache, v_addresses;
+  sctp_assoc_t assoc_id;
+
+  if(!notification_complete(buffer, bytes, msg_flags))
+    return;
+
+#ifdef HAVE_SYS_SDT_H
+  probe_notification(snp);
+#endif
+
+  switch(snp->sn_header.sn_type){
+    case SCTP_ASSOC_CHANGE:
+      assoc_id = snp->sn_assoc_change.sac_assoc_id;
+
+      switch(snp->sn_assoc_change.sac_state){
+        case SCTP_COMM_UP:
+        case SCTP_RESTART:
+          {
+            struct sockaddr* addrs = NULL;
+            sctp_sock_t fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+            int num_addrs;
+
+            forget_association(self, assoc_id);
+
+            v_cache = rb_attr_get(self, rb_intern("peer_addresses"));
+
+            // Don't pay for sctp_getpaddrs until something uses the cache
+            if(NIL_P(v_cache)){
+              if(NIL_P(rb_attr_get(self, rb_intern("associations"))))
+                break;
+
+              v_cache = rb_hash_new();
+              rb_ivar_set(self, rb_intern("peer_addresses"), v_cache);
+            }
+
+            num_addrs = sctp_sys_getpaddrs(fileno, assoc_id, &addrs);
+
+            if(num_addrs > 0)
+              rb_hash_aset(v_cache, INT2NUM(assoc_id), convert_packed_addrs_to_array(addrs, num_addrs, 1));
+
+            if(addrs != NULL)
+              sctp_sys_freepaddrs(addrs);
+          }
+          break;
+        case SCTP_COMM_LOST:
+        case SCTP_SHUTDOWN_COMP:
+        case SCTP_CANT_STR_ASSOC:
+          forget_association(self, assoc_id);
+          break;
+      }
+      break;
+    case SCTP_PEER_ADDR_CHANGE:
+      {
+        char str[IP_BUFFER_SIZE];
+        const struct sockaddr* sa = (const struct sockaddr*)&snp->sn_paddr_change.spc_aaddr;
+        VALUE v_str;
+
+        if((size_t)bytes < sizeof(struct sctp_paddr_change))
+          break;
+
+        if(snp->sn_paddr_change.spc_state != SCTP_ADDR_ADDED && snp->sn_paddr_change.spc_state != SCTP_ADDR_REMOVED)
+          break;
+
+        v_cache = rb_attr_get(self, rb_intern("peer_addresses"));
+
+        if(NIL_P(v_cache))
+          break;
+
+        assoc_id = snp->sn_paddr_change.spc_assoc_id;
+        v_addresses = rb_hash_lookup(v_cache, INT2NUM(assoc_id));
+
+        if(NIL_P(v_addresses))
+          break;
+
+        bzero(&str, sizeof(str));
+
+        if(sa->sa_family == AF_INET6)
+          inet_ntop(AF_INET6, &((const struct sockaddr_in6*)sa)->sin6_addr, str, sizeof(str));
+        else
+          inet_ntop(AF_INET, &((const struct sockaddr_in*)sa)->sin_addr, str, sizeof(str));
+
+        v_str = freeze_address_str(rb_str_new2(str));
+
+        // The cached array is frozen and may be in use, so replace it
+        v_addresses = rb_ary_dup(v_addresses);
+        rb_ary_delete(v_addresses, v_str);
+
+        if(snp->sn_paddr_change.spc_state == SCTP_ADDR_ADDED)
+          rb_ary_push(v_addresses, v_str);
+
+        rb_hash_aset(v_cache, INT2NUM(assoc_id), rb_obj_freeze(v_addresses));
+      }
+      break;
+  }
+
+  update_association_table(self, snp);
+}
+
+#define NOTIFICATION_SLOTS 32
+#define NOTIFICATION_INDEX(type) ((type) & (NOTIFICATION_SLOTS - 1))
+#define NOTIFICATION_ALL_STATES 0xffffffffU
+#define COALESCE_SLOTS 32
+
+/*
+* The native notification filter. Each notification type, reduced to an
+* index, has a mask of the states that are let through. A type with an empty
+* mask is swallowed. The last state seen for recent peer addresses is kept
+* so that repeated address change events can be coalesced.
+*/
+typedef struct {
+  uint32_t allowed[NOTIFICATION_SLOTS];
+  int coalesce;
+  unsigned long filtered;
+  int next_slot;
+  struct {
+    int used;
+    sctp_assoc_t assoc_id;
+    uint32_t state;
+    struct sockaddr_storage addr;
+  } last_address[COALESCE_SLOTS];
+} sctp_notification_filter_t;
+
+static size_t notification_filter_memsize(const void* ptr){
+  return sizeof(sctp_notification_filter_t);
+}
+
+static const rb_data_type_t notification_filter_type = {
+  .wrap_struct_name = "SCTP::NotificationFilter",
+  .function = {
+    .dmark = NULL,
+    .dfree = RUBY_TYPED_DEFAULT_FREE,
+    .dsize = notification_filter_memsize,
+  },
+  .flags = RUBY_TYPED_FREE_IMMEDIATELY
+};
+
+/*
+* The notification types that can be filtered, by the same names that
+* SCTP::Socket#subscribe uses.
+*/
+static const struct {
+  const char* name;
+  uint16_t type;
+} notification_names[] = {
+  {"association",      SCTP_ASSOC_CHANGE},
+  {"address",          SCTP_PEER_ADDR_CHANGE},
+  {"send_failure",     SCTP_SEND_FAILED},
+#ifdef SCTP_SEND_FAILED_EVENT
+  {"send_failure",     SCTP_SEND_FAILED_EVENT},
+#endif
+  {"peer_error",       SCTP_REMOTE_ERROR},
+  {"shutdown",         SCTP_SHUTDOWN_EVENT},
+  {"partial_delivery", SCTP_PARTIAL_DELIVERY_EVENT},
+  {"adaptation_layer", SCTP_ADAPTATION_INDICATION},
+  {"authentication",   SCTP_AUTHENTICATION_EVENT},
+  {"sender_dry",       SCTP_SENDER_DRY_EVENT},
+#ifdef SCTP_STREAM_RESET_EVENT
+  {"stream_reset",     SCTP_STREAM_RESET_EVENT},
+#endif
+#ifdef SCTP_ASSOC_RESET_EVENT
+  {"assoc_reset",      SCTP_ASSOC_RESET_EVENT},
+#endif
+#ifdef SCTP_STREAM_CHANGE_EVENT
+  {"stream_change",    SCTP_STREAM_CHANGE_EVENT},
+#endif
+};
+
+/*
+* Returns the length of the meaningful part of a peer address.
+*/
+static size_t peer_address_length(const struct sockaddr_storage* addr){
+  return addr->ss_family == AF_INET6 ? sizeof(struct sockaddr_in6) : sizeof(struct sockaddr_in);
+}
+
+/*
+* Record the state of a peer address and return whether it is the same as
+* the last state seen for it, i.e. whether the event is a repeat.
+*/
+static int coalesce_address_change(sctp_notification_filter_t* filter, const char* buffer){
+  struct sctp_paddr_change change;
+  struct sockaddr_storage addr;
+  size_t len;
+  int i, repeat;
+
+  // The notification is packed, so copy it out before using the address
+  memcpy(&change, buffer, sizeof(change));
+  memcpy(&addr, buffer + offsetof(struct sctp_paddr_change, spc_aaddr), sizeof(addr));
+  len = peer_address_length(&addr);
+
+  for(i = 0; i < COALESCE_SLOTS; i++){
+    if(!filter->last_address[i].used || filter->last_address[i].assoc_id != change.spc_assoc_id)
+      continue;
+
+    if(memcmp(&filter->last_address[i].addr, &addr, len) == 0){
+      repeat = filter->last_address[i].state == change.spc_state;
+      filter->last_address[i].state = change.spc_state;
+      return repeat;
+    }
+  }
+
+  i = filter->next_slot;
+  filter->next_slot = (filter->next_slot + 1) % COALESCE_SLOTS;
+
+  bzero(&filter->last_address[i], sizeof(filter->last_address[i]));
+  filter->last_address[i].used = 1;
+  filter->last_address[i].assoc_id = change.spc_assoc_id;
+  filter->last_address[i].state = change.spc_state;
+  memcpy(&filter->last_address[i].addr, &addr, len);
+
+  return 0;
+}
+
+/*
+* Returns whether a notification that was just received should be swallowed
+* rather than returned, according to the socket's notification filter.
+* Swallowed notifications are only counted. This runs after
+* track_notification, so the caches see every notification. Notifications
+* that were not received whole are never swallowed.
+*
+* @param self The SCTP::Socket instance
+* @param buffer The raw notification
+* @param bytes The number of bytes received into the buffer
+* @param msg_flags The flags returned by the receive call
+* @return 1 if the notification should be swallowed, 0 if not
+*/
+static int notification_filtered(VALUE self, const char* buffer, ssize_t bytes, int msg_flags){
+  const union sctp_notification* snp = (const union sctp_notification*)buffer;
+  sctp_notification_filter_t* filter;
+  VALUE v_filter;
+  uint32_t state;
+  int i;
+
+  v_filter = rb_attr_get(self, rb_intern("notification_filter"));
+
+  if(NIL_P(v_filter))
+    return 0;
+
+  if(!notification_complete(buffer, bytes, msg_flags))
+    return 0;
+
+  filter = (sctp_notification_filter_t*)rb_check_typeddata(v_filter, &notification_filter_type);
+
+  switch(snp->sn_header.sn_type){
+    case SCTP_ASSOC_CHANGE:
+      state = snp->sn_assoc_change.sac_state;
+
+      // Forget the coalescing state of associations that have gone away
+      if(state == SCTP_COMM_LOST || state == SCTP_SHUTDOWN_COMP){
+        for(i = 0; i < COALESCE_SLOTS; i++){
+          if(filter->last_address[i].assoc_id == snp->sn_assoc_change.sac_assoc_id)
+            filter->last_address[i].used = 0;
         }
+      }
+      break;
+    case SCTP_PEER_ADDR_CHANGE:
+      state = snp->sn_paddr_change.spc_state;
+
+      if(filter->coalesce && (size_t)bytes >= sizeof(struct sctp_paddr_change) && coalesce_address_change(filter, buffer)){
+        filter->filtered++;
+        return 1;
+      }
+      break;
+    default:
+      state = 0;
+  }
+
+  if(state < 32 && (filter->allowed[NOTIFICATION_INDEX(snp->sn_header.sn_type)] & (1U << state)))
+    return 0;
+
+  filter->filtered++;
+
+  return 1;
+}
+
+/*
+* Helper function to get a hash value via string or symbol key.
+* This provides Ruby's flexible hash access pattern.
+*
+* @param v_hash Ruby hash object
+* @param key String key to look up
+* @return Ruby value or Qnil if not found
+*/
+static VALUE rb_hash_aref2(VALUE v_hash, const char* key){
+  VALUE v_key, v_val;
+
+  if(key == NULL)
+    return Qnil;
+
+  // Try a string key first
+  v_key = rb_str_new2(key);
+  v_val = rb_hash_aref(v_hash, v_key);
+
+  // If not found, try a symbol key
+  if(NIL_P(v_val))
+    v_val = rb_hash_aref(v_hash, ID2SYM(rb_intern(key)));
+
+  return v_val;
+}
+
+#ifdef HAVE_USRSCTP_H
+/*
+* Return a pointer to a per-socket scratch buffer of at least +len+ bytes.
+*
+* usrsctp_sendv only accepts a flat buffer, so multi-part messages must be
+* gathered before sending. Rather than malloc and free a buffer on every
+* call, we keep a hidden String on the socket and grow it as needed. It
+* is never shrunk, so after warm up there are no further allocations.
+*
+* @param self The SCTP::Socket instance
+* @param len The number of bytes required
+* @return Pointer to the start of the buffer
+*/
+static char* get_gather_buffer(VALUE self, size_t len){
+  VALUE v_buffer = rb_attr_get(self, rb_intern("gather_buffer"));
+
+  if(NIL_P(v_buffer)){
+    v_buffer = rb_str_buf_new((long)len);
+    rb_ivar_set(self, rb_intern("gather_buffer"), v_buffer);
+  }
+
+  rb_str_modify_expand(v_buffer, (long)len);
+
+  return RSTRING_PTR(v_buffer);
+}
+#endif
+
+/*
+* Enable SCTP_RECVRCVINFO on the socket, unless it has been already.
+*
+* Receive calls need the rcvinfo for every message, but the option only
+* has to be set once per socket. Whether it has been is tracked in a
+* hidden instance variable, so the common case costs no system call.
+*
+* @param self The SCTP::Socket instance
+* @param fileno The socket descriptor
+*/
+static void enable_recv_rcvinfo(VALUE self, sctp_sock_t fileno){
+  int on = 1;
+
+  if(RTEST(rb_attr_get(self, rb_intern("recv_rcvinfo"))))
+    return;
+
+  if(sctp_sys_setsockopt(fileno, IPPROTO_SCTP, SCTP_RECVRCVINFO, &on, sizeof(on)) < 0)
+    rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
+
+  rb_ivar_set(self, rb_intern("recv_rcvinfo"), Qtrue);
+}
+
+/*
+* Helper function to get a pointer to a message payload and its length.
+*
+* The payload may be a String or, on Ruby 3.2 or later, an IO::Buffer. The
+* optional offset and length select a portion of the payload without copying
+* it. If no length is given, everything from the offset onward is used.
+*
+* Payloads are treated as binary data. The pointer is taken together with the
+* explicit length rather than as a C string, so embedded NUL bytes are sent
+* as-is and the payload is never scanned. Plain strings, by far the common
+* case, are checked first so they never pay for the IO::Buffer class check.
+*
+* @param v_msg The message payload, a String or IO::Buffer
+* @param v_offset Ruby integer offset into the payload, or nil
+* @param v_length Ruby integer length of the payload, or nil
+* @param len Set to the number of bytes to send
+* @return Pointer to the first byte to send
+*/
+static const char* get_payload(VALUE v_msg, VALUE v_offset, VALUE v_length, size_t* len){
+  const char* ptr;
+  size_t size;
+  long offset = 0;
+  long length;
+
+  if(RB_TYPE_P(v_msg, T_STRING)){
+    ptr = RSTRING_PTR(v_msg);
+    size = RSTRING_LEN(v_msg);
+  }
+#ifdef HAVE_RB_IO_BUFFER_GET_BYTES_FOR_READING
+  else if(rb_obj_is_kind_of(v_msg, rb_cIOBuffer)){
+    const void* base;
+    rb_io_buffer_get_bytes_for_reading(v_msg, &base, &size);
+    ptr = (const char*)base;
+  }
+#endif
+  else{
+    StringValue(v_msg);
+    ptr = RSTRING_PTR(v_msg);
+    size = RSTRING_LEN(v_msg);
+  }
+
+  if(!NIL_P(v_offset)){
+    offset = NUM2LONG(v_offset);
+
+    if(offset < 0 || (size_t)offset > size)
+      rb_raise(rb_eArgError, "offset is out of range");
+  }
+
+  if(NIL_P(v_length)){
+    length = (long)size - offset;
+  }
+  else{
+    length = NUM2LONG(v_length);
+
+    if(length < 0 || (size_t)(offset + length) > size)
+      rb_raise(rb_eArgError, "length is out of range");
+  }
+
+  *len = (size_t)length;
+
+  return ptr + offset;
+}
+
+/*
+* Helper function that converts a partial reliability policy, raising an
+* ArgumentError if it isn't one of the SCTP_PR_SCTP_* values. The policy
+* values are the same in the send flags and in an sctp_prinfo.
+*
+* @param v_policy The policy passed by the caller
+* @return The policy
+*/
+static uint32_t get_pr_policy(VALUE v_policy){
+  uint32_t policy = NUM2UINT(v_policy);
+
+  if(policy & ~SCTP_PR_SCTP_MASK)
+    rb_raise(rb_eArgError, "invalid pr_policy: %u", policy);
+
+  return policy;
+}
+
+/*
+* Helper function that applies the :pr_policy and :pr_value options, if
+* present, to the flags and ttl used by send and sendmsg.
+*
+* The PR-SCTP policy is carried in the flags, and the ttl field holds the
+* policy value, i.e. a lifetime in milliseconds for SCTP_PR_SCTP_TTL, or
+* a retransmission limit for SCTP_PR_SCTP_RTX.
+*
+* @param v_options The options hash passed to send or sendmsg
+* @param flags The send flags, updated in place
+* @param ttl The time to live, updated in place
+*/
+static void apply_pr_options(VALUE v_options, uint32_t* flags, uint32_t* ttl){
+  VALUE v_policy = rb_hash_aref2(v_options, "pr_policy");
+  VALUE v_value = rb_hash_aref2(v_options, "pr_value");
+  uint32_t policy;
+
+  if(NIL_P(v_policy))
+    return;
+
+  policy = get_pr_policy(v_policy);
+
+  *flags &= ~SCTP_PR_SCTP_MASK;
+  *flags |= policy;
+
+  if(!NIL_P(v_value))
+    *ttl = NUM2UINT(v_value);
+}
+
+/*
+* Parse and convert SCTP notification messages into Ruby structures.
+* This function handles various types of SCTP notifications.
+*
+* @param buffer Raw notification buffer from SCTP
+* @param length The number of bytes that were received into the buffer
+* @return Ruby struct representing the notification
+*/
+static VALUE get_notification_info(char* buffer, size_t length){
+  uint32_t i;
+  char str[IP_BUFFER_SIZE];
+  union sctp_notification* snp;
+  VALUE v_notification = Qnil;
+  VALUE v_str = Qnil;
+  VALUE* v_temp;
+
+  if(buffer == NULL)
+    rb_raise(rb_eArgError, "notification buffer is null");
+
+  snp = (union sctp_notification*)buffer;
+
+  switch(snp->sn_header.sn_type){
+    case SCTP_ASSOC_CHANGE:
+      switch(snp->sn_assoc_change.sac_state){
+        case SCTP_COMM_LOST:
+          v_str = rb_str_new2("comm lost");
+          break;
+        case SCTP_COMM_UP:
+          v_str = rb_str_new2("comm up");
+          break;
+        case SCTP_RESTART:
+          v_str = rb_str_new2("restart");
+          break;
+        case SCTP_SHUTDOWN_COMP:
+          v_str = rb_str_new2("shutdown complete");
+          break;
+        case SCTP_CANT_STR_ASSOC:
+          v_str = rb_str_new2("association setup failed");
+          break;
+        default:
+          v_str = rb_str_new2("unknown");
+      }
+
+      v_notification = rb_struct_new(v_assoc_change_struct,
+        UINT2NUM(snp->sn_assoc_change.sac_type),
+        UINT2NUM(snp->sn_assoc_change.sac_length),
+        UINT2NUM(snp->sn_assoc_change.sac_state),
+        UINT2NUM(snp->sn_assoc_change.sac_error),
+        UINT2NUM(snp->sn_assoc_change.sac_outbound_streams),
+        UINT2NUM(snp->sn_assoc_change.sac_inbound_streams),
+        UINT2NUM(snp->sn_assoc_change.sac_assoc_id),
+        v_str
+      );
+      break;
+    case SCTP_PEER_ADDR_CHANGE:
+      switch(snp->sn_paddr_change.spc_state){
+        case SCTP_ADDR_AVAILABLE:
+          v_str = rb_str_new2("available");
+          break;
+        case SCTP_ADDR_UNREACHABLE:
+          v_str = rb_str_new2("unreachable");
+          break;
+        case SCTP_ADDR_REMOVED:
+          v_str = rb_str_new2("removed from association");
+          break;
+        case SCTP_ADDR_ADDED:
+          v_str = rb_str_new2("added to association");
+          break;
+        case SCTP_ADDR_MADE_PRIM:
+          v_str = rb_str_new2("primary destination");
+          break;
+#ifdef HAVE_CONST_SCTP_ADDR_CONFIRMED
+        case SCTP_ADDR_CONFIRMED:
+          v_str = rb_str_new2("confirmed");
+          break;
+#endif
+#ifdef HAVE_CONST_SCTP_ADDR_POTENTIALLY_FAILED
+        case SCTP_ADDR_POTENTIALLY_FAILED:
+          v_str = rb_str_new2("potentially failed");
+          break;
+#endif
+        default:
+          v_str = rb_str_new2("unknown");
+      }
+
+      {
+        struct sockaddr* sa = (struct sockaddr*)&snp->sn_paddr_change.spc_aaddr;
+
+        if(sa->sa_family == AF_INET6){
+          struct sockaddr_in6* sin6 = (struct sockaddr_in6*)sa;
+          inet_ntop(AF_INET6, &sin6->sin6_addr, str, sizeof(str));
+        }
+        else{
+          struct sockaddr_in* sin = (struct sockaddr_in*)sa;
+          inet_ntop(AF_INET, &sin->sin_addr, str, sizeof(str));
+        }
+      }
+
+      v_notification = rb_struct_new(v_peeraddr_change_struct,
+        UINT2NUM(snp->sn_paddr_change.spc_type),
+        UINT2NUM(snp->sn_paddr_change.spc_length),
+        rb_str_new2(str),
+        UINT2NUM(snp->sn_paddr_change.spc_state),
+        UINT2NUM(snp->sn_paddr_change.spc_error),
+        UINT2NUM(snp->sn_paddr_change.spc_assoc_id),
+        v_str
+      );
+      break;
+    case SCTP_REMOTE_ERROR:
+      {
+        size_t data_len = 0;
+        VALUE v_data_ary;
+
+        // Calculate actual data length (total length minus fixed header)
+        if(snp->sn_remote_error.sre_length > offsetof(struct sctp_remote_error, sre_data))
+          data_len = snp->sn_remote_error.sre_length - offsetof(struct sctp_remote_error, sre_data);
+
+        // Bounds check to prevent stack overflow
+        if(data_len > MAX_NOTIFICATION_DATA)
+          data_len = MAX_NOTIFICATION_DATA;
+
+        if(data_len > 0){
+          v_temp = ALLOCA_N(VALUE, data_len);
+          for(i = 0; i < data_len; i++){
+            v_temp[i] = UINT2NUM(snp->sn_remote_error.sre_data[i]);
+          }
+          v_data_ary = rb_ary_new4(data_len, v_temp);
+        }
+        else{
+          v_data_ary = rb_ary_new();
+        }
+
+        v_notification = rb_struct_new(v_remote_error_struct,
+          UINT2NUM(snp->sn_remote_error.sre_type),
+          UINT2NUM(snp->sn_remote_error.sre_flags),
+          UINT2NUM(snp->sn_remote_error.sre_length),
+          UINT2NUM(snp->sn_remote_error.sre_error),
+          UINT2NUM(snp->sn_remote_error.sre_assoc_id),
+          v_data_ary
+        );
+      }
+      break;
+#ifdef SCTP_SEND_FAILED_EVENT
+    case SCTP_SEND_FAILED_EVENT:
+      {
+        size_t data_len = 0;
+        VALUE v_data_ary;
+
+#ifdef HAVE_STRUCT_SCTP_SEND_FAILED_EVENT_SSFE_LENGTH
+        // Calculate actual data length (total length minus fixed header)
+        if(snp->sn_send_failed_event.ssfe_length > offsetof(struct sctp_send_failed_event, ssfe_data))
+          data_len = snp->sn_send_failed_event.ssfe_length - offsetof(struct sctp_send_failed_event, ssfe_data);
+
+        // Bounds check to prevent stack overflow
+        if(data_len > MAX_NOTIFICATION_DATA)
+          data_len = MAX_NOTIFICATION_DATA;
+
+        if(data_len > 0){
+          v_temp = ALLOCA_N(VALUE, data_len);
+          for(i = 0; i < data_len; i++){
+            v_temp[i] = UINT2NUM(snp->sn_send_failed_event.ssfe_data[i]);
+          }
+          v_data_ary = rb_ary_new4(data_len, v_temp);
+        }
+        else{
+          v_data_ary = rb_ary_new();
+        }
+
+        v_notification = rb_struct_new(v_send_failed_event_struct,
+          UINT2NUM(snp->sn_send_failed_event.ssfe_type),
+          UINT2NUM(snp->sn_send_failed_event.ssfe_length),
+          UINT2NUM(snp->sn_send_failed_event.ssfe_error),
+          rb_struct_new(v_sndinfo_struct,
+            UINT2NUM(snp->sn_send_failed_event.ssfe_info.snd_sid),
+            UINT2NUM(snp->sn_send_failed_event.ssfe_info.snd_flags),
+            UINT2NUM(snp->sn_send_failed_event.ssfe_info.snd_ppid),
+            UINT2NUM(snp->sn_send_failed_event.ssfe_info.snd_context),
+            UINT2NUM(snp->sn_send_failed_event.ssfe_info.snd_assoc_id)
+          ),
+          UINT2NUM(snp->sn_send_failed_event.ssfe_assoc_id),
+          v_data_ary
+        );
+#else
+        // Calculate actual data length (total length minus fixed header)
+        if(snp->sn_send_failed_event.ssf_length > offsetof(struct sctp_send_failed_event, ssf_data))
+          data_len = snp->sn_send_failed_event.ssf_length - offsetof(struct sctp_send_failed_event, ssf_data);
+
+        // Bounds check to prevent stack overflow
+        if(data_len > MAX_NOTIFICATION_DATA)
+          data_len = MAX_NOTIFICATION_DATA;
+
+        if(data_len > 0){
+          v_temp = ALLOCA_N(VALUE, data_len);
+          for(i = 0; i < data_len; i++){
+            v_temp[i] = UINT2NUM(snp->sn_send_failed_event.ssf_data[i]);
+          }
+          v_data_ary = rb_ary_new4(data_len, v_temp);
+        }
+        else{
+          v_data_ary = rb_ary_new();
+        }
+
+        v_notification = rb_struct_new(v_send_failed_event_struct,
+          UINT2NUM(snp->sn_send_failed_event.ssf_type),
+          UINT2NUM(snp->sn_send_failed_event.ssf_length),
+          UINT2NUM(snp->sn_send_failed_event.ssf_error),
+          rb_struct_new(v_sndinfo_struct,
+            UINT2NUM(snp->sn_send_failed_event.ssfe_info.snd_sid),
+            UINT2NUM(snp->sn_send_failed_event.ssfe_info.snd_flags),
+            UINT2NUM(snp->sn_send_failed_event.ssfe_info.snd_ppid),
+            UINT2NUM(snp->sn_send_failed_event.ssfe_info.snd_context),
+            UINT2NUM(snp->sn_send_failed_event.ssfe_info.snd_assoc_id)
+          ),
+          UINT2NUM(snp->sn_send_failed_event.ssf_assoc_id),
+          v_data_ary
+        );
+#endif
+      }
+      break;
+#else
+    case SCTP_SEND_FAILED:
+      {
+        size_t data_len = 0;
+        VALUE v_data_ary;
+
+        // Calculate actual data length (total length minus fixed header)
+        if(snp->sn_send_failed.ssf_length > offsetof(struct sctp_send_failed, ssf_data))
+          data_len = snp->sn_send_failed.ssf_length - offsetof(struct sctp_send_failed, ssf_data);
+
+        // Bounds check to prevent stack overflow
+        if(data_len > MAX_NOTIFICATION_DATA)
+          data_len = MAX_NOTIFICATION_DATA;
+
+        if(data_len > 0){
+          v_temp = ALLOCA_N(VALUE, data_len);
+          for(i = 0; i < data_len; i++){
+            v_temp[i] = UINT2NUM(snp->sn_send_failed.ssf_data[i]);
+          }
+          v_data_ary = rb_ary_new4(data_len, v_temp);
+        }
+        else{
+          v_data_ary = rb_ary_new();
+        }
+
+        v_notification = rb_struct_new(v_send_failed_event_struct,
+          UINT2NUM(snp->sn_send_failed.ssf_type),
+          UINT2NUM(snp->sn_send_failed.ssf_length),
+          UINT2NUM(snp->sn_send_failed.ssf_error),
+          Qnil,
+          UINT2NUM(snp->sn_send_failed.ssf_assoc_id),
+          v_data_ary
+        );
+      }
+      break;
+#endif
+    case SCTP_SHUTDOWN_EVENT:
+      v_notification = rb_struct_new(v_shutdown_event_struct,
+        UINT2NUM(snp->sn_shutdown_event.sse_type),
+        UINT2NUM(snp->sn_shutdown_event.sse_length),
+        UINT2NUM(snp->sn_shutdown_event.sse_assoc_id)
+      );
+      break;
+    case SCTP_ADAPTATION_INDICATION:
+      v_notification = rb_struct_new(v_adaptation_event_struct,
+        UINT2NUM(snp->sn_adaptation_event.sai_type),
+        UINT2NUM(snp->sn_adaptation_event.sai_length),
+        UINT2NUM(snp->sn_adaptation_event.sai_adaptation_ind),
+        UINT2NUM(snp->sn_adaptation_event.sai_assoc_id)
+      );
+      break;
+    case SCTP_PARTIAL_DELIVERY_EVENT:
+      v_notification = rb_struct_new(v_partial_delivery_event_struct,
+        UINT2NUM(snp->sn_pdapi_event.pdapi_type),
+        UINT2NUM(snp->sn_pdapi_event.pdapi_length),
+        UINT2NUM(snp->sn_pdapi_event.pdapi_indication),
+        UINT2NUM(snp->sn_pdapi_event.pdapi_stream),
+        UINT2NUM(snp->sn_pdapi_event.pdapi_seq),
+        UINT2NUM(snp->sn_pdapi_event.pdapi_assoc_id)
+      );
+      break;
+    case SCTP_AUTHENTICATION_EVENT:
+      v_notification = rb_struct_new(v_auth_event_struct,
+#ifdef HAVE_UNION_SCTP_NOTIFICATION_SN_AUTH_EVENT
+        UINT2NUM(snp->sn_auth_event.auth_type),
+        UINT2NUM(snp->sn_auth_event.auth_length),
+        UINT2NUM(snp->sn_auth_event.auth_keynumber),
+        UINT2NUM(snp->sn_auth_event.auth_indication),
+        UINT2NUM(snp->sn_auth_event.auth_assoc_id)
+#else
+        UINT2NUM(snp->sn_authkey_event.auth_type),
+        UINT2NUM(snp->sn_authkey_event.auth_length),
+        UINT2NUM(snp->sn_authkey_event.auth_keynumber),
+        UINT2NUM(snp->sn_authkey_event.auth_indication),
+        UINT2NUM(snp->sn_authkey_event.auth_assoc_id)
+#endif
+      );
+      break;
+    case SCTP_SENDER_DRY_EVENT:
+      v_notification = rb_struct_new(v_sender_dry_event_struct,
+        UINT2NUM(snp->sn_sender_dry_event.sender_dry_type),
+        UINT2NUM(snp->sn_sender_dry_event.sender_dry_flags),
+        UINT2NUM(snp->sn_sender_dry_event.sender_dry_length),
+        UINT2NUM(snp->sn_sender_dry_event.sender_dry_assoc_id)
+      );
+      break;
+#ifdef SCTP_STREAM_RESET_EVENT
+    case SCTP_STREAM_RESET_EVENT:
+      {
+        uint32_t num_streams = 0;
+        size_t event_length = snp->sn_strreset_event.strreset_length;
+
+        // Never trust the event length beyond what was actually received
+        if(event_length > length)
+          event_length = length;
+
+        if(event_length > sizeof(struct sctp_stream_reset_event))
+          num_streams = (event_length - sizeof(struct sctp_stream_reset_event)) / sizeof(uint16_t);
+
+        v_str = rb_ary_new_capa(num_streams);
+
+        for(i = 0; i < num_streams; i++)
+          rb_ary_push(v_str, UINT2NUM(snp->sn_strreset_event.strreset_stream_list[i]));
+
+        v_notification = rb_struct_new(v_stream_reset_event_struct,
+          UINT2NUM(snp->sn_strreset_event.strreset_type),
+          UINT2NUM(snp->sn_strreset_event.strreset_flags),
+          UINT2NUM(snp->sn_strreset_event.strreset_length),
+          UINT2NUM(snp->sn_strreset_event.strreset_assoc_id),
+          v_str
+        );
+      }
+      break;
+#endif
+#ifdef SCTP_ASSOC_RESET_EVENT
+    case SCTP_ASSOC_RESET_EVENT:
+      v_notification = rb_struct_new(v_assoc_reset_event_struct,
+        UINT2NUM(snp->sn_assocreset_event.assocreset_type),
+        UINT2NUM(snp->sn_assocreset_event.assocreset_flags),
+        UINT2NUM(snp->sn_assocreset_event.assocreset_length),
+        UINT2NUM(snp->sn_assocreset_event.assocreset_assoc_id),
+        UINT2NUM(snp->sn_assocreset_event.assocreset_local_tsn),
+        UINT2NUM(snp->sn_assocreset_event.assocreset_remote_tsn)
+      );
+      break;
+#endif
+#ifdef SCTP_STREAM_CHANGE_EVENT
+    case SCTP_STREAM_CHANGE_EVENT:
+      v_notification = rb_struct_new(v_stream_change_event_struct,
+        UINT2NUM(snp->sn_strchange_event.strchange_type),
+        UINT2NUM(snp->sn_strchange_event.strchange_flags),
+        UINT2NUM(snp->sn_strchange_event.strchange_length),
+        UINT2NUM(snp->sn_strchange_event.strchange_assoc_id),
+        UINT2NUM(snp->sn_strchange_event.strchange_instrms),
+        UINT2NUM(snp->sn_strchange_event.strchange_outstrms)
+      );
+      break;
+#endif
+  }
+
+  return v_notification;
+}
+
+/*
+ * call-seq:
+ *    SCTP::Socket.new(domain = Socket::AF_INET, type = Socket::SOCK_STREAM)
+ *
+ * Create and return a new SCTP::Socket instance. You may optionally pass in
+ * a domain (aka family) value and socket type. By default these are AF_INET
+ * and SOCK_SEQPACKET, respectively.
+ *
+ * There are only two supported families: SOCK_SEQPACKET for the creation
+ * of a one-to-many socket, and SOCK_STREAM for the creation of a
+ * one-to-one socket.
+ *
+ * Example:
+ *
+ *   require 'socket'
+ *   require 'sctp/socket'
+ *
+ *   socket1 = SCTP::Socket.new
+ *   socket2 = SCTP::Socket.new(Socket::AF_INET, Socket::SOCK_STREAM)
+ */
+static VALUE rsctp_init(int argc, VALUE* argv, VALUE self){
+  sctp_sock_t fileno;
+  VALUE v_domain, v_type;
+
+  rb_scan_args(argc, argv, "02", &v_domain, &v_type);
+
+  // Set defaults with validation
+  if(NIL_P(v_domain)){
+    v_domain = INT2NUM(AF_INET);
+  }
+  else{
+    int domain = NUM2INT(v_domain);
+    if((domain != AF_INET) && (domain != AF_INET6))
+      rb_raise(rb_eArgError, "unsupported domain family: %d", domain);
+  }
+
+  if(NIL_P(v_type)){
+    v_type = INT2NUM(SOCK_SEQPACKET);
+  }
+  else{
+    int type = NUM2INT(v_type);
+    if (type != SOCK_SEQPACKET && type != SOCK_STREAM)
+      rb_raise(rb_eArgError, "unsupported socket type: %d", type);
+  }
+
+  fileno = sctp_sys_socket(NUM2INT(v_domain), NUM2INT(v_type), IPPROTO_SCTP);
+
+  if(SCTP_FD_INVALID(fileno))
+    rb_raise(rb_eSystemCallError, "socket: %s", strerror(errno));
+
+  rb_iv_set(self, "@domain", v_domain);
+  rb_iv_set(self, "@type", v_type);
+  rb_iv_set(self, "@fileno", SCTP_FD_TO_NUM(fileno));
+  rb_iv_set(self, "@association_id", INT2NUM(0));
+
+  return self;
+}
+
+/*
+ * call-seq:
+ *    SCTP::Socket.for_fd(fileno, domain = Socket::AF_INET, type = Socket::SOCK_STREAM)
+ *
+ * Wraps an existing SCTP socket descriptor in a new SCTP::Socket object. This
+ * is mainly useful for the descriptor returned by SCTP::Socket#peeloff, which
+ * is a one-to-one style socket for a single association, or a descriptor that
+ * was handed to a worker process.
+ *
+ * Example:
+ *
+ *   fileno = server.peeloff(info.association_id)
+ *   client = SCTP::Socket.for_fd(fileno)
+ *   client.association_id = info.association_id
+ */
+static VALUE rsctp_s_for_fd(int argc, VALUE* argv, VALUE klass){
+  sctp_sock_t fileno;
+  VALUE self, v_fileno, v_domain, v_type;
+  struct sockaddr_storage ss;
+  socklen_t len = sizeof(ss);
+
+  rb_scan_args(argc, argv, "12", &v_fileno, &v_domain, &v_type);
+
+  if(NIL_P(v_domain)){
+    v_domain = INT2NUM(AF_INET);
+  }
+  else{
+    int domain = NUM2INT(v_domain);
+    if((domain != AF_INET) && (domain != AF_INET6))
+      rb_raise(rb_eArgError, "unsupported domain family: %d", domain);
+  }
+
+  if(NIL_P(v_type)){
+    v_type = INT2NUM(SOCK_STREAM);
+  }
+  else{
+    int type = NUM2INT(v_type);
+    if (type != SOCK_SEQPACKET && type != SOCK_STREAM)
+      rb_raise(rb_eArgError, "unsupported socket type: %d", type);
+  }
+
+  fileno = NUM_TO_SCTP_FD(v_fileno);
+
+  if(SCTP_FD_INVALID(fileno))
+    rb_raise(rb_eArgError, "invalid socket descriptor");
+
+  self = rb_obj_alloc(klass);
+
+  rb_iv_set(self, "@domain", v_domain);
+  rb_iv_set(self, "@type", v_type);
+  rb_iv_set(self, "@fileno", v_fileno);
+  rb_iv_set(self, "@association_id", INT2NUM(0));
+
+  bzero(&ss, len);
+
+  // The port is informational only, so a failure here isn't fatal
+  if(sctp_sys_getsockname(fileno, (struct sockaddr *)&ss, &len) == 0){
+    if(ss.ss_family == AF_INET6)
+      rb_iv_set(self, "@port", INT2NUM(ntohs(((struct sockaddr_in6*)&ss)->sin6_port)));
+    else
+      rb_iv_set(self, "@port", INT2NUM(ntohs(((struct sockaddr_in*)&ss)->sin_port)));
+  }
+
+  return self;
+}
+
+/*
+ * call-seq:
+ *    SCTP::Socket#bindx(options)
+ *
+ * Bind a subset of IP addresses associated with the host system on the
+ * given port, or a port assigned by the operating system if none is provided.
+ * You may bind a maximum of eight IP addresses.
+ *
+ * Note that you can both add or remove an address to or from the socket
+ * using the SCTP_BINDX_ADD_ADDR (default) or SCTP_BINDX_REM_ADDR constants,
+ * respectively.
+ *
+ * Possible options:
+ *
+ * * addresses - Array of IP addresses to bind to. If none are specified then
+ *     INADDR_ANY is used.
+ *
+ * * port - The port to bind to. If none is specified then 0 is used, i.e. the
+ *     OS will select one for you.
+ *
+ * * flags - Flags to pass to the underlying sctp_bindx function. In practice
+ *     there are only two options: BINDX_ADD_ADDR and BINDX_REM_ADDR. By
+ *     default a flag of BINDX_ADD_ADDR is assumed.
+ *
+ * * reuse_addr - If set to true, then the SO_REUSEADDR flag will be applied to
+ *     the socket before the bind call. This will allow other sockets to reuse
+ *     the addresses that are currently bound to the socket.
+ *
+ * * reuse_port - If set to true, then the SO_REUSEPORT flag will be applied to
+ *     the socket before the bind call. This allows several sockets, e.g. one
+ *     per worker, to listen on the same addresses and port, with the kernel
+ *     spreading new associations across them. Raises a NotImplementedError
+ *     on platforms without SO_REUSEPORT, and on usrsctp builds.
+ *
+ * Example:
+ *
+ *   socket = SCTP::Socket.new
+ *
+ *   # Bind 2 addresses
+ *   socket.bindx(:port => 64325, :addresses => ['10.0.4.5', '10.0.5.5'])
+ *
+ *   # Remove 1 later
+ *   socket.bindx(:addresses => ['10.0.4.5'], :flags => SCTP::Socket::BINDX_REM_ADDR)
+ *
+ * If no addresses are specified, then it will bind to all available interfaces. If
+ * no port is specified, then one will be assigned by the host.
+ *
+ * Returns the port that it was bound to.
+ */
+static VALUE rsctp_bindx(int argc, VALUE* argv, VALUE self){
+  sctp_sock_t fileno;
+  int i, num_ip, flags, domain, port, on;
+  VALUE v_addresses, v_port, v_flags, v_address, v_reuse_addr, v_reuse_port, v_options;
+
+  rb_scan_args(argc, argv, "01", &v_options);
+
+  if(NIL_P(v_options))
+    v_options = rb_hash_new();
+
+  v_addresses = rb_hash_aref2(v_options, "addresses");
+  v_flags = rb_hash_aref2(v_options, "flags");
+  v_port = rb_hash_aref2(v_options, "port");
+  v_reuse_addr = rb_hash_aref2(v_options, "reuse_addr");
+  v_reuse_port = rb_hash_aref2(v_options, "reuse_port");
+
+  if(NIL_P(v_port))
+    port = 0;
+  else
+    port = NUM2INT(v_port);
+
+  if(NIL_P(v_flags))
+    flags = SCTP_BINDX_ADD_ADDR;
+  else
+    flags = NUM2INT(v_flags);
+
+  if(NIL_P(v_addresses))
+    num_ip = 1;
+  else
+    num_ip = (int)RARRAY_LEN(v_addresses);
+
+  if(num_ip > MAX_IP_ADDRESSES)
+    rb_raise(rb_eArgError, "too many IP addresses to bind, maximum is eight");
+
+  CHECK_SOCKET_CLOSED(self);
+
+  domain = NUM2INT(rb_iv_get(self, "@domain"));
+  fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+
+  if(v_reuse_addr == Qtrue){
+    on = 1;
+#ifdef HAVE_USRSCTP_H
+    /* usrsctp runs in userspace; address reuse is not needed/supported. Silently skip. */
+    (void)on;
+#else
+    if(sctp_sys_setsockopt(fileno, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) < 0)
+      rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
+#endif
+  }
+
+  if(v_reuse_port == Qtrue){
+    on = 1;
+#ifdef HAVE_USRSCTP_H
+    /* usrsctp runs in userspace; there is no kernel to spread associations across sockets. */
+    (void)on;
+    rb_raise(rb_eNotImpError, "SO_REUSEPORT is not supported by usrsctp");
+#elif defined(SO_REUSEPORT)
+    if(sctp_sys_setsockopt(fileno, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) < 0)
+      rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
+#else
+    rb_raise(rb_eNotImpError, "SO_REUSEPORT is not supported on this platform");
+#endif
+  }
+
+  if(domain == AF_INET6){
+    struct sockaddr_in6 addrs6[MAX_IP_ADDRESSES];
+    bzero(&addrs6, sizeof(addrs6));
+
+    if(!NIL_P(v_addresses)){
+      for(i = 0; i < num_ip; i++){
+        v_address = RARRAY_AREF(v_addresses, i);
+        parse_ip_address_v6(StringValueCStr(v_address), port, &addrs6[i]);
+      }
+    }
+    else{
+      set_any_address_v6(port, &addrs6[0]);
+    }
+
+    if(sctp_sys_bindx(fileno, (struct sockaddr *)addrs6, num_ip, flags) != 0)
+      rb_raise(rb_eSystemCallError, "sctp_bindx: %s", strerror(errno));
+  }
+  else{
+    struct sockaddr_in addrs[MAX_IP_ADDRESSES];
+    bzero(&addrs, sizeof(addrs));
+
+    if(!NIL_P(v_addresses)){
+      for(i = 0; i < num_ip; i++){
+        v_address = RARRAY_AREF(v_addresses, i);
+        parse_ip_address_v4(StringValueCStr(v_address), port, &addrs[i]);
+      }
+    }
+    else{
+      set_any_address_v4(port, &addrs[0]);
+    }
+
+    if(sctp_sys_bindx(fileno, (struct sockaddr *)addrs, num_ip, flags) != 0)
+      rb_raise(rb_eSystemCallError, "sctp_bindx: %s", strerror(errno));
+  }
+
+  if(port == 0){
+    struct sockaddr_storage ss;
+    socklen_t len = sizeof(ss);
+    bzero(&ss, len);
+
+    if(sctp_sys_getsockname(fileno, (struct sockaddr *)&ss, &len) == -1)
+      rb_raise(rb_eSystemCallError, "getsockname: %s", strerror(errno));
+
+    if(ss.ss_family == AF_INET6){
+      struct sockaddr_in6* sin6 = (struct sockaddr_in6*)&ss;
+      port = ntohs(sin6->sin6_port);
+    }
+    else{
+      struct sockaddr_in* sin = (struct sockaddr_in*)&ss;
+      port = ntohs(sin->sin_port);
+    }
+  }
+
+  rb_iv_set(self, "@port", INT2NUM(port));
+
+  return INT2NUM(port);
+}
+
+/*
+ * call-seq:
+ *    SCTP::Socket#connectx(options)
+ *
+ * Connect the socket to a multihomed peer via the provided array of addresses
+ * using the domain specified in the constructor. You must also specify the port.
+ *
+ * Example:
+ *
+ *   socket = SCTP::Socket.new
+ *   socket.connectx(:port => 62354, :addresses => ['10.0.4.5', '10.0.5.5'])
+ *
+ * Note that this will also set/update the object's association_id. Also note that
+ * this method is not strictly necessary on the client side, since the various send
+ * methods will automatically establish associations.
+ */
+static VALUE rsctp_connectx(int argc, VALUE* argv, VALUE self){
+  sctp_sock_t fileno;
+  int i, num_ip, domain, port;
+  sctp_assoc_t assoc;
+  VALUE v_address, v_options, v_addresses, v_port;
+
+  rb_scan_args(argc, argv, "01", &v_options);
+
+  if(NIL_P(v_options))
+    rb_raise(rb_eArgError, "you must specify an array of addresses");
+
+  Check_Type(v_options, T_HASH);
+
+  v_addresses = rb_hash_aref2(v_options, "addresses");
+  v_port = rb_hash_aref2(v_options, "port");
+
+  if(NIL_P(v_addresses) || RARRAY_LEN(v_addresses) == 0)
+    rb_raise(rb_eArgError, "you must specify an array of addresses containing at least one address");
+
+  if(NIL_P(v_port))
+    rb_raise(rb_eArgError, "you must specify a port");
+
+  CHECK_SOCKET_CLOSED(self);
+
+  domain = NUM2INT(rb_iv_get(self, "@domain"));
+  port = NUM2INT(v_port);
+  fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+
+  num_ip = (int)RARRAY_LEN(v_addresses);
+
+  if(num_ip > MAX_IP_ADDRESSES)
+    rb_raise(rb_eArgError, "too many IP addresses, maximum is eight");
+
+  if(domain == AF_INET6){
+    struct sockaddr_in6 addrs6[MAX_IP_ADDRESSES];
+    bzero(&addrs6, sizeof(addrs6));
+
+    for(i = 0; i < num_ip; i++){
+      v_address = RARRAY_AREF(v_addresses, i);
+      parse_ip_address_v6(StringValueCStr(v_address), port, &addrs6[i]);
+    }
+
+    if(sctp_sys_connectx(fileno, (struct sockaddr *)addrs6, num_ip, &assoc) < 0)
+      rb_raise(rb_eSystemCallError, "sctp_connectx: %s", strerror(errno));
+  }
+  else{
+    struct sockaddr_in addrs[MAX_IP_ADDRESSES];
+    bzero(&addrs, sizeof(addrs));
+
+    for(i = 0; i < num_ip; i++){
+      v_address = RARRAY_AREF(v_addresses, i);
+      parse_ip_address_v4(StringValueCStr(v_address), port, &addrs[i]);
+    }
+
+    if(sctp_sys_connectx(fileno, (struct sockaddr *)addrs, num_ip, &assoc) < 0)
+      rb_raise(rb_eSystemCallError, "sctp_connectx: %s", strerror(errno));
+  }
+
+  rb_iv_set(self, "@association_id", INT2NUM(assoc));
+
+  return self;
+}
+
+/*
+ * call-seq:
+ *    SCTP::Socket#close
+ *
+ * Close the socket. You should always do this.
+ *
+ * By default the underlying close operation is non-blocking. This means that the
+ * bound IP addresses may not be available right away after closing. You may
+ * optionally control this behavior with the +linger+ option.
+ *
+ *
+ * * linger - If present, this should be set to a numeric value, in seconds.
+ *     The value will cause the close operation to block for that number of
+ *     seconds, after which it will return (i.e. return to non-blocking).
+ *
+ * Example:
+ *
+ *   socket = SCTP::Socket.new
+ *   socket.close # or
+ *   socket.close(linger: 5)
+ */
+static VALUE rsctp_close(int argc, VALUE* argv, VALUE self){
+  VALUE v_options, v_linger, v_fileno;
+  sctp_sock_t fileno;
+
+  rb_scan_args(argc, argv, "01", &v_options);
+
+  if(NIL_P(v_options))
+    v_options = rb_hash_new();
+
+  Check_Type(v_options, T_HASH);
+
+  v_linger = rb_hash_aref2(v_options, "linger");
+  v_fileno = rb_iv_get(self, "@fileno");
+
+  if(NIL_P(v_fileno)) // Already closed
+    return self;
+
+  fileno = NUM_TO_SCTP_FD(v_fileno);
+
+  if(!NIL_P(v_linger)){
+#ifdef HAVE_USRSCTP_H
+    /* usrsctp doesn't support SOL_SOCKET options; linger is not available */
+    (void)v_linger;
+#else
+    struct linger lin;
+    int linger_time = NUM2INT(v_linger);
+
+    if(linger_time < 0)
+      rb_raise(rb_eArgError, "linger time must be non-negative");
+
+    lin.l_onoff = 1;
+    lin.l_linger = linger_time;
+
+    if(sctp_sys_setsockopt(fileno, SOL_SOCKET, SO_LINGER, &lin, sizeof(struct linger)) < 0)
+      rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
+#endif
+  }
+
+  if(sctp_sys_close(fileno) < 0)
+    rb_raise(rb_eSystemCallError, "close: %s", strerror(errno));
+
+  // Mark socket as closed
+  rb_iv_set(self, "@fileno", Qnil);
+
+  return self;
+}
+
+/*
+ * call-seq:
+ *    SCTP::Socket#closed?
+ *
+ * Returns true if the socket is closed, false otherwise.
+ *
+ * Example:
+ *   socket = SCTP::Socket.new
+ *   socket.closed? # => false
+ *   socket.close
+ *   socket.closed? # => true
+ */
+static VALUE rsctp_closed_p(VALUE self){
+  VALUE v_fileno = rb_iv_get(self, "@fileno");
+  return NIL_P(v_fileno) ? Qtrue : Qfalse;
+}
+
+/*
+ * call-seq:
+ *    SCTP::Socket#getpeernames
+ *
+ * Return an array of all addresses of a peer of the current socket
+ * and association number.
+ *
+ * You may optionally pass a assocation fileno and association ID. Typically
+ * this information would come from the peeloff method.
+ *
+ * Example:
+ *
+ *   socket = SCTP::Socket.new
+ *   # ...
+ *   p socket.getpeernames
+ *
+ *   info = socket.recvmsg
+ *   association_fileno = socket.peeloff(info.association_id)
+ *
+ *   p socket.getpeernames(association_fileno, info.association_id)
+ */
+static VALUE rsctp_getpeernames(int argc, VALUE* argv, VALUE self){
+  sctp_assoc_t assoc_id;
+  struct sockaddr* addrs = NULL;
+  sctp_sock_t fileno;
+  int num_addrs;
+  VALUE v_fileno, v_association_id;
+  VALUE v_array;
+
+  rb_scan_args(argc, argv, "02", &v_fileno, &v_association_id);
+
+  if(NIL_P(v_fileno)){
+    CHECK_SOCKET_CLOSED(self);
+    fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+  }
+  else{
+    fileno = NUM_TO_SCTP_FD(v_fileno);
+    CHECK_FILENO_VALID(fileno);
+  }
+
+  if(NIL_P(v_association_id))
+    assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
+  else
+    assoc_id = NUM2INT(v_association_id);
+
+  num_addrs = sctp_sys_getpaddrs(fileno, assoc_id, &addrs);
+
+  if(num_addrs < 0){
+    if(addrs != NULL)
+      sctp_sys_freepaddrs(addrs);
+
+    rb_raise(rb_eSystemCallError, "sctp_getpaddrs: %s", strerror(errno));
+  }
+
+  v_array = convert_packed_addrs_to_array(addrs, num_addrs, 0);
+
+  sctp_sys_freepaddrs(addrs);
+
+  return v_array;
+}
+
+/*
+ * call-seq:
+ *    SCTP::Socket#peer_addresses(association_id=nil)
+ *
+ * Returns a frozen array of the peer addresses of the association, like
+ * SCTP::Socket#getpeernames, but from a cache rather than a system call.
+ *
+ * The cache is turned on by the first call to this method, or by
+ * SCTP::Socket#track_associations=. From then on it is filled when a
+ * receive method returns an association's comm up notification, and kept
+ * current from its peer address change notifications, so subscribe to the
+ * :association and :address events to use it. If the association isn't in
+ * the cache its addresses are looked up with sctp_getpaddrs instead, and
+ * the result is not cached.
+ *
+ * Example:
+ *
+ *   socket.subscribe(:data_io => true, :association => true, :address => true)
+ *
+ *   info = socket.recvmsg
+ *   socket.peer_addresses(info.association_id) # => ['10.0.4.5', '10.0.5.5']
+ */
+static VALUE rsctp_peer_addresses(int argc, VALUE* argv, VALUE self){
+  VALUE v_assoc_id, v_cache, v_addresses;
+  struct sockaddr* addrs = NULL;
+  sctp_sock_t fileno;
+  int num_addrs;
+
+  rb_scan_args(argc, argv, "01", &v_assoc_id);
+
+  CHECK_SOCKET_CLOSED(self);
+
+  if(NIL_P(v_assoc_id))
+    v_assoc_id = rb_iv_get(self, "@association_id");
+
+  v_assoc_id = INT2NUM(NUM2INT(v_assoc_id));
+  v_cache = rb_attr_get(self, rb_intern("peer_addresses"));
+
+  if(NIL_P(v_cache)){
+    v_cache = rb_hash_new();
+    rb_ivar_set(self, rb_intern("peer_addresses"), v_cache);
+  }
+
+  v_addresses = rb_hash_lookup(v_cache, v_assoc_id);
+
+  if(!NIL_P(v_addresses))
+    return v_addresses;
+
+  fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+  num_addrs = sctp_sys_getpaddrs(fileno, NUM2INT(v_assoc_id), &addrs);
+
+  if(num_addrs < 0){
+    if(addrs != NULL)
+      sctp_sys_freepaddrs(addrs);
+
+    rb_raise(rb_eSystemCallError, "sctp_getpaddrs: %s", strerror(errno));
+  }
+
+  v_addresses = convert_packed_addrs_to_array(addrs, num_addrs, 1);
+
+  sctp_sys_freepaddrs(addrs);
+
+  return v_addresses;
+}
+
+/*
+ * call-seq:
+ *    SCTP::Socket#track_associations?
+ *
+ * Returns whether or not the association table is enabled.
+ */
+static VALUE rsctp_get_track_associations(VALUE self){
+  return NIL_P(rb_attr_get(self, rb_intern("associations"))) ? Qfalse : Qtrue;
+}
+
+/*
+ * call-seq:
+ *    SCTP::Socket#track_associations=(bool)
+ *
+ * Turn the association table on or off. While it is on, the receive methods
+ * feed the association change, peer address change, shutdown and sender dry
+ * notifications they return into a table that is available through the
+ * SCTP::Socket#associations method.
+ *
+ * Only associations that come up after the table is enabled are tracked, so
+ * turn it on before listen or connect, and subscribe to at least the
+ * :association event. Turning it off discards the table.
+ */
+static VALUE rsctp_set_track_associations(VALUE self, VALUE v_bool){
+  CHECK_SOCKET_CLOSED(self);
+
+  if(RTEST(v_bool)){
+    if(NIL_P(rb_attr_get(self, rb_intern("associations"))))
+      rb_ivar_set(self, rb_intern("associations"), rb_hash_new());
+
+    return Qtrue;
+  }
+
+  rb_ivar_set(self, rb_intern("associations"), Qnil);
+
+  return Qfalse;
+}
+
+/*
+ * call-seq:
+ *    SCTP::Socket#associations
+ *
+ * Returns the association table, a hash of association ids to Association
+ * structs, or nil if it isn't enabled. See SCTP::Socket#track_associations=.
+ *
+ * Each struct holds the association's state, as one of the SCTP_ESTABLISHED
+ * or SCTP_SHUTDOWN_RECEIVED constants, its outbound and inbound stream
+ * counts, its peer addresses as returned by SCTP::Socket#peer_addresses,
+ * the monotonic time of the last message or notification received on it,
+ * and the bytes sent on it since it last reported that the sender was dry.
+ * Sends with SCTP::Socket#send are always counted, and sends with
+ * SCTP::Socket#sendmsg and SCTP::Socket#sendv when no addresses are given.
+ *
+ * Associations are removed when they are lost or shut down, and when they
+ * are peeled off. The hash and its structs are updated in place, so treat
+ * them as read only.
+ *
+ * Example:
+ *
+ *   socket.track_associations = true
+ *   socket.subscribe(:data_io => true, :association => true, :address => true)
+ *   socket.listen
+ *
+ *   info = socket.recvmsg
+ *   assoc = socket.associations[info.association_id]
+ *   assoc.outbound_streams # => 10
+ */
+static VALUE rsctp_associations(VALUE self){
+  return rb_attr_get(self, rb_intern("associations"));
+}
+
+/*
+ * call-seq:
+ *    SCTP::Socket#getlocalnames
+ *
+ * Return an array of local addresses that are part of the association.
+ *
+ * Example:
+ *
+ *  socket = SCTP::Socket.new
+ *  socket.bind(:addresses => ['10.0.4.5', '10.0.5.5'])
+ *  socket.getlocalnames # => ['10.0.4.5', '10.0.5.5'])
+ *
+ *  # or get info from a peeled off association...
+ *
+ *  assoc_fileno = socket.peeloff(some_association_id)
+ *  socket.getlocalnames(assoc_fileno, some_association_id)
+ */
+static VALUE rsctp_getlocalnames(int argc, VALUE* argv, VALUE self){
+  sctp_assoc_t assoc_id;
+  struct sockaddr* addrs = NULL;
+  sctp_sock_t fileno;
+  int num_addrs;
+  VALUE v_assoc_fileno, v_assoc_id;
+  VALUE v_array;
+
+  rb_scan_args(argc, argv, "02", &v_assoc_fileno, &v_assoc_id);
+
+  if(NIL_P(v_assoc_fileno)){
+    CHECK_SOCKET_CLOSED(self);
+    fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+  }
+  else{
+    fileno = NUM_TO_SCTP_FD(v_assoc_fileno);
+    CHECK_FILENO_VALID(fileno);
+  }
+
+  if(NIL_P(v_assoc_id))
+    assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
+  else
+    assoc_id = NUM2INT(v_assoc_id);
+
+  num_addrs = sctp_sys_getladdrs(fileno, assoc_id, &addrs);
+
+  if(num_addrs < 0){
+    if(addrs != NULL)
+      sctp_sys_freeladdrs(addrs);
+
+    rb_raise(rb_eSystemCallError, "sctp_getladdrs: %s", strerror(errno));
+  }
+
+  v_array = convert_packed_addrs_to_array(addrs, num_addrs, 0);
+
+  sctp_sys_freeladdrs(addrs);
+
+  return v_array;
+}
+
+#ifdef HAVE_SCTP_SENDV
+/*
+ * call-seq:
+ *    SCTP::Socket#sendv(options)
+ *
+ * Transmit a message to an SCTP endpoint using a gather-write. The following
+ * hash of options is permitted:
+ *
+ *  * message   - An array of strings that will be joined into a single message.
+ *                IO::Buffer objects may be used in place of strings. Use
+ *                IO::Buffer#slice to send only part of a buffer.
+ *  * addresses - An array of IP addresses to setup an association to send the message.
+ *  * info_type - The type of information provided. The default is SCTP_SENDV_SNDINFO.
+ *  * pr_policy - A partial reliability policy, one of the SCTP_PR_SCTP_* constants.
+ *  * pr_value  - The value for the policy, e.g. a lifetime in milliseconds for
+ *                SCTP_PR_SCTP_TTL or a retransmission limit for SCTP_PR_SCTP_RTX.
+ *
+ *  Example:
+ *
+ *    socket = SCTP::Socket.new
+ *
+ *    # You can specify addresses here or in an earlier connectx call.
+ *    socket.sendv({
+ *      :message   => ['Hello ', 'World.'],
+ *      :addresses => ['10.0.5.4', '10.0.6.4'],
+ *      :info_type => SCTP::Socket:::SCTP_SENDV_SNDINFO
+ *    })
+ *
+ *  CAVEAT: Currently info_type is not yet supported.
+ *
+ *  Returns the number of bytes sent.
+ */
+static VALUE rsctp_sendv(VALUE self, VALUE v_options){
+  VALUE v_msg, v_message, v_addresses, v_pr_policy, v_pr_value;
+  struct iovec iov[IOV_MAX];
+  struct sctp_sendv_spa spa;
+  sctp_sock_t fileno;
+  int i, size, num_ip, domain, port;
+  ssize_t num_bytes;
+
+  Check_Type(v_options, T_HASH);
+
+  bzero(&iov, sizeof(iov));
+  bzero(&spa, sizeof(spa));
+
+  v_message   = rb_hash_aref2(v_options, "message");
+  v_addresses = rb_hash_aref2(v_options, "addresses");
+  v_pr_policy = rb_hash_aref2(v_options, "pr_policy");
+  v_pr_value  = rb_hash_aref2(v_options, "pr_value");
+
+  // Validate required message parameter
+  if(NIL_P(v_message))
+    rb_raise(rb_eArgError, "message parameter is required");
+
+  Check_Type(v_message, T_ARRAY);
+
+  CHECK_SOCKET_CLOSED(self);
+
+  if(!NIL_P(v_addresses)){
+    Check_Type(v_addresses, T_ARRAY);
+    num_ip = (int)RARRAY_LEN(v_addresses);
+
+    if(num_ip > MAX_IP_ADDRESSES)
+      rb_raise(rb_eArgError, "too many IP addresses, maximum is eight");
+  }
+  else{
+    num_ip = 0;
+  }
+
+  fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+  size = (int)RARRAY_LEN(v_message);
+
+  if(!size)
+    rb_raise(rb_eArgError, "Must contain at least one message");
+
+  if(size > IOV_MAX)
+    rb_raise(rb_eArgError, "Array size is greater than IOV_MAX");
+
+  // TODO: Make this configurable
+  spa.sendv_flags = SCTP_SEND_SNDINFO_VALID;
+  spa.sendv_sndinfo.snd_flags = SCTP_UNORDERED;
+  spa.sendv_sndinfo.snd_assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
+
+  if(!NIL_P(v_pr_policy)){
+    spa.sendv_flags |= SCTP_SEND_PRINFO_VALID;
+    spa.sendv_prinfo.pr_policy = get_pr_policy(v_pr_policy);
+
+    if(!NIL_P(v_pr_value))
+      spa.sendv_prinfo.pr_value = NUM2UINT(v_pr_value);
+  }
+
+  for(i = 0; i < size; i++){
+    v_msg = RARRAY_AREF(v_message, i);
+    iov[i].iov_base = (void*)get_payload(v_msg, Qnil, Qnil, &iov[i].iov_len);
+  }
+
+#ifdef HAVE_USRSCTP_H
+  // Gather multi-part messages into the reusable per-socket buffer
+  if(size > 1){
+    size_t total = 0;
+    char* gather;
+
+    for(i = 0; i < size; i++)
+      total += iov[i].iov_len;
+
+    gather = get_gather_buffer(self, total);
+    sctp_sys_iov_gather(gather, iov, size);
+
+    iov[0].iov_base = gather;
+    iov[0].iov_len = total;
+    size = 1;
+  }
+#endif
+
+  domain = NUM2INT(rb_iv_get(self, "@domain"));
+
+  if(num_ip > 0){
+    VALUE v_address, v_port;
+
+    v_port = rb_iv_get(self, "@port");
+
+    if(NIL_P(v_port))
+      port = 0;
+    else
+      port = NUM2INT(v_port);
+
+    if(domain == AF_INET6){
+      struct sockaddr_in6* addrs6 = (struct sockaddr_in6*)alloca(num_ip * sizeof(struct sockaddr_in6));
+      bzero(addrs6, num_ip * sizeof(struct sockaddr_in6));
+
+      for(i = 0; i < num_ip; i++){
+        v_address = RARRAY_AREF(v_addresses, i);
+        parse_ip_address_v6(StringValueCStr(v_address), port, &addrs6[i]);
+      }
+
+      num_bytes = (ssize_t)sctp_sys_sendv(
+        fileno,
+        iov,
+        size,
+        (struct sockaddr*)addrs6,
+        num_ip,
+        &spa,
+        sizeof(spa),
+        SCTP_SENDV_SPA,
+        0
+      );
+    }
+    else{
+      struct sockaddr_in* addrs = (struct sockaddr_in*)alloca(num_ip * sizeof(struct sockaddr_in));
+      bzero(addrs, num_ip * sizeof(struct sockaddr_in));
+
+      for(i = 0; i < num_ip; i++){
+        v_address = RARRAY_AREF(v_addresses, i);
+        parse_ip_address_v4(StringValueCStr(v_address), port, &addrs[i]);
+      }
+
+      num_bytes = (ssize_t)sctp_sys_sendv(
+        fileno,
+        iov,
+        size,
+        (struct sockaddr*)addrs,
+        num_ip,
+        &spa,
+        sizeof(spa),
+        SCTP_SENDV_SPA,
+        0
+      );
+    }
+  }
+  else{
+    num_bytes = (ssize_t)sctp_sys_sendv(
+      fileno,
+      iov,
+      size,
+      NULL,
+      0,
+      &spa,
+      sizeof(spa),
+      SCTP_SENDV_SPA,
+      0
+    );
+  }
+
+  SCTP_PROBE_SENDV(fileno, spa.sendv_sndinfo.snd_assoc_id, spa.sendv_sndinfo.snd_sid,
+    spa.sendv_sndinfo.snd_ppid, num_bytes);
+
+  if(num_bytes < 0)
+    rb_raise(rb_eSystemCallError, "sctp_sendv: %s", strerror(errno));
+
+  // With explicit addresses the association isn't known, so it isn't counted
+  if(num_ip == 0)
+    track_sent(self, spa.sendv_sndinfo.snd_assoc_id, num_bytes);
+
+  return LONG2NUM(num_bytes);
+}
+#endif
+
+/*
+ * GVL-release helpers for blocking receive calls.
+ *
+ * usrsctp_recvv blocks on internal userspace locks, not real system calls,
+ * so Ruby's signal-handling thread never gets a chance to run.  By releasing
+ * the GVL around the blocking call, other Ruby threads (including the signal
+ * thread) can execute.  The UBF (unblock function) is invoked by Ruby when
+ * it needs to interrupt the blocking call (e.g. Ctrl-C).
+ *
+ * For native SCTP we use RUBY_UBF_IO which sends a signal that interrupts
+ * the real recvmsg() syscall.  For usrsctp we shut down the read side of
+ * the socket, which causes usrsctp_recvv to return with an error.
+ */
+
+/* --- recvmsg (sctp_recvmsg / usrsctp_recvv via sctp_sys_recvmsg) --- */
+
+struct recvmsg_nogvl_args {
+  sctp_sock_t fd;
+  void       *buf;
+  size_t      len;
+  struct sockaddr *from;
+  socklen_t       *fromlen;
+  struct sctp_sndrcvinfo *sinfo;
+  int        *msg_flags;
+  struct timespec *stamp;
+  ssize_t     result;
+  int         saved_errno;
+};
+
+static void *recvmsg_nogvl(void *arg){
+  struct recvmsg_nogvl_args *a = (struct recvmsg_nogvl_args *)arg;
+
+  if(a->stamp != NULL){
+    a->result = sctp_sys_recvmsg_stamped(a->fd, a->buf, a->len,
+        a->from, a->fromlen, a->sinfo, a->msg_flags, a->stamp);
+  }
+  else{
+    a->result = sctp_sys_recvmsg(a->fd, a->buf, a->len,
+        a->from, a->fromlen, a->sinfo, a->msg_flags);
+  }
+
+  a->saved_errno = errno;
+
+#ifdef HAVE_SYS_SDT_H
+  {
+    // Notifications carry no SNDRCV data, and a failed receive none at all
+    const struct sctp_sndrcvinfo* sinfo = NULL;
+
+    if(a->result >= 0 && !(a->msg_flags != NULL && (*a->msg_flags & MSG_NOTIFICATION)))
+      sinfo = a->sinfo;
+
+    SCTP_PROBE_RECVMSG(a->fd,
+      sinfo ? sinfo->sinfo_assoc_id : 0,
+      sinfo ? sinfo->sinfo_stream : 0,
+      sinfo ? sinfo->sinfo_ppid : 0,
+      a->result, a->result < 0 ? a->saved_errno : 0);
+  }
+#endif
+
+  return NULL;
+}
+
+#ifdef HAVE_USRSCTP_H
+static void recvmsg_ubf(void *arg){
+  struct recvmsg_nogvl_args *a = (struct recvmsg_nogvl_args *)arg;
+  usrsctp_shutdown(a->fd, SHUT_RD);
+}
+#endif
+
+/* --- recvv (sctp_recvv / usrsctp_recvv via sctp_sys_recvv) --- */
+
+struct recvv_nogvl_args {
+  sctp_sock_t fd;
+  const struct iovec *iov;
+  int          iovcnt;
+  struct sockaddr *from;
+  socklen_t       *fromlen;
+  void            *info;
+  socklen_t       *infolen;
+  unsigned int    *infotype;
+  int             *flags;
+  ssize_t          result;
+  int              saved_errno;
+};
+
+static void *recvv_nogvl(void *arg){
+  struct recvv_nogvl_args *a = (struct recvv_nogvl_args *)arg;
+  a->result = sctp_sys_recvv(a->fd, a->iov, a->iovcnt,
+      a->from, a->fromlen, a->info, a->infolen, a->infotype, a->flags);
+  a->saved_errno = errno;
+
+#ifdef HAVE_SYS_SDT_H
+  {
+    // The rcvinfo is the first member of an sctp_recvv_rn as well
+    const struct sctp_rcvinfo* rcvinfo = NULL;
+
+    if(a->result >= 0 && (*a->infotype == SCTP_RECVV_RCVINFO || *a->infotype == SCTP_RECVV_RN))
+      rcvinfo = (const struct sctp_rcvinfo*)a->info;
+
+    SCTP_PROBE_RECVV(a->fd,
+      rcvinfo ? rcvinfo->rcv_assoc_id : 0,
+      rcvinfo ? rcvinfo->rcv_sid : 0,
+      rcvinfo ? rcvinfo->rcv_ppid : 0,
+      a->result, a->result < 0 ? a->saved_errno : 0);
+  }
+#endif
+
+  return NULL;
+}
+
+#ifdef HAVE_USRSCTP_H
+static void recvv_ubf(void *arg){
+  struct recvv_nogvl_args *a = (struct recvv_nogvl_args *)arg;
+  usrsctp_shutdown(a->fd, SHUT_RD);
+}
+#endif
+
+#ifdef HAVE_RB_IO_BUFFER_GET_BYTES_FOR_READING
+/*
+ * When receiving directly into an IO::Buffer the buffer is locked for the
+ * duration of the blocking call, so that it cannot be resized or freed by
+ * another thread in the meantime. These wrappers are used with rb_ensure
+ * so the buffer is always unlocked again, even if the call is interrupted.
+ */
+static VALUE recvmsg_without_gvl(VALUE arg){
+  struct recvmsg_nogvl_args *a = (struct recvmsg_nogvl_args *)arg;
+
+#ifdef HAVE_USRSCTP_H
+  rb_thread_call_without_gvl(recvmsg_nogvl, a, recvmsg_ubf, a);
+#else
+  rb_thread_call_without_gvl(recvmsg_nogvl, a, RUBY_UBF_IO, NULL);
+#endif
+
+  return Qnil;
+}
+
+static VALUE recvv_without_gvl(VALUE arg){
+  struct recvv_nogvl_args *a = (struct recvv_nogvl_args *)arg;
+
+#ifdef HAVE_USRSCTP_H
+  rb_thread_call_without_gvl(recvv_nogvl, a, recvv_ubf, a);
+#else
+  rb_thread_call_without_gvl(recvv_nogvl, a, RUBY_UBF_IO, NULL);
+#endif
+
+  return Qnil;
+}
+#endif
+
+#ifdef HAVE_SCTP_RECVV
+/*
+ * call-seq:
+ *    SCTP::Socket#recvv(flags=0, buffer_size=1024)
+ *    SCTP::Socket#recvv(flags, io_buffer, offset=0)
+ *
+ * Receive a message using sctp_recvv from another SCTP endpoint.
+ *
+ * The optional buffer_size parameter specifies the size of the receive buffer
+ * in bytes. Defaults to 1024 bytes if not specified.
+ *
+ * Alternatively you may pass an IO::Buffer instead of a buffer size, in which
+ * case the message is received directly into that buffer starting at +offset+.
+ * In that case the +message+ member of the returned struct is the number of
+ * bytes that were written into the buffer, rather than a String.
+ *
+ * If SCTP::Socket#next_info= has been enabled, the +next+ member of the
+ * returned struct describes the message that is queued after this one, if
+ * any, so that a suitable buffer size can be chosen for the next call.
+ *
+ * Example:
+ *
+ *   begin
+ *     socket = SCTP::Socket.new
+ *     socket.bind(:port => 62534, :addresses => ['10.0.4.5', '10.0.5.5'])
+ *     socket.listen
+ *
+ *     while true
+ *       info = socket.recvv
+ *       puts "Received message: #{info.message}"
+ *
+ *       # Or with custom buffer size
+ *       info = socket.recvv(0, 4096)
+ *       puts "Received message: #{info.message}"
+ *
+ *       # Or directly into an IO::Buffer
+ *       buffer = IO::Buffer.new(4096)
+ *       info = socket.recvv(0, buffer)
+ *       puts "Received message: #{buffer.get_string(0, info.message)}"
+ *     end
+ *   ensure
+ *     socket.close
+ *   end
+ */
+static VALUE rsctp_recvv(int argc, VALUE* argv, VALUE self){
+  VALUE v_flags, v_buffer_size, v_offset, v_message, v_next;
+  VALUE v_io_buffer = Qnil;
+  sctp_sock_t fileno;
+  int flags, buffer_size;
+  ssize_t bytes;
+  uint infotype;
+  socklen_t infolen;
+  struct iovec iov[1];
+  struct sctp_recvv_rn info;
+  struct sctp_rcvinfo* rcvinfo;
+  char *buffer = NULL;
+
+  bzero(&iov, sizeof(iov));
+  bzero(&info, sizeof(info));
+
+  rb_scan_args(argc, argv, "03", &v_flags, &v_buffer_size, &v_offset);
+
+  CHECK_SOCKET_CLOSED(self);
+
+  fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+
+  enable_recv_rcvinfo(self, fileno);
+
+  if(NIL_P(v_flags))
+    flags = 0;
+  else
+    flags = NUM2INT(v_flags);
+
+#ifdef HAVE_RB_IO_BUFFER_GET_BYTES_FOR_READING
+  if(rb_obj_is_kind_of(v_buffer_size, rb_cIOBuffer)){
+    void* base;
+    size_t size;
+    long offset = 0;
+
+    v_io_buffer = v_buffer_size;
+    rb_io_buffer_get_bytes_for_writing(v_io_buffer, &base, &size);
+
+    if(!NIL_P(v_offset))
+      offset = NUM2LONG(v_offset);
+
+    if(offset < 0 || (size_t)offset >= size)
+      rb_raise(rb_eArgError, "offset is out of range");
+
+    iov->iov_base = (char*)base + offset;
+    iov->iov_len = size - offset;
+  }
+  else
+#endif
+  {
+    if(!NIL_P(v_offset))
+      rb_raise(rb_eArgError, "an offset may only be used with an IO::Buffer");
+
+    if(NIL_P(v_buffer_size))
+      buffer_size = 1024;
+    else
+      buffer_size = NUM2INT(v_buffer_size);
+
+    if(buffer_size <= 0)
+      rb_raise(rb_eArgError, "buffer size must be positive");
+
+    buffer = (char*)malloc(buffer_size);
+    if(buffer == NULL)
+      rb_raise(rb_eNoMemError, "failed to allocate buffer");
+
+    bzero(buffer, buffer_size);
+
+    iov->iov_base = buffer;
+    iov->iov_len = buffer_size;
+  }
+
+  infolen = sizeof(struct sctp_recvv_rn);
+  infotype = 0;
+
+  {
+    struct recvv_nogvl_args recv_args;
+    recv_args.fd       = fileno;
+    recv_args.iov      = iov;
+    recv_args.iovcnt   = 1;
+    recv_args.from     = NULL;
+    recv_args.fromlen  = NULL;
+    recv_args.info     = &info;
+    recv_args.infolen  = &infolen;
+    recv_args.infotype = &infotype;
+    recv_args.flags    = &flags;
+
+#ifdef HAVE_RB_IO_BUFFER_GET_BYTES_FOR_READING
+    if(!NIL_P(v_io_buffer)){
+      rb_io_buffer_lock(v_io_buffer);
+      rb_ensure(recvv_without_gvl, (VALUE)&recv_args, rb_io_buffer_unlock, v_io_buffer);
+    }
+    else
+#endif
+    {
+#ifdef HAVE_USRSCTP_H
+      rb_thread_call_without_gvl(recvv_nogvl, &recv_args, recvv_ubf, &recv_args);
+#else
+      rb_thread_call_without_gvl(recvv_nogvl, &recv_args, RUBY_UBF_IO, NULL);
+#endif
+    }
+
+    bytes = recv_args.result;
+    errno = recv_args.saved_errno;
+  }
+
+  if(bytes < 0){
+    SAFE_FREE(buffer);
+    rb_raise(rb_eSystemCallError, "sctp_recvv: %s", strerror(errno));
+  }
+
+  // With both RCVINFO and NXTINFO enabled we get an sctp_recvv_rn
+  if(infotype == SCTP_RECVV_RN){
+    rcvinfo = &info.recvv_rcvinfo;
+    v_next = rb_struct_new(
+      v_sctp_next_info_struct,
+      UINT2NUM(info.recvv_nxtinfo.nxt_sid),
+      UINT2NUM(info.recvv_nxtinfo.nxt_flags),
+      UINT2NUM(info.recvv_nxtinfo.nxt_ppid),
+      UINT2NUM(info.recvv_nxtinfo.nxt_length),
+      UINT2NUM(info.recvv_nxtinfo.nxt_assoc_id)
+    );
+  }
+  else if(infotype == SCTP_RECVV_RCVINFO){
+    rcvinfo = &info.recvv_rcvinfo;
+    v_next = Qnil;
+  }
+  else{
+    SAFE_FREE(buffer);
+    return Qnil;
+  }
+
+  if(NIL_P(v_io_buffer))
+    v_message = rb_str_new(iov->iov_base, bytes);
+  else
+    v_message = LONG2NUM(bytes);
+
+  SAFE_FREE(buffer);
+
+  return rb_struct_new(
+    v_sctp_receive_info_struct,
+    v_message,
+    UINT2NUM(rcvinfo->rcv_sid),
+    UINT2NUM(rcvinfo->rcv_ssn),
+    UINT2NUM(rcvinfo->rcv_flags),
+    UINT2NUM(rcvinfo->rcv_ppid),
+    UINT2NUM(rcvinfo->rcv_tsn),
+    UINT2NUM(rcvinfo->rcv_cumtsn),
+    UINT2NUM(rcvinfo->rcv_context),
+    UINT2NUM(rcvinfo->rcv_assoc_id),
+    v_next
+  );
+}
+#endif
+
+/*
+ * The native side of SCTP::SendParams. The sndrcvinfo is built once by the
+ * constructor and copied as is on each send.
+ */
+typedef struct {
+  struct sctp_sndrcvinfo info;
+  int has_association_id;
+} sctp_send_params_t;
+
+static size_t send_params_memsize(const void* ptr){
+  return sizeof(sctp_send_params_t);
+}
+
+static const rb_data_type_t send_params_type = {
+  .wrap_struct_name = "SCTP::SendParams",
+  .function = {
+    .dmark = NULL,
+    .dfree = RUBY_TYPED_DEFAULT_FREE,
+    .dsize = send_params_memsize,
+  },
+#ifdef RUBY_TYPED_FROZEN_SHAREABLE
+  .flags = RUBY_TYPED_FREE_IMMEDIATELY | RUBY_TYPED_FROZEN_SHAREABLE
+#else
+  .flags = RUBY_TYPED_FREE_IMMEDIATELY
+#endif
+};
+
+static VALUE rsctp_send_params_alloc(VALUE klass){
+  sctp_send_params_t* params;
+  return TypedData_Make_Struct(klass, sctp_send_params_t, &send_params_type, params);
+}
+
+static sctp_send_params_t* get_send_params(VALUE v_params){
+  return (sctp_send_params_t*)rb_check_typeddata(v_params, &send_params_type);
+}
+
+/*
+ * call-seq:
+ *    SCTP::SendParams.new(options = {})
+ *
+ * Creates a frozen set of send parameters that can be passed to
+ * SCTP::Socket#send or SCTP::Socket#sendmsg in place of an options hash.
+ * The options are parsed once, here, rather than on every send.
+ *
+ * The following options are supported, all of which default to 0:
+ *
+ * * stream: The stream number
+ * * ppid: The payload protocol identifier
+ * * flags: A bitwise OR of the send flags, e.g. SCTP_UNORDERED
+ * * ttl: The lifetime of the message in milliseconds
+ * * context: The context returned if the send fails
+ * * association_id: The association to send on. If omitted, the socket's
+ *     association_id at the time of the send is used.
+ * * pr_policy: A partial reliability policy, one of the SCTP_PR_SCTP_* constants
+ * * pr_value: The value for the policy
+ *
+ * Example:
+ *
+ *   CONTROL = SCTP::SendParams.new(:stream => 0, :ppid => 46)
+ *   MEDIA   = SCTP::SendParams.new(:stream => 1, :ppid => 46, :flags => SCTP::Socket::SCTP_UNORDERED)
+ *
+ *   socket.send("Hello World", CONTROL)
+ */
+static VALUE rsctp_send_params_init(int argc, VALUE* argv, VALUE self){
+  VALUE v_options, v_stream, v_ppid, v_flags, v_ttl, v_context, v_assoc_id;
+  sctp_send_params_t* params;
+  uint32_t flags = 0, ttl = 0;
+
+  rb_check_frozen(self);
+
+  rb_scan_args(argc, argv, "01", &v_options);
+
+  if(NIL_P(v_options))
+    v_options = rb_hash_new();
+
+  Check_Type(v_options, T_HASH);
+
+  params = get_send_params(self);
+
+  v_stream   = rb_hash_aref2(v_options, "stream");
+  v_ppid     = rb_hash_aref2(v_options, "ppid");
+  v_flags    = rb_hash_aref2(v_options, "flags");
+  v_ttl      = rb_hash_aref2(v_options, "ttl");
+  v_context  = rb_hash_aref2(v_options, "context");
+  v_assoc_id = rb_hash_aref2(v_options, "association_id");
+
+  if(!NIL_P(v_flags))
+    flags = NUM2UINT(v_flags);
+
+  if(!NIL_P(v_ttl)){
+    ttl = NUM2UINT(v_ttl);
+    flags |= SCTP_PR_SCTP_TTL;
+  }
+
+  apply_pr_options(v_options, &flags, &ttl);
+
+  bzero(&params->info, sizeof(params->info));
+
+  if(!NIL_P(v_stream))
+    params->info.sinfo_stream = NUM2USHORT(v_stream);
+
+  if(!NIL_P(v_ppid))
+    params->info.sinfo_ppid = NUM2UINT(v_ppid);
+
+  if(!NIL_P(v_context))
+    params->info.sinfo_context = NUM2UINT(v_context);
+
+  params->info.sinfo_flags = flags;
+  params->info.sinfo_timetolive = ttl;
+
+  if(NIL_P(v_assoc_id)){
+    params->has_association_id = 0;
+  }
+  else{
+    params->info.sinfo_assoc_id = NUM2INT(v_assoc_id);
+    params->has_association_id = 1;
+  }
+
+  rb_obj_freeze(self);
+
+  return self;
+}
+
+/* call-seq: SCTP::SendParams#stream */
+static VALUE rsctp_send_params_stream(VALUE self){
+  return UINT2NUM(get_send_params(self)->info.sinfo_stream);
+}
+
+/* call-seq: SCTP::SendParams#ppid */
+static VALUE rsctp_send_params_ppid(VALUE self){
+  return UINT2NUM(get_send_params(self)->info.sinfo_ppid);
+}
+
+/* call-seq: SCTP::SendParams#flags */
+static VALUE rsctp_send_params_flags(VALUE self){
+  return UINT2NUM(get_send_params(self)->info.sinfo_flags);
+}
+
+/* call-seq: SCTP::SendParams#ttl */
+static VALUE rsctp_send_params_ttl(VALUE self){
+  return UINT2NUM(get_send_params(self)->info.sinfo_timetolive);
+}
+
+/* call-seq: SCTP::SendParams#context */
+static VALUE rsctp_send_params_context(VALUE self){
+  return UINT2NUM(get_send_params(self)->info.sinfo_context);
+}
+
+/*
+ * call-seq:
+ *    SCTP::SendParams#association_id
+ *
+ * Returns the association id, or nil if the socket's is used.
+ */
+static VALUE rsctp_send_params_association_id(VALUE self){
+  sctp_send_params_t* params = get_send_params(self);
+
+  if(!params->has_association_id)
+    return Qnil;
+
+  return INT2NUM(params->info.sinfo_assoc_id);
+}
+
+/*
+* Helper function for the send(message, params) and sendmsg(message, params)
+* forms. Sends with a copy of the precompiled sndrcvinfo.
+*/
+static VALUE send_with_params(VALUE self, VALUE v_msg, VALUE v_params){
+  sctp_send_params_t* params;
+  sctp_latency_t* latency;
+  struct timespec start;
+  struct sctp_sndrcvinfo info;
+  sctp_sock_t fileno;
+  ssize_t num_bytes;
+  const char* msg;
+  size_t msg_len;
+
+  if(!rb_typeddata_is_kind_of(v_params, &send_params_type))
+    rb_raise(rb_eTypeError, "params must be an SCTP::SendParams");
+
+  params = get_send_params(v_params);
+
+  CHECK_SOCKET_CLOSED(self);
+
+  info = params->info;
+
+  if(!params->has_association_id)
+    info.sinfo_assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
+
+  fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+  msg = get_payload(v_msg, Qnil, Qnil, &msg_len);
+
+  latency = get_latency(self);
+
+  if(latency != NULL)
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+  num_bytes = (ssize_t)sctp_sys_send(fileno, msg, msg_len, &info, 0);
+
+  SCTP_PROBE_SEND(fileno, info.sinfo_assoc_id, info.sinfo_stream, info.sinfo_ppid, num_bytes);
+
+  if(latency != NULL)
+    record_latency_since(&latency->send, CLOCK_MONOTONIC, &start);
+
+  if(num_bytes < 0)
+    rb_raise(rb_eSystemCallError, "sctp_send: %s", strerror(errno));
+
+  track_sent(self, info.sinfo_assoc_id, num_bytes);
+
+  return LONG2NUM(num_bytes);
+}
+
+/*
+ * call-seq:
+ *    SCTP::Socket.send(options)
+ *    SCTP::Socket.send(message, params)
+ *
+ * Send a message on an already-connected socket to a specific association.
+ *
+ * Example:
+ *
+ *   socket = SCTP::Socket.new
+ *   socket.connect(:port => 42000, :addresses => ['10.0.4.5', '10.0.5.5'])
+ *
+ *   socket.send(:message => "Hello World")
+ *   socket.send(:message => "Hello World", :association_id => 37)
+ *
+ * A partial reliability policy may be set per message with the :pr_policy
+ * and :pr_value options, e.g. to abandon a message after 2 retransmissions:
+ *
+ *   socket.send(
+ *     :message   => "Hello World",
+ *     :pr_policy => SCTP::Socket::SCTP_PR_SCTP_RTX,
+ *     :pr_value  => 2
+ *   )
+ *
+ * The message may also be an IO::Buffer, in which case the optional :offset
+ * and :length options select the portion of the buffer to send without
+ * copying it. These options work for strings as well.
+ *
+ *   buffer = IO::Buffer.map(File.open('records.bin'))
+ *   socket.send(:message => buffer, :offset => 128, :length => 512)
+ *
+ * For parameters that are reused for many messages, pass an SCTP::SendParams
+ * after the message instead of an options hash:
+ *
+ *   params = SCTP::SendParams.new(:stream => 2, :ppid => 46)
+ *   socket.send("Hello World", params)
+ */
+static VALUE rsctp_send(int argc, VALUE* argv, VALUE self){
+  uint16_t stream;
+  uint32_t ppid, send_flags, ctrl_flags, ttl, context;
+  ssize_t num_bytes;
+  sctp_sock_t fileno;
+  sctp_assoc_t assoc_id;
+  struct sctp_sndrcvinfo info;
+  sctp_latency_t* latency;
+  struct timespec start;
+  VALUE v_msg, v_stream, v_ppid, v_context, v_send_flags, v_ctrl_flags, v_ttl, v_assoc_id;
+  VALUE v_options, v_params, v_offset, v_length;
+  const char* msg;
+  size_t msg_len;
+
+  rb_scan_args(argc, argv, "11", &v_options, &v_params);
+
+  if(!NIL_P(v_params)){
+    if(RB_TYPE_P(v_options, T_HASH))
+      rb_raise(rb_eArgError, "wrong number of arguments (given 2, expected 1)");
+
+    return send_with_params(self, v_options, v_params);
+  }
+
+  Check_Type(v_options, T_HASH);
+
+  v_msg        = rb_hash_aref2(v_options, "message");
+  v_stream     = rb_hash_aref2(v_options, "stream");
+  v_ppid       = rb_hash_aref2(v_options, "ppid");
+  v_context    = rb_hash_aref2(v_options, "context");
+  v_send_flags = rb_hash_aref2(v_options, "send_flags");
+  v_ctrl_flags = rb_hash_aref2(v_options, "control_flags");
+  v_ttl        = rb_hash_aref2(v_options, "ttl");
+  v_assoc_id   = rb_hash_aref2(v_options, "association_id");
+  v_offset     = rb_hash_aref2(v_options, "offset");
+  v_length     = rb_hash_aref2(v_options, "length");
+
+  if(NIL_P(v_stream))
+    stream = 0;
+  else
+    stream = NUM2INT(v_stream);
+
+  if(NIL_P(v_send_flags))
+    send_flags = 0;
+  else
+    send_flags = NUM2INT(v_send_flags);
+
+  if(NIL_P(v_ctrl_flags))
+    ctrl_flags = 0;
+  else
+    ctrl_flags = NUM2INT(v_ctrl_flags);
+
+  if(NIL_P(v_ttl)){
+    ttl = 0;
+  }
+  else{
+    ttl = NUM2INT(v_ttl);
+    send_flags |= SCTP_PR_SCTP_TTL;
+  }
+
+  apply_pr_options(v_options, &send_flags, &ttl);
+
+  if(NIL_P(v_ppid))
+    ppid = 0;
+  else
+    ppid = NUM2INT(v_ppid);
+
+  if(NIL_P(v_context))
+    context = 0;
+  else
+    context = NUM2INT(v_context);
+
+  if(NIL_P(v_assoc_id))
+    assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
+  else
+    assoc_id = NUM2INT(v_assoc_id);
+
+  CHECK_SOCKET_CLOSED(self);
+
+  info.sinfo_stream = stream;
+  info.sinfo_flags = send_flags;
+  info.sinfo_ppid = ppid;
+  info.sinfo_context = context;
+  info.sinfo_timetolive = ttl;
+  info.sinfo_assoc_id = assoc_id;
+
+  fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+  msg = get_payload(v_msg, v_offset, v_length, &msg_len);
+
+  latency = get_latency(self);
+
+  if(latency != NULL)
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+  num_bytes = (ssize_t)sctp_sys_send(
+    fileno,
+    msg,
+    msg_len,
+    &info,
+    ctrl_flags
+  );
+
+  SCTP_PROBE_SEND(fileno, assoc_id, stream, ppid, num_bytes);
+
+  if(latency != NULL)
+    record_latency_since(&latency->send, CLOCK_MONOTONIC, &start);
+
+  if(num_bytes < 0)
+    rb_raise(rb_eSystemCallError, "sctp_send: %s", strerror(errno));
+
+  track_sent(self, assoc_id, num_bytes);
+
+  return LONG2NUM(num_bytes);
+}
+
+#ifdef HAVE_SYS_SDT_H
+/*
+* Look up the association that a sendmsg call with explicit addresses went
+* to, for the sctp:sendmsg probe. This is the association of the first
+* address, or 0 if the kernel doesn't know it.
+*
+* @param fileno The socket file descriptor
+* @param domain The socket domain, AF_INET or AF_INET6
+* @param v_address The first address the message was sent to
+* @param v_options The options passed to sendmsg, for the port
+* @return The association id
+*/
+static sctp_assoc_t sendmsg_association_id(sctp_sock_t fileno, int domain, VALUE v_address, VALUE v_options){
+  struct sctp_paddrinfo spinfo;
+  socklen_t size = sizeof(spinfo);
+  VALUE v_port = rb_hash_aref2(v_options, "port");
+  int port = NIL_P(v_port) ? 0 : NUM2INT(v_port);
+
+  bzero(&spinfo, sizeof(spinfo));
+
+  if(domain == AF_INET6)
+    parse_ip_address_v6(StringValueCStr(v_address), port, (struct sockaddr_in6*)&spinfo.spinfo_address);
+  else
+    parse_ip_address_v4(StringValueCStr(v_address), port, (struct sockaddr_in*)&spinfo.spinfo_address);
+
+  if(sctp_sys_opt_info(fileno, 0, SCTP_GET_PEER_ADDR_INFO, (void*)&spinfo, &size) < 0)
+    return 0;
+
+  return spinfo.spinfo_assoc_id;
+}
+#endif
+
+/*
+ * call-seq:
+ *    SCTP::Socket#sendmsg(options)
+ *    SCTP::Socket#sendmsg(message, params)
+ *
+ * Transmit a message to an SCTP endpoint. The following hash of options
+ * is permitted:
+ *
+ *  :message   -> The message to send to the endpoint. Mandatory.
+ *  :stream    -> The SCTP stream number you wish to send the message on.
+ *  :addresses -> An array of addresses to send the message to.
+ *  :context   -> The default context used for the sendmsg call if the send fails.
+ *  :ppid      -> The payload protocol identifier that is passed to the peer endpoint.
+ *  :flags     -> A bitwise integer that contain one or more values that control behavior.
+ *  :offset    -> The offset into the message at which to start sending. Default is 0.
+ *  :length    -> The number of bytes of the message to send. Default is the rest of it.
+ *  :ttl       -> The lifetime of the message in milliseconds, after which it is abandoned.
+ *  :pr_policy -> A partial reliability policy, one of the SCTP_PR_SCTP_* constants.
+ *  :pr_value  -> The value for the policy, e.g. a lifetime in milliseconds for
+ *                SCTP_PR_SCTP_TTL or the maximum number of retransmissions for
+ *                SCTP_PR_SCTP_RTX.
+ *
+ *  The message may be a String or an IO::Buffer. An IO::Buffer, e.g. one that wraps
+ *  a memory mapped file or shared memory, is passed to the SCTP stack without first
+ *  being copied into a String.
+ *
+ *  Note that the :addresses option is not mandatory in a one-to-one (SOCK_STREAM)
+ *  socket connection. However, it must have been set previously via the
+ *  connect method.
+ *
+ *  Example:
+ *
+ *    socket = SCTP::Socket.new
+ *
+ *    socket.sendmsg(
+ *      :message   => "Hello World!",
+ *      :stream    => 3,
+ *      :flags     => SCTP::Socket::SCTP_UNORDERED | SCTP::Socket::SCTP_SENDALL,
+ *      :ttl       => 100,
+ *      :addresses => ['10.0.5.4', '10.0.6.4']
+ *    )
+ *
+ *  Alternatively, pass the message followed by an SCTP::SendParams, in which
+ *  case the message is sent on the association given by the params, or the
+ *  socket's association_id, as with SCTP::Socket#send.
+ *
+ *  Returns the number of bytes sent.
+ */
+static VALUE rsctp_sendmsg(int argc, VALUE* argv, VALUE self){
+  VALUE v_msg, v_ppid, v_flags, v_stream, v_ttl, v_context, v_addresses;
+  VALUE v_options, v_params, v_offset, v_length;
+  uint16_t stream;
+  uint32_t ppid, flags, ttl, context;
+  ssize_t num_bytes;
+  sctp_sock_t fileno;
+  int num_ip, domain;
+  const char* msg;
+  size_t msg_len;
+  sctp_latency_t* latency;
+  struct timespec start;
+
+  rb_scan_args(argc, argv, "11", &v_options, &v_params);
+
+  if(!NIL_P(v_params)){
+    if(RB_TYPE_P(v_options, T_HASH))
+      rb_raise(rb_eArgError, "wrong number of arguments (given 2, expected 1)");
+
+    return send_with_params(self, v_options, v_params);
+  }
+
+  Check_Type(v_options, T_HASH);
+
+  v_msg       = rb_hash_aref2(v_options, "message");
+  v_stream    = rb_hash_aref2(v_options, "stream");
+  v_ppid      = rb_hash_aref2(v_options, "ppid");
+  v_context   = rb_hash_aref2(v_options, "context");
+  v_flags     = rb_hash_aref2(v_options, "flags");
+  v_ttl       = rb_hash_aref2(v_options, "ttl");
+  v_addresses = rb_hash_aref2(v_options, "addresses");
+  v_offset    = rb_hash_aref2(v_options, "offset");
+  v_length    = rb_hash_aref2(v_options, "length");
+
+  if(NIL_P(v_msg))
+    rb_raise(rb_eArgError, "message parameter is required");
+
+  if(NIL_P(v_stream))
+    stream = 0;
+  else
+    stream = NUM2INT(v_stream);
+
+  if(NIL_P(v_flags))
+    flags = 0;
+  else
+    flags = NUM2INT(v_flags);
+
+  if(NIL_P(v_ttl)){
+    ttl = 0;
+  }
+  else{
+    ttl = NUM2INT(v_ttl);
+    flags |= SCTP_PR_SCTP_TTL;
+  }
+
+  apply_pr_options(v_options, &flags, &ttl);
+
+  if(NIL_P(v_ppid))
+    ppid = 0;
+  else
+    ppid = NUM2INT(v_ppid);
+
+  if(NIL_P(v_context))
+    context = 0;
+  else
+    context = NUM2INT(v_context);
+
+  CHECK_SOCKET_CLOSED(self);
+
+  fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+  domain = NUM2INT(rb_iv_get(self, "@domain"));
+  msg = get_payload(v_msg, v_offset, v_length, &msg_len);
+  latency = get_latency(self);
+
+  if(latency != NULL)
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+  if(!NIL_P(v_addresses)){
+    int i, port;
+    VALUE v_address, v_port;
+
+    Check_Type(v_addresses, T_ARRAY);
+    num_ip = (int)RARRAY_LEN(v_addresses);
+
+    if(num_ip > MAX_IP_ADDRESSES)
+      rb_raise(rb_eArgError, "too many IP addresses, maximum is eight");
+
+    v_port = rb_hash_aref2(v_options, "port");
+
+    if(NIL_P(v_port))
+      port = 0;
+    else
+      port = NUM2INT(v_port);
+
+    if(domain == AF_INET6){
+      struct sockaddr_in6 addrs6[MAX_IP_ADDRESSES];
+
+      bzero(&addrs6, sizeof(addrs6));
+
+      for(i = 0; i < num_ip; i++){
+        v_address = RARRAY_AREF(v_addresses, i);
+        parse_ip_address_v6(StringValueCStr(v_address), port, &addrs6[i]);
+      }
+
+      num_bytes = (ssize_t)sctp_sys_sendmsg(
+        fileno,
+        msg,
+        msg_len,
+        (struct sockaddr*)addrs6,
+        num_ip,
+        ppid,
+        flags,
+        stream,
+        ttl,
+        context
+      );
+    }
+    else{
+      struct sockaddr_in addrs[MAX_IP_ADDRESSES];
+
+      bzero(&addrs, sizeof(addrs));
+
+      for(i = 0; i < num_ip; i++){
+        v_address = RARRAY_AREF(v_addresses, i);
+        parse_ip_address_v4(StringValueCStr(v_address), port, &addrs[i]);
+      }
+
+      num_bytes = (ssize_t)sctp_sys_sendmsg(
+        fileno,
+        msg,
+        msg_len,
+        (struct sockaddr*)addrs,
+        num_ip,
+        ppid,
+        flags,
+        stream,
+        ttl,
+        context
+      );
+    }
+  }
+  else{
+    // No addresses - use empty addrs
+    num_ip = 0;
+    num_bytes = (ssize_t)sctp_sys_sendmsg(
+      fileno,
+      msg,
+      msg_len,
+      NULL,
+      0,
+      ppid,
+      flags,
+      stream,
+      ttl,
+      context
+    );
+  }
+
+#ifdef HAVE_SYS_SDT_H
+  if(SCTP_PROBE_ENABLED(sendmsg)){
+    sctp_assoc_t assoc_id;
+
+    if(num_ip > 0 && num_bytes >= 0)
+      assoc_id = sendmsg_association_id(fileno, domain, RARRAY_AREF(v_addresses, 0), v_options);
+    else
+      assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
+
+    SCTP_PROBE_SENDMSG(fileno, assoc_id, stream, ppid, num_bytes);
+  }
+#endif
+
+  if(latency != NULL)
+    record_latency_since(&latency->send, CLOCK_MONOTONIC, &start);
+
+  if(num_bytes < 0)
+    rb_raise(rb_eSystemCallError, "sctp_sendmsg: %s", strerror(errno));
+
+  // With explicit addresses the association isn't known, so it isn't counted
+  if(num_ip == 0)
+    track_sent(self, NUM2INT(rb_iv_get(self, "@association_id")), num_bytes);
+
+  return LONG2NUM(num_bytes);
+}
+
+/*
+ * Helper function that receives a single complete message, reassembling it
+ * from as many partial deliveries as it takes to see MSG_EOR.
+ *
+ * The message is read chunk_size bytes at a time directly into the tail of
+ * a Ruby string, whose capacity is doubled as needed, so there is no
+ * intermediate buffer and no concatenation of partial strings. If a
+ * notification arrives before the message is complete, e.g. a partial
+ * delivery abort, the partial data is discarded and the notification is
+ * returned in its place. Notifications that cannot be decoded are skipped.
+ *
+ * If the message grows beyond max_size bytes the rest of it is read and
+ * discarded, so the next receive starts on a message boundary, and a
+ * RangeError is raised.
+ *
+ * If stamp is not NULL it receives the kernel arrival time of the last
+ * chunk read, or zero if there was none.
+ */
+static VALUE recvmsg_reassemble(
+  VALUE self,
+  sctp_sock_t fileno,
+  int flags,
+  long chunk_size,
+  long max_size,
+  struct sctp_sndrcvinfo* sndrcvinfo,
+  struct sockaddr_storage* clientaddr,
+  socklen_t* length,
+  int* msg_flags,
+  VALUE* v_notification,
+  struct timespec* stamp
+){
+  VALUE v_message;
+  ssize_t bytes;
+  long total = 0;
+  int truncated = 0;
+  int in_notification = 0;
+
+  v_message = rb_str_buf_new(chunk_size);
+
+  while(1){
+    char* tail;
+
+    // Once the limit is exceeded keep reusing the same chunk to drain the rest
+    if(truncated)
+      total = 0;
+
+    // Grow geometrically, so a large message is not copied once per chunk
+    if((long)rb_str_capacity(v_message) < total + chunk_size){
+      long capa = (long)rb_str_capacity(v_message) * 2;
+      long limit = max_size > LONG_MAX - chunk_size ? LONG_MAX : max_size + chunk_size;
+
+      if(capa > limit)
+        capa = limit;
+
+      if(capa < total + chunk_size)
+        capa = total + chunk_size;
+
+      rb_str_modify_expand(v_message, capa - RSTRING_LEN(v_message));
+    }
+
+    tail = RSTRING_PTR(v_message) + total;
+
+    *length = sizeof(struct sockaddr_storage);
+    *msg_flags = flags;
+
+    {
+      struct recvmsg_nogvl_args recv_args;
+      recv_args.fd        = fileno;
+      recv_args.buf       = tail;
+      recv_args.len       = chunk_size;
+      recv_args.from      = (struct sockaddr*)clientaddr;
+      recv_args.fromlen   = length;
+      recv_args.sinfo     = sndrcvinfo;
+      recv_args.msg_flags = msg_flags;
+      recv_args.stamp     = stamp;
+
+#ifdef HAVE_USRSCTP_H
+      rb_thread_call_without_gvl(recvmsg_nogvl, &recv_args, recvmsg_ubf, &recv_args);
+#else
+      rb_thread_call_without_gvl(recvmsg_nogvl, &recv_args, RUBY_UBF_IO, NULL);
+#endif
+
+      bytes = recv_args.result;
+      errno = recv_args.saved_errno;
+    }
+
+    if(bytes < 0)
+      rb_raise(rb_eSystemCallError, "sctp_recvmsg: %s", strerror(errno));
+
+    if(*msg_flags & MSG_NOTIFICATION){
+      // A notification larger than a chunk arrives in pieces, none of which
+      // can be decoded, so skip them all
+      if(in_notification || !notification_complete(tail, bytes, *msg_flags)){
+        in_notification = !(*msg_flags & MSG_EOR);
+        continue;
+      }
+
+      track_notification(self, tail, bytes, *msg_flags);
+
+      if(notification_filtered(self, tail, bytes, *msg_flags)){
+        // A swallowed partial delivery abort still ends the partial message
+        if(((union sctp_notification*)tail)->sn_header.sn_type == SCTP_PARTIAL_DELIVERY_EVENT){
+          if(truncated)
+            break;
+
+          total = 0;
+        }
+
+        continue;
+      }
+
+      *v_notification = get_notification_info(tail, bytes);
+
+      if(!NIL_P(*v_notification))
+        return Qnil;
+
+      // Never hand a notification that could not be decoded out as data
+      continue;
+    }
+
+    total += bytes;
+    rb_str_set_len(v_message, total);
+
+    if(*msg_flags & MSG_EOR || bytes == 0)
+      break;
+
+    if(!truncated && total > max_size)
+      truncated = 1;
+  }
+
+  if(truncated || total > max_size)
+    rb_raise(rb_eRangeError, "message exceeds maximum size of %ld bytes", max_size);
+
+  return v_message;
+}
+
+/*
+ * call-seq:
+ *    SCTP::Socket#recvmsg(flags=0, buffer_size=1024, max_message_size=nil)
+ *
+ * Receive a message from another SCTP endpoint.
+ *
+ * The optional buffer_size parameter specifies the size of the receive buffer
+ * in bytes. Defaults to 1024 bytes if not specified.
+ *
+ * By default a message that is larger than the buffer is returned in pieces
+ * over several calls. Check the +msg_flags+ member of the returned struct for
+ * MSG_EOR to tell if you have the end of a message.
+ *
+ * If a max_message_size is given then recvmsg will instead reassemble the
+ * pieces itself, reading buffer_size bytes at a time, and return
+ * the whole message as one string. If a partial delivery is aborted by the
+ * peer, the partial data is discarded and the partial delivery notification
+ * is returned instead. A RangeError is raised if the message is larger than
+ * max_message_size bytes, after the rest of it has been discarded.
+ *
+ * Example:
+ *
+ *   begin
+ *     socket = SCTP::Socket.new
+ *     socket.bind(:port => 62534, :addresses => ['10.0.4.5', '10.0.5.5'])
+ *     socket.subscribe(:data_io => 1)
+ *     socket.listen
+ *
+ *     while true
+ *       info = socket.recvmsg
+ *       puts "Received message: #{info.message}"
+ *
+ *       # Or with custom buffer size
+ *       info = socket.recvmsg(0, 4096)
+ *       puts "Received message: #{info.message}"
+ *
+ *       # Or reassemble messages up to 1MB in 64KB chunks
+ *       info = socket.recvmsg(0, 65536, 1024 * 1024)
+ *       puts "Received message: #{info.message.bytesize} bytes"
+ *     end
+ *   ensure
+ *     socket.close
+ *   end
+ */
+static VALUE rsctp_recvmsg(int argc, VALUE* argv, VALUE self){
+  VALUE v_flags, v_buffer_size, v_max_size, v_notification, v_message;
+  struct sctp_sndrcvinfo sndrcvinfo;
+  struct sockaddr_storage clientaddr;
+  struct timespec stamp;
+  sctp_latency_t* latency;
+  sctp_sock_t fileno;
+  int flags, recv_flags, buffer_size;
+  ssize_t bytes;
+  char *buffer;
+  socklen_t length;
+
+  rb_scan_args(argc, argv, "03", &v_flags, &v_buffer_size, &v_max_size);
+
+  if(NIL_P(v_flags))
+    flags = 0;
+  else
+    flags = NUM2INT(v_flags);
+
+  if(NIL_P(v_buffer_size))
+    buffer_size = 1024;
+  else
+    buffer_size = NUM2INT(v_buffer_size);
+
+  if(buffer_size <= 0)
+    rb_raise(rb_eArgError, "buffer size must be positive");
+
+  CHECK_SOCKET_CLOSED(self);
+
+  fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+
+#ifdef HAVE_USRSCTP_H
+  // usrsctp only reports the stream and ppid with SCTP_RECVRCVINFO enabled
+  enable_recv_rcvinfo(self, fileno);
+#endif
+
+  latency = get_latency(self);
+  bzero(&stamp, sizeof(stamp));
+
+  if(!NIL_P(v_max_size)){
+    long max_size = NUM2LONG(v_max_size);
+
+    if(max_size <= 0)
+      rb_raise(rb_eArgError, "max message size must be positive");
+
+    bzero(&clientaddr, sizeof(clientaddr));
+    bzero(&sndrcvinfo, sizeof(sndrcvinfo));
+
+    v_notification = Qnil;
+
+    v_message = recvmsg_reassemble(
+      self,
+      fileno,
+      flags,
+      buffer_size,
+      max_size,
+      &sndrcvinfo,
+      &clientaddr,
+      &length,
+      &flags,
+      &v_notification,
+      latency != NULL ? &stamp : NULL
+    );
+  }
+  else{
+    buffer = (char*)malloc(buffer_size);
+    if(buffer == NULL)
+      rb_raise(rb_eNoMemError, "failed to allocate buffer");
+
+    recv_flags = flags;
+
+    // Receive again whenever the notification filter swallows a notification
+    do{
+      length = sizeof(struct sockaddr_storage);
+      flags = recv_flags;
+
+      bzero(buffer, buffer_size);
+      bzero(&clientaddr, sizeof(clientaddr));
+      bzero(&sndrcvinfo, sizeof(sndrcvinfo));
+
+      {
+        struct recvmsg_nogvl_args recv_args;
+        recv_args.fd       = fileno;
+        recv_args.buf      = buffer;
+        recv_args.len      = buffer_size;
+        recv_args.from     = (struct sockaddr*)&clientaddr;
+        recv_args.fromlen  = &length;
+        recv_args.sinfo    = &sndrcvinfo;
+        recv_args.msg_flags = &flags;
+        recv_args.stamp    = latency != NULL ? &stamp : NULL;
+
+#ifdef HAVE_USRSCTP_H
+        rb_thread_call_without_gvl(recvmsg_nogvl, &recv_args, recvmsg_ubf, &recv_args);
+#else
+        rb_thread_call_without_gvl(recvmsg_nogvl, &recv_args, RUBY_UBF_IO, NULL);
+#endif
+
+        bytes = recv_args.result;
+        errno = recv_args.saved_errno;
+      }
+
+      if(bytes < 0){
+        free(buffer);
+        rb_raise(rb_eSystemCallError, "sctp_recvmsg: %s", strerror(errno));
+      }
+
+      if(flags & MSG_NOTIFICATION)
+        track_notification(self, buffer, bytes, flags);
+    } while((flags & MSG_NOTIFICATION) && notification_filtered(self, buffer, bytes, flags));
+
+    v_notification = Qnil;
+
+    if((flags & MSG_NOTIFICATION) && notification_complete(buffer, bytes, flags))
+      v_notification = get_notification_info(buffer, bytes);
+
+    if(NIL_P(v_notification))
+      v_message = rb_str_new(buffer, bytes);
+    else
+      v_message = Qnil;
+
+    free(buffer);
+  }
+
+  if(latency != NULL && stamp.tv_sec != 0)
+    record_latency_since(&latency->receive, CLOCK_REALTIME, &stamp);
+
+  if(NIL_P(v_notification))
+    track_activity(self, sndrcvinfo.sinfo_assoc_id);
+
+  return rb_struct_new(v_sndrcv_struct,
+    v_message,
+    UINT2NUM(sndrcvinfo.sinfo_stream),
+    UINT2NUM(sndrcvinfo.sinfo_flags),
+    UINT2NUM(sndrcvinfo.sinfo_ppid),
+    UINT2NUM(sndrcvinfo.sinfo_context),
+    UINT2NUM(sndrcvinfo.sinfo_timetolive),
+    UINT2NUM(sndrcvinfo.sinfo_assoc_id),
+    v_notification,
+    get_cached_client(self, sndrcvinfo.sinfo_assoc_id, &clientaddr, length),
+    INT2NUM(flags)
+  );
+}
+
+/*
+ * The native side of SCTP::Message. Only the payload is a Ruby object up
+ * front. The notification and client address are built from the raw
+ * structs the first time they're asked for, and then cached.
+ */
+typedef struct {
+  VALUE payload;
+  VALUE notification;
+  VALUE client;
+  struct sctp_sndrcvinfo info;
+  struct sockaddr_storage addr;
+  socklen_t addrlen;
+  int msg_flags;
+  struct timespec stamp;
+} sctp_message_t;
+
+static void message_mark(void* ptr){
+  sctp_message_t* msg = (sctp_message_t*)ptr;
+  rb_gc_mark(msg->payload);
+  rb_gc_mark(msg->notification);
+  rb_gc_mark(msg->client);
+}
+
+static size_t message_memsize(const void* ptr){
+  return sizeof(sctp_message_t);
+}
+
+static const rb_data_type_t message_type = {
+  .wrap_struct_name = "SCTP::Message",
+  .function = {
+    .dmark = message_mark,
+    .dfree = RUBY_TYPED_DEFAULT_FREE,
+    .dsize = message_memsize,
+  },
+  .flags = RUBY_TYPED_FREE_IMMEDIATELY
+};
+
+static VALUE rsctp_message_alloc(VALUE klass){
+  sctp_message_t* msg;
+  VALUE self = TypedData_Make_Struct(klass, sctp_message_t, &message_type, msg);
+
+  msg->payload = Qnil;
+  msg->notification = Qnil;
+  msg->client = Qnil;
+
+  return self;
+}
+
+static sctp_message_t* get_message(VALUE self){
+  return (sctp_message_t*)rb_check_typeddata(self, &message_type);
+}
+
+/*
+ * call-seq:
+ *    SCTP::Message#message
+ *
+ * Returns the payload as a String, or nil if this is a notification.
+ */
+static VALUE rsctp_message_message(VALUE self){
+  sctp_message_t* msg = get_message(self);
+
+  if(msg->msg_flags & MSG_NOTIFICATION)
+    return Qnil;
+
+  return msg->payload;
+}
+
+/*
+ * call-seq:
+ *    SCTP::Message#notification
+ *
+ * Returns the notification struct, e.g. an AssocChange, or nil if this is
+ * a data message.
+ */
+static VALUE rsctp_message_notification(VALUE self){
+  sctp_message_t* msg = get_message(self);
+
+  if(!(msg->msg_flags & MSG_NOTIFICATION))
+    return Qnil;
+
+  if(!notification_complete(RSTRING_PTR(msg->payload), RSTRING_LEN(msg->payload), msg->msg_flags))
+    return Qnil;
+
+  if(NIL_P(msg->notification))
+    RB_OBJ_WRITE(self, &msg->notification, get_notification_info(RSTRING_PTR(msg->payload), RSTRING_LEN(msg->payload)));
+
+  return msg->notification;
+}
+
+/*
+ * call-seq:
+ *    SCTP::Message#notification?
+ *
+ * Returns whether or not this is a notification rather than data. Unlike
+ * SCTP::Message#notification this doesn't decode it.
+ */
+static VALUE rsctp_message_notification_p(VALUE self){
+  return (get_message(self)->msg_flags & MSG_NOTIFICATION) ? Qtrue : Qfalse;
+}
+
+/*
+ * call-seq:
+ *    SCTP::Message#client
+ *
+ * Returns the sender's address as a SockAddrIn struct.
+ */
+static VALUE rsctp_message_client(VALUE self){
+  sctp_message_t* msg = get_message(self);
+
+  if(NIL_P(msg->client) && msg->addrlen > 0)
+    RB_OBJ_WRITE(self, &msg->client, convert_sockaddr_in_to_struct((struct sockaddr_in*)&msg->addr));
+
+  return msg->client;
+}
+
+/* call-seq: SCTP::Message#stream */
+static VALUE rsctp_message_stream(VALUE self){
+  return UINT2NUM(get_message(self)->info.sinfo_stream);
+}
+
+/* call-seq: SCTP::Message#flags */
+static VALUE rsctp_message_flags(VALUE self){
+  return UINT2NUM(get_message(self)->info.sinfo_flags);
+}
+
+/* call-seq: SCTP::Message#ppid */
+static VALUE rsctp_message_ppid(VALUE self){
+  return UINT2NUM(get_message(self)->info.sinfo_ppid);
+}
+
+/* call-seq: SCTP::Message#context */
+static VALUE rsctp_message_context(VALUE self){
+  return UINT2NUM(get_message(self)->info.sinfo_context);
+}
+
+/* call-seq: SCTP::Message#ttl */
+static VALUE rsctp_message_ttl(VALUE self){
+  return UINT2NUM(get_message(self)->info.sinfo_timetolive);
+}
+
+/* call-seq: SCTP::Message#association_id */
+static VALUE rsctp_message_association_id(VALUE self){
+  return UINT2NUM(get_message(self)->info.sinfo_assoc_id);
+}
+
+/* call-seq: SCTP::Message#msg_flags */
+static VALUE rsctp_message_msg_flags(VALUE self){
+  return INT2NUM(get_message(self)->msg_flags);
+}
+
+/*
+ * call-seq:
+ *    SCTP::Message#timestamp
+ *
+ * Returns the time at which the kernel received the message as a Time, or
+ * nil if timestamps weren't enabled with SCTP::Socket#timestamps= when it
+ * was received, or the platform doesn't provide them.
+ */
+static VALUE rsctp_message_timestamp(VALUE self){
+  sctp_message_t* msg = get_message(self);
+
+  if(msg->stamp.tv_sec == 0)
+    return Qnil;
+
+  return rb_time_nano_new(msg->stamp.tv_sec, msg->stamp.tv_nsec);
+}
+
+/*
+ * call-seq:
+ *    SCTP::Socket#recv_message(flags=0, buffer_size=1024)
+ *
+ * Receive a message from another SCTP endpoint, like SCTP::Socket#recvmsg,
+ * but return an SCTP::Message instead of a SendReceiveInfo struct.
+ *
+ * The message is read directly into its payload String, and the
+ * SCTP::Message keeps the raw receive info. The notification and client
+ * address are only converted to Ruby objects if their accessors are called.
+ * A receive loop that only looks at the payload, stream and ppid therefore
+ * allocates two objects per message instead of five or more.
+ *
+ * SCTP::Message responds to the same methods as the SendReceiveInfo struct,
+ * so it can usually be used in its place.
+ *
+ * Example:
+ *
+ *   while true
+ *     msg = socket.recv_message
+ *     next if msg.notification?
+ *     handle(msg.ppid, msg.message)
+ *   end
+ */
+static VALUE rsctp_recv_message(int argc, VALUE* argv, VALUE self){
+  VALUE v_flags, v_buffer_size, v_payload, v_msg;
+  sctp_message_t* msg;
+  sctp_latency_t* latency;
+  sctp_sock_t fileno;
+  int flags, buffer_size;
+  ssize_t bytes;
+
+  rb_scan_args(argc, argv, "02", &v_flags, &v_buffer_size);
+
+  flags = NIL_P(v_flags) ? 0 : NUM2INT(v_flags);
+  buffer_size = NIL_P(v_buffer_size) ? 1024 : NUM2INT(v_buffer_size);
+
+  if(buffer_size <= 0)
+    rb_raise(rb_eArgError, "buffer size must be positive");
+
+  CHECK_SOCKET_CLOSED(self);
+
+  fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+
+#ifdef HAVE_USRSCTP_H
+  enable_recv_rcvinfo(self, fileno);
+#endif
+
+  v_msg = rsctp_message_alloc(cMessage);
+  msg = get_message(v_msg);
+
+  v_payload = rb_str_buf_new(buffer_size);
+  latency = get_latency(self);
+
+  // Receive again whenever the notification filter swallows a notification
+  do{
+    msg->addrlen = sizeof(msg->addr);
+    msg->msg_flags = flags;
+
+    {
+      struct recvmsg_nogvl_args recv_args;
+      recv_args.fd        = fileno;
+      recv_args.buf       = RSTRING_PTR(v_payload);
+      recv_args.len       = buffer_size;
+      recv_args.from      = (struct sockaddr*)&msg->addr;
+      recv_args.fromlen   = &msg->addrlen;
+      recv_args.sinfo     = &msg->info;
+      recv_args.msg_flags = &msg->msg_flags;
+      recv_args.stamp     = latency != NULL ? &msg->stamp : NULL;
+
+#ifdef HAVE_USRSCTP_H
+      rb_thread_call_without_gvl(recvmsg_nogvl, &recv_args, recvmsg_ubf, &recv_args);
+#else
+      rb_thread_call_without_gvl(recvmsg_nogvl, &recv_args, RUBY_UBF_IO, NULL);
+#endif
+
+      bytes = recv_args.result;
+      errno = recv_args.saved_errno;
+    }
+
+    if(bytes < 0)
+      rb_raise(rb_eSystemCallError, "sctp_recvmsg: %s", strerror(errno));
+
+    if(msg->msg_flags & MSG_NOTIFICATION)
+      track_notification(self, RSTRING_PTR(v_payload), bytes, msg->msg_flags);
+  } while((msg->msg_flags & MSG_NOTIFICATION) && notification_filtered(self, RSTRING_PTR(v_payload), bytes, msg->msg_flags));
+
+  RB_GC_GUARD(v_payload);
+
+  // Give back the unused part of the buffer
+  rb_str_resize(v_payload, bytes);
+  RB_OBJ_WRITE(v_msg, &msg->payload, v_payload);
+
+  if(!(msg->msg_flags & MSG_NOTIFICATION))
+    track_activity(self, msg->info.sinfo_assoc_id);
+
+  if(latency != NULL && msg->stamp.tv_sec != 0)
+    record_latency_since(&latency->receive, CLOCK_REALTIME, &msg->stamp);
+
+  return v_msg;
+}
+
+/*
+ * call-seq:
+ *    SCTP::Socket#timestamps?
+ *
+ * Returns whether or not receive timestamps and latency histograms are on.
+ */
+static VALUE rsctp_get_timestamps(VALUE self){
+  return NIL_P(rb_attr_get(self, rb_intern("latency"))) ? Qfalse : Qtrue;
+}
+
+/*
+ * call-seq:
+ *    SCTP::Socket#timestamps=(bool)
+ *
+ * Turn kernel receive timestamps and the latency histograms on or off.
+ *
+ * While on, the kernel stamps each message with the time it arrived, with
+ * SO_TIMESTAMPNS where available, and SCTP::Socket#recv_message returns it
+ * as SCTP::Message#timestamp. The time from arrival to recv_message or
+ * recvmsg returning is recorded in the :receive histogram, and the time
+ * spent in the send and sendmsg methods in the :send histogram. See
+ * SCTP::Socket#latency.
+ *
+ * On usrsctp builds there is no kernel to timestamp messages, so only the
+ * :send histogram is filled in. Turning timestamps off discards the
+ * histograms.
+ */
+static VALUE rsctp_set_timestamps(VALUE self, VALUE v_bool){
+  sctp_sock_t fileno;
+  sctp_latency_t* latency;
+  int on;
+
+  CHECK_SOCKET_CLOSED(self);
+
+  fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+  on = RTEST(v_bool) ? 1 : 0;
+
+#ifndef HAVE_USRSCTP_H
+#if defined(SO_TIMESTAMPNS)
+  if(sctp_sys_setsockopt(fileno, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)) < 0)
+    rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
+#elif defined(SO_TIMESTAMP)
+  if(sctp_sys_setsockopt(fileno, SOL_SOCKET, SO_TIMESTAMP, &on, sizeof(on)) < 0)
+    rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
+#endif
+#else
+  (void)fileno;
+#endif
+
+  if(!on){
+    rb_ivar_set(self, rb_intern("latency"), Qnil);
+    return Qfalse;
+  }
+
+  if(NIL_P(rb_attr_get(self, rb_intern("latency"))))
+    rb_ivar_set(self, rb_intern("latency"), TypedData_Make_Struct(0, sctp_latency_t, &latency_type, latency));
+
+  return Qtrue;
+}
+
+/*
+ * call-seq:
+ *    SCTP::Socket#latency(kind = :receive)
+ *
+ * Returns a Latency struct summarizing one of the socket's latency
+ * histograms, or nil if timestamps are off. The +kind+ is :receive, for the
+ * time from kernel arrival to SCTP::Socket#recv_message returning, or :send,
+ * for the time spent in the send and sendmsg methods.
+ *
+ * The struct holds the number of values recorded, and the min, mean, max,
+ * p50, p90, p99 and p999 values in microseconds. Percentiles are accurate
+ * to within about 6%.
+ *
+ * Example:
+ *
+ *   socket.timestamps = true
+ *   # ... receive some messages
+ *   socket.latency(:receive).p99 # => 184.0
+ */
+static VALUE rsctp_latency(int argc, VALUE* argv, VALUE self){
+  VALUE v_kind;
+  sctp_latency_t* latency;
+  sctp_histogram_t* histogram;
+  ID kind;
+
+  rb_scan_args(argc, argv, "01", &v_kind);
+
+  latency = get_latency(self);
+
+  if(NIL_P(v_kind))
+    kind = rb_intern("receive");
+  else
+    kind = SYM2ID(v_kind);
+
+  if(kind == rb_intern("receive"))
+    histogram = latency != NULL ? &latency->receive : NULL;
+  else if(kind == rb_intern("send"))
+    histogram = latency != NULL ? &latency->send : NULL;
+  else
+    rb_raise(rb_eArgError, "latency kind must be :receive or :send");
+
+  if(histogram == NULL)
+    return Qnil;
+
+  return rb_struct_new(v_latency_struct,
+    ULL2NUM(histogram->count),
+    DBL2NUM(histogram->min / 1000.0),
+    DBL2NUM(histogram->count > 0 ? histogram->total / histogram->count / 1000.0 : 0.0),
+    DBL2NUM(histogram->max / 1000.0),
+    DBL2NUM(latency_percentile(histogram, 50.0) / 1000.0),
+    DBL2NUM(latency_percentile(histogram, 90.0) / 1000.0),
+    DBL2NUM(latency_percentile(histogram, 99.0) / 1000.0),
+    DBL2NUM(latency_percentile(histogram, 99.9) / 1000.0)
+  );
+}
+
+/*
+ * call-seq:
+ *    SCTP::Socket#reset_latency
+ *
+ * Clear the latency histograms, e.g. at the start of each reporting period.
+ */
+static VALUE rsctp_reset_latency(VALUE self){
+  sctp_latency_t* latency = get_latency(self);
+
+  if(latency != NULL)
+    bzero(latency, sizeof(*latency));
+
+  return self;
+}
+
+#ifdef HAVE_RB_IO_BUFFER_GET_BYTES_FOR_READING
+/*
+ * call-seq:
+ *    SCTP::Socket#recvmsg_into(buffer, flags=0, offset=0)
+ *
+ * Receive a message from another SCTP endpoint directly into an IO::Buffer,
+ * such as one that wraps shared memory or a memory mapped file, without an
+ * intermediate String.
+ *
+ * The message is written into the buffer starting at +offset+ and may be up
+ * to the size of the buffer, minus the offset, in length.
+ *
+ * Returns the same struct as SCTP::Socket#recvmsg, except that the +message+
+ * member is the number of bytes written into the buffer. As with recvmsg, it
+ * is nil if a notification was received instead.
+ *
+ * Example:
+ *
+ *   buffer = IO::Buffer.new(65536)
+ *   info = socket.recvmsg_into(buffer)
+ *   data = buffer.get_string(0, info.message) unless info.notification
+ */
+static VALUE rsctp_recvmsg_into(int argc, VALUE* argv, VALUE self){
+  VALUE v_buffer, v_flags, v_offset, v_notification, v_message;
+  struct sctp_sndrcvinfo sndrcvinfo;
+  struct sockaddr_storage clientaddr;
+  sctp_sock_t fileno;
+  int flags, recv_flags;
+  long offset;
+  ssize_t bytes;
+  void* base;
+  size_t size;
+  socklen_t length;
+
+  rb_scan_args(argc, argv, "12", &v_buffer, &v_flags, &v_offset);
+
+  if(!rb_obj_is_kind_of(v_buffer, rb_cIOBuffer))
+    rb_raise(rb_eTypeError, "buffer must be an IO::Buffer");
+
+  if(NIL_P(v_flags))
+    flags = 0;
+  else
+    flags = NUM2INT(v_flags);
+
+  if(NIL_P(v_offset))
+    offset = 0;
+  else
+    offset = NUM2LONG(v_offset);
+
+  CHECK_SOCKET_CLOSED(self);
+
+  rb_io_buffer_get_bytes_for_writing(v_buffer, &base, &size);
+
+  if(offset < 0 || (size_t)offset >= size)
+    rb_raise(rb_eArgError, "offset is out of range");
+
+  fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+  recv_flags = flags;
+
+#ifdef HAVE_USRSCTP_H
+  enable_recv_rcvinfo(self, fileno);
+#endif
+
+  // Receive again whenever the notification filter swallows a notification
+  do{
+    length = sizeof(struct sockaddr_storage);
+    flags = recv_flags;
+
+    bzero(&clientaddr, sizeof(clientaddr));
+    bzero(&sndrcvinfo, sizeof(sndrcvinfo));
+
+    {
+      struct recvmsg_nogvl_args recv_args;
+      recv_args.fd       = fileno;
+      recv_args.buf      = (char*)base + offset;
+      recv_args.len      = size - offset;
+      recv_args.from     = (struct sockaddr*)&clientaddr;
+      recv_args.fromlen  = &length;
+      recv_args.sinfo    = &sndrcvinfo;
+      recv_args.msg_flags = &flags;
+      recv_args.stamp    = NULL;
+
+      rb_io_buffer_lock(v_buffer);
+      rb_ensure(recvmsg_without_gvl, (VALUE)&recv_args, rb_io_buffer_unlock, v_buffer);
+
+      bytes = recv_args.result;
+      errno = recv_args.saved_errno;
+    }
+
+    if(bytes < 0)
+      rb_raise(rb_eSystemCallError, "sctp_recvmsg: %s", strerror(errno));
+
+    if(flags & MSG_NOTIFICATION)
+      track_notification(self, (char*)base + offset, bytes, flags);
+  } while((flags & MSG_NOTIFICATION) && notification_filtered(self, (char*)base + offset, bytes, flags));
+
+  v_notification = Qnil;
+
+  if((flags & MSG_NOTIFICATION) && notification_complete((char*)base + offset, bytes, flags))
+    v_notification = get_notification_info((char*)base + offset, bytes);
+
+  if(NIL_P(v_notification))
+    v_message = LONG2NUM(bytes);
+  else
+    v_message = Qnil;
+
+  if(NIL_P(v_notification))
+    track_activity(self, sndrcvinfo.sinfo_assoc_id);
+
+  return rb_struct_new(v_sndrcv_struct,
+    v_message,
+    UINT2NUM(sndrcvinfo.sinfo_stream),
+    UINT2NUM(sndrcvinfo.sinfo_flags),
+    UINT2NUM(sndrcvinfo.sinfo_ppid),
+    UINT2NUM(sndrcvinfo.sinfo_context),
+    UINT2NUM(sndrcvinfo.sinfo_timetolive),
+    UINT2NUM(sndrcvinfo.sinfo_assoc_id),
+    v_notification,
+    get_cached_client(self, sndrcvinfo.sinfo_assoc_id, &clientaddr, length),
+    INT2NUM(flags)
+  );
+}
+#endif
+
+/*
+ * Handlers are stored in a hash keyed on an Integer built from the ppid and
+ * stream, so that looking one up doesn't allocate. The bit above each field
+ * marks a wildcard, i.e. a handler for any ppid or any stream.
+ */
+#define HANDLER_ANY_PPID   ((uint64_t)1 << 32)
+#define HANDLER_ANY_STREAM ((uint64_t)1 << 16)
+#define HANDLER_KEY(ppid, stream) ULL2NUM(((uint64_t)(ppid) << 17) | (uint64_t)(stream))
+
+/*
+ * Find the handler for a message, trying an exact match on ppid and stream
+ * first, then the ppid on any stream, then the stream for any ppid, and
+ * finally the catch-all handler.
+ */
+static VALUE find_message_handler(VALUE v_handlers, uint32_t ppid, uint16_t stream){
+  VALUE v_handler;
+
+  v_handler = rb_hash_lookup(v_handlers, HANDLER_KEY(ppid, stream));
+
+  if(NIL_P(v_handler))
+    v_handler = rb_hash_lookup(v_handlers, HANDLER_KEY(ppid, HANDLER_ANY_STREAM));
+
+  if(NIL_P(v_handler))
+    v_handler = rb_hash_lookup(v_handlers, HANDLER_KEY(HANDLER_ANY_PPID, stream));
+
+  if(NIL_P(v_handler))
+    v_handler = rb_hash_lookup(v_handlers, HANDLER_KEY(HANDLER_ANY_PPID, HANDLER_ANY_STREAM));
+
+  return v_handler;
+}
+
+/*
+ * call-seq:
+ *    SCTP::Socket#on_message(options = {}){ |message, association_id| ... }
+ *
+ * Registers a block to be called by SCTP::Socket#dispatch for each message
+ * with the given payload protocol identifier and stream. Either may be
+ * omitted to match any value. When several handlers match, the most
+ * specific one wins: ppid and stream, then ppid, then stream, then neither.
+ *
+ * Registering a handler for the same ppid and stream again replaces it.
+ *
+ * The following options are supported:
+ *
+ * * ppid: The payload protocol identifier, as reported by recvmsg
+ * * stream: The stream number
+ *
+ * Example:
+ *
+ *   socket.on_message(:ppid => 46, :stream => 0){ |message, assoc_id| handle_control(message) }
+ *   socket.on_message(:ppid => 46){ |message, assoc_id| handle_data(message) }
+ *   socket.on_message{ |message, assoc_id| puts "Unexpected message from #{assoc_id}" }
+ *
+ *   socket.dispatch
+ */
+static VALUE rsctp_on_message(int argc, VALUE* argv, VALUE self){
+  VALUE v_options, v_ppid, v_stream, v_handlers, v_block;
+  uint64_t ppid, stream;
+
+  rb_scan_args(argc, argv, "01&", &v_options, &v_block);
+
+  if(NIL_P(v_block))
+    rb_raise(rb_eArgError, "no block given");
+
+  if(NIL_P(v_options))
+    v_options = rb_hash_new();
+
+  Check_Type(v_options, T_HASH);
+
+  v_ppid = rb_hash_aref2(v_options, "ppid");
+  v_stream = rb_hash_aref2(v_options, "stream");
+
+  ppid = NIL_P(v_ppid) ? HANDLER_ANY_PPID : NUM2UINT(v_ppid);
+  stream = NIL_P(v_stream) ? HANDLER_ANY_STREAM : NUM2USHORT(v_stream);
+
+  v_handlers = rb_attr_get(self, rb_intern("message_handlers"));
+
+  if(NIL_P(v_handlers)){
+    v_handlers = rb_hash_new();
+    rb_ivar_set(self, rb_intern("message_handlers"), v_handlers);
+  }
+
+  rb_hash_aset(v_handlers, HANDLER_KEY(ppid, stream), v_block);
+
+  return self;
+}
+
+/*
+ * call-seq:
+ *    SCTP::Socket#on_notification{ |notification| ... }
+ *
+ * Registers a block to be called by SCTP::Socket#dispatch for each
+ * notification, e.g. an AssocChange struct. Without one, notifications
+ * are discarded by dispatch.
+ */
+static VALUE rsctp_on_notification(VALUE self){
+  rb_need_block();
+  rb_ivar_set(self, rb_intern("notification_handler"), rb_block_proc());
+  return self;
+}
+
+/*
+ * call-seq:
+ *    SCTP::Socket#dispatch(options = {})
+ *
+ * Receives messages and passes each one to the handler registered for its
+ * ppid and stream with SCTP::Socket#on_message. Only the payload and the
+ * association id are passed, so no SendReceiveInfo struct is built. Messages
+ * larger than the buffer are reassembled first, as with recvmsg.
+ *
+ * Messages without a matching handler are discarded. Notifications go to
+ * the SCTP::Socket#on_notification handler, if any.
+ *
+ * The following options are supported:
+ *
+ * * count: The number of messages to receive before returning. By default
+ *     dispatch keeps receiving until the socket is closed, e.g. by a handler,
+ *     or, on a one-to-one or peeled off socket, until the peer shuts down.
+ * * flags: Flags passed to the receive call (default: 0)
+ * * buffer_size: The size of each read, in bytes (default: 1024)
+ * * max_message_size: The largest message accepted, in bytes (default: 1MB).
+ *     A larger message raises a RangeError.
+ *
+ * Returns the number of messages received, not counting notifications.
+ */
+static VALUE rsctp_dispatch(int argc, VALUE* argv, VALUE self){
+  VALUE v_options, v_count, v_flags, v_buffer_size, v_max_size;
+  VALUE v_handlers, v_notification_handler, v_handler, v_message, v_notification;
+  struct sctp_sndrcvinfo sndrcvinfo;
+  struct sockaddr_storage clientaddr;
+  socklen_t length;
+  sctp_sock_t fileno;
+  long count, received, buffer_size, max_size;
+  int flags, msg_flags;
+
+  rb_scan_args(argc, argv, "01", &v_options);
+
+  if(NIL_P(v_options))
+    v_options = rb_hash_new();
 
-        v_notification = rb_struct_new(v_remote_error_struct,
-          UINT2NUM(snp->sn_remote_error.sre_type),
-          UINT2NUM(snp->sn_remote_error.sre_flags),
-          UINT2NUM(snp->sn_remote_error.sre_length),
-          UINT2NUM(snp->sn_remote_error.sre_error),
-          UINT2NUM(snp->sn_remote_error.sre_assoc_id),
-          v_data_ary
-        );
-      }
-      break;
-#ifdef SCTP_SEND_FAILED_EVENT
-    case SCTP_SEND_FAILED_EVENT:
-      {
-        size_t data_len = 0;
-        VALUE v_data_ary;
+  Check_Type(v_options, T_HASH);
 
-#ifdef HAVE_STRUCT_SCTP_SEND_FAILED_EVENT_SSFE_LENGTH
-        // Calculate actual data length (total length minus fixed header)
-        if(snp->sn_send_failed_event.ssfe_length > offsetof(struct sctp_send_failed_event, ssfe_data))
-          data_len = snp->sn_send_failed_event.ssfe_length - offsetof(struct sctp_send_failed_event, ssfe_data);
+  v_count = rb_hash_aref2(v_options, "count");
+  v_flags = rb_hash_aref2(v_options, "flags");
+  v_buffer_size = rb_hash_aref2(v_options, "buffer_size");
+  v_max_size = rb_hash_aref2(v_options, "max_message_size");
 
-        // Bounds check to prevent stack overflow
-        if(data_len > MAX_NOTIFICATION_DATA)
-          data_len = MAX_NOTIFICATION_DATA;
+  count = NIL_P(v_count) ? -1 : NUM2LONG(v_count);
+  flags = NIL_P(v_flags) ? 0 : NUM2INT(v_flags);
+  buffer_size = NIL_P(v_buffer_size) ? 1024 : NUM2LONG(v_buffer_size);
+  max_size = NIL_P(v_max_size) ? 1024 * 1024 : NUM2LONG(v_max_size);
 
-        if(data_len > 0){
-          v_temp = ALLOCA_N(VALUE, data_len);
-          for(i = 0; i < data_len; i++){
-            v_temp[i] = UINT2NUM(snp->sn_send_failed_event.ssfe_data[i]);
-          }
-          v_data_ary = rb_ary_new4(data_len, v_temp);
-        }
-        else{
-          v_data_ary = rb_ary_new();
-        }
+  if(buffer_size <= 0)
+    rb_raise(rb_eArgError, "buffer size must be positive");
 
-        v_notification = rb_struct_new(v_send_failed_event_struct,
-          UINT2NUM(snp->sn_send_failed_event.ssfe_type),
-          UINT2NUM(snp->sn_send_failed_event.ssfe_length),
-          UINT2NUM(snp->sn_send_failed_event.ssfe_error),
-          rb_struct_new(v_sndinfo_struct,
-            UINT2NUM(snp->sn_send_failed_event.ssfe_info.snd_sid),
-            UINT2NUM(snp->sn_send_failed_event.ssfe_info.snd_flags),
-            UINT2NUM(snp->sn_send_failed_event.ssfe_info.snd_ppid),
-            UINT2NUM(snp->sn_send_failed_event.ssfe_info.snd_context),
-            UINT2NUM(snp->sn_send_failed_event.ssfe_info.snd_assoc_id)
-          ),
-          UINT2NUM(snp->sn_send_failed_event.ssfe_assoc_id),
-          v_data_ary
-        );
-#else
-        // Calculate actual data length (total length minus fixed header)
-        if(snp->sn_send_failed_event.ssf_length > offsetof(struct sctp_send_failed_event, ssf_data))
-          data_len = snp->sn_send_failed_event.ssf_length - offsetof(struct sctp_send_failed_event, ssf_data);
+  if(max_size <= 0)
+    rb_raise(rb_eArgError, "max message size must be positive");
 
-        // Bounds check to prevent stack overflow
-        if(data_len > MAX_NOTIFICATION_DATA)
-          data_len = MAX_NOTIFICATION_DATA;
+  CHECK_SOCKET_CLOSED(self);
 
-        if(data_len > 0){
-          v_temp = ALLOCA_N(VALUE, data_len);
-          for(i = 0; i < data_len; i++){
-            v_temp[i] = UINT2NUM(snp->sn_send_failed_event.ssf_data[i]);
-          }
-          v_data_ary = rb_ary_new4(data_len, v_temp);
-        }
-        else{
-          v_data_ary = rb_ary_new();
-        }
+  fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
 
-        v_notification = rb_struct_new(v_send_failed_event_struct,
-          UINT2NUM(snp->sn_send_failed_event.ssf_type),
-          UINT2NUM(snp->sn_send_failed_event.ssf_length),
-          UINT2NUM(snp->sn_send_failed_event.ssf_error),
-          rb_struct_new(v_sndinfo_struct,
-            UINT2NUM(snp->sn_send_failed_event.ssfe_info.snd_sid),
-            UINT2NUM(snp->sn_send_failed_event.ssfe_info.snd_flags),
-            UINT2NUM(snp->sn_send_failed_event.ssfe_info.snd_ppid),
-            UINT2NUM(snp->sn_send_failed_event.ssfe_info.snd_context),
-            UINT2NUM(snp->sn_send_failed_event.ssfe_info.snd_assoc_id)
-          ),
-          UINT2NUM(snp->sn_send_failed_event.ssf_assoc_id),
-          v_data_ary
-        );
+#ifdef HAVE_USRSCTP_H
+  enable_recv_rcvinfo(self, fileno);
 #endif
-      }
-      break;
-#else
-    case SCTP_SEND_FAILED:
-      {
-        size_t data_len = 0;
-        VALUE v_data_ary;
 
-        // Calculate actual data length (total length minus fixed header)
-        if(snp->sn_send_failed.ssf_length > offsetof(struct sctp_send_failed, ssf_data))
-          data_len = snp->sn_send_failed.ssf_length - offsetof(struct sctp_send_failed, ssf_data);
+  v_handlers = rb_attr_get(self, rb_intern("message_handlers"));
+  v_notification_handler = rb_attr_get(self, rb_intern("notification_handler"));
 
-        // Bounds check to prevent stack overflow
-        if(data_len > MAX_NOTIFICATION_DATA)
-          data_len = MAX_NOTIFICATION_DATA;
+  if(NIL_P(v_handlers))
+    v_handlers = rb_hash_new();
 
-        if(data_len > 0){
-          v_temp = ALLOCA_N(VALUE, data_len);
-          for(i = 0; i < data_len; i++){
-            v_temp[i] = UINT2NUM(snp->sn_send_failed.ssf_data[i]);
-          }
-          v_data_ary = rb_ary_new4(data_len, v_temp);
-        }
-        else{
-          v_data_ary = rb_ary_new();
-        }
+  received = 0;
 
-        v_notification = rb_struct_new(v_send_failed_event_struct,
-          UINT2NUM(snp->sn_send_failed.ssf_type),
-          UINT2NUM(snp->sn_send_failed.ssf_length),
-          UINT2NUM(snp->sn_send_failed.ssf_error),
-          Qnil,
-          UINT2NUM(snp->sn_send_failed.ssf_assoc_id),
-          v_data_ary
-        );
-      }
-      break;
-#endif
-    case SCTP_SHUTDOWN_EVENT:
-      v_notification = rb_struct_new(v_shutdown_event_struct,
-        UINT2NUM(snp->sn_shutdown_event.sse_type),
-        UINT2NUM(snp->sn_shutdown_event.sse_length),
-        UINT2NUM(snp->sn_shutdown_event.sse_assoc_id)
-      );
-      break;
-    case SCTP_ADAPTATION_INDICATION:
-      v_notification = rb_struct_new(v_adaptation_event_struct,
-        UINT2NUM(snp->sn_adaptation_event.sai_type),
-        UINT2NUM(snp->sn_adaptation_event.sai_length),
-        UINT2NUM(snp->sn_adaptation_event.sai_adaptation_ind),
-        UINT2NUM(snp->sn_adaptation_event.sai_assoc_id)
-      );
-      break;
-    case SCTP_PARTIAL_DELIVERY_EVENT:
-      v_notification = rb_struct_new(v_partial_delivery_event_struct,
-        UINT2NUM(snp->sn_pdapi_event.pdapi_type),
-        UINT2NUM(snp->sn_pdapi_event.pdapi_length),
-        UINT2NUM(snp->sn_pdapi_event.pdapi_indication),
-        UINT2NUM(snp->sn_pdapi_event.pdapi_stream),
-        UINT2NUM(snp->sn_pdapi_event.pdapi_seq),
-        UINT2NUM(snp->sn_pdapi_event.pdapi_assoc_id)
-      );
-      break;
-    case SCTP_AUTHENTICATION_EVENT:
-      v_notification = rb_struct_new(v_auth_event_struct,
-#ifdef HAVE_UNION_SCTP_NOTIFICATION_SN_AUTH_EVENT
-        UINT2NUM(snp->sn_auth_event.auth_type),
-        UINT2NUM(snp->sn_auth_event.auth_length),
-        UINT2NUM(snp->sn_auth_event.auth_keynumber),
-        UINT2NUM(snp->sn_auth_event.auth_indication),
-        UINT2NUM(snp->sn_auth_event.auth_assoc_id)
-#else
-        UINT2NUM(snp->sn_authkey_event.auth_type),
-        UINT2NUM(snp->sn_authkey_event.auth_length),
-        UINT2NUM(snp->sn_authkey_event.auth_keynumber),
-        UINT2NUM(snp->sn_authkey_event.auth_indication),
-        UINT2NUM(snp->sn_authkey_event.auth_assoc_id)
-#endif
-      );
+  while(count < 0 || received < count){
+    bzero(&clientaddr, sizeof(clientaddr));
+    bzero(&sndrcvinfo, sizeof(sndrcvinfo));
+
+    v_notification = Qnil;
+
+    v_message = recvmsg_reassemble(
+      self,
+      fileno,
+      flags,
+      buffer_size,
+      max_size,
+      &sndrcvinfo,
+      &clientaddr,
+      &length,
+      &msg_flags,
+      &v_notification,
+      NULL
+    );
+
+    if(!NIL_P(v_notification)){
+      if(!NIL_P(v_notification_handler))
+        rb_funcall(v_notification_handler, id_call, 1, v_notification);
+    }
+    else if(RSTRING_LEN(v_message) == 0){
+      // SCTP has no empty messages, so this is a one-to-one or peeled off
+      // socket whose peer has shut down
       break;
-    case SCTP_SENDER_DRY_EVENT:
-      v_notification = rb_struct_new(v_sender_dry_event_struct,
-        UINT2NUM(snp->sn_sender_dry_event.sender_dry_type),
-        UINT2NUM(snp->sn_sender_dry_event.sender_dry_flags),
-        UINT2NUM(snp->sn_sender_dry_event.sender_dry_length),
-        UINT2NUM(snp->sn_sender_dry_event.sender_dry_assoc_id)
-      );
+    }
+    else{
+      received++;
+      track_activity(self, sndrcvinfo.sinfo_assoc_id);
+
+      v_handler = find_message_handler(v_handlers, sndrcvinfo.sinfo_ppid, sndrcvinfo.sinfo_stream);
+
+      if(!NIL_P(v_handler))
+        rb_funcall(v_handler, id_call, 2, v_message, INT2NUM(sndrcvinfo.sinfo_assoc_id));
+    }
+
+    // A handler may have closed the socket
+    if(NIL_P(rb_iv_get(self, "@fileno")))
       break;
   }
 
-  return v_notification;
+  return LONG2NUM(received);
 }
 
 /*
  * call-seq:
- *    SCTP::Socket.new(domain = Socket::AF_INET, type = Socket::SOCK_STREAM)
- *
- * Create and return a new SCTP::Socket instance. You may optionally pass in
- * a domain (aka family) value and socket type. By default these are AF_INET
- * and SOCK_SEQPACKET, respectively.
+ *    SCTP::Socket#set_initmsg(options)
  *
- * There are only two supported families: SOCK_SEQPACKET for the creation
- * of a one-to-many socket, and SOCK_STREAM for the creation of a
- * one-to-one socket.
+ * Set the initial parameters used by the socket when sending out the INIT message.
  *
  * Example:
  *
- *   require 'socket'
- *   require 'sctp/socket'
+ *  socket = SCTP::Socket.new
+ *  socket.set_initmsg(:output_streams => 5, :input_streams => 5, :max_attempts => 4, :timeout => 30)
  *
- *   socket1 = SCTP::Socket.new
- *   socket2 = SCTP::Socket.new(Socket::AF_INET, Socket::SOCK_STREAM)
+ * The following parameters can be configured:
+ *
+ *  :output_streams - The number of outbound SCTP streams an application would like to request.
+ *  :input_streams  - The maximum number of inbound streams an application is prepared to allow.
+ *  :max_attempts   - How many times the the SCTP stack should send the initial INIT message before it's considered unreachable.
+ *  :timeout        - The maximum RTO value for the INIT timer.
+ *
+ * By default these values are set to zero (i.e. ignored).
  */
-static VALUE rsctp_init(int argc, VALUE* argv, VALUE self){
+static VALUE rsctp_set_initmsg(VALUE self, VALUE v_options){
   sctp_sock_t fileno;
-  VALUE v_domain, v_type;
+  struct sctp_initmsg initmsg;
+  VALUE v_output, v_input, v_attempts, v_timeout;
 
-  rb_scan_args(argc, argv, "02", &v_domain, &v_type);
+  bzero(&initmsg, sizeof(initmsg));
 
-  // Set defaults with validation
-  if(NIL_P(v_domain)){
-    v_domain = INT2NUM(AF_INET);
-  }
-  else{
-    int domain = NUM2INT(v_domain);
-    if((domain != AF_INET) && (domain != AF_INET6))
-      rb_raise(rb_eArgError, "unsupported domain family: %d", domain);
-  }
+  CHECK_SOCKET_CLOSED(self);
 
-  if(NIL_P(v_type)){
-    v_type = INT2NUM(SOCK_SEQPACKET);
-  }
-  else{
-    int type = NUM2INT(v_type);
-    if (type != SOCK_SEQPACKET && type != SOCK_STREAM)
-      rb_raise(rb_eArgError, "unsupported socket type: %d", type);
-  }
+  v_output   = rb_hash_aref2(v_options, "output_streams");
+  v_input    = rb_hash_aref2(v_options, "input_streams");
+  v_attempts = rb_hash_aref2(v_options, "max_attempts");
+  v_timeout  = rb_hash_aref2(v_options, "timeout");
+
+  fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+
+  if(!NIL_P(v_output))
+    initmsg.sinit_num_ostreams = NUM2INT(v_output);
+
+  if(!NIL_P(v_input))
+    initmsg.sinit_max_instreams = NUM2INT(v_input);
+
+  if(!NIL_P(v_attempts))
+    initmsg.sinit_max_attempts = NUM2INT(v_attempts);
+
+  if(!NIL_P(v_timeout))
+    initmsg.sinit_max_init_timeo = NUM2INT(v_timeout);
+
+  if(sctp_sys_setsockopt(fileno, IPPROTO_SCTP, SCTP_INITMSG, &initmsg, sizeof(initmsg)) < 0)
+    rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
+
+  return self;
+}
+
+#ifdef HAVE_STRUCT_SCTP_EVENT_SE_ASSOC_ID
+/*
+ * Helper function for subscribe that turns individual events on or off for
+ * a single association with SCTP_EVENT. Events that aren't in the options
+ * hash are left alone.
+ */
+static void subscribe_association(sctp_sock_t fileno, sctp_assoc_t assoc_id, VALUE v_options){
+  struct sctp_event se;
+  const char* previous = NULL;
+  VALUE v_value;
+  size_t i;
 
-  fileno = sctp_sys_socket(NUM2INT(v_domain), NUM2INT(v_type), IPPROTO_SCTP);
+  if(!NIL_P(rb_hash_aref2(v_options, "data_io")))
+    rb_raise(rb_eArgError, "the data_io event can't be subscribed per association");
 
-  if(SCTP_FD_INVALID(fileno))
-    rb_raise(rb_eSystemCallError, "socket: %s", strerror(errno));
+  for(i = 0; i < sizeof(notification_names) / sizeof(notification_names[0]); i++){
+    // Only the first type listed under a name is subscribed
+    if(previous != NULL && strcmp(previous, notification_names[i].name) == 0)
+      continue;
 
-  rb_iv_set(self, "@domain", v_domain);
-  rb_iv_set(self, "@type", v_type);
-  rb_iv_set(self, "@fileno", SCTP_FD_TO_NUM(fileno));
-  rb_iv_set(self, "@association_id", INT2NUM(0));
+    previous = notification_names[i].name;
+    v_value = rb_hash_aref2(v_options, notification_names[i].name);
 
-  return self;
+    if(NIL_P(v_value))
+      continue;
+
+    bzero(&se, sizeof(se));
+    se.se_assoc_id = assoc_id;
+    se.se_type = notification_names[i].type;
+    se.se_on = RTEST(v_value) ? 1 : 0;
+
+    if(sctp_sys_setsockopt(fileno, IPPROTO_SCTP, SCTP_EVENT, &se, sizeof(se)) < 0)
+      rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
+  }
 }
+#endif
 
 /*
  * call-seq:
- *    SCTP::Socket#bindx(options)
+ *    SCTP::Socket#subscribe(options)
  *
- * Bind a subset of IP addresses associated with the host system on the
- * given port, or a port assigned by the operating system if none is provided.
- * You may bind a maximum of eight IP addresses.
+ * Subscribe to various notification type events, which will generate additional
+ * data that the socket may receive. The possible notification type events are
+ * as follows:
  *
- * Note that you can both add or remove an address to or from the socket
- * using the SCTP_BINDX_ADD_ADDR (default) or SCTP_BINDX_REM_ADDR constants,
- * respectively.
+ *   :association
+ *   - A change has occurred to an association, either a new one has begun or an existing one has end.
  *
- * Possible options:
+ *   :address
+ *   - The state of one of the peer's addresses has experienced a change.
  *
- * * addresses - Array of IP addresses to bind to. If none are specified then
- *     INADDR_ANY is used.
+ *   :send_failure
+ *   - The message could not be delivered to a peer.
  *
- * * port - The port to bind to. If none is specified then 0 is used, i.e. the
- *     OS will select one for you.
+ *   :shutdown
+ *   - The peer has sent a shutdown to the local endpoint.
  *
- * * flags - Flags to pass to the underlying sctp_bindx function. In practice
- *     there are only two options: BINDX_ADD_ADDR and BINDX_REM_ADDR. By
- *     default a flag of BINDX_ADD_ADDR is assumed.
+ *   :data_io
+ *   - Message data was received. You will want to subscribe to this in most cases.
  *
- * * reuse_addr - If set to true, then the SO_REUSEADDR flag will be applied to
- *     the socket before the bind call. This will allow other sockets to reuse
- *     the addresses that are currently bound to the socket.
+ *   Others:
+ *
+ *   :adaptation
+ *   :authentication
+ *   :partial_delivery
+ *   :sender_dry
+ *   :peer_error (aka remote error)
+ *   :stream_reset (see SCTP::Socket#reset_streams)
+ *   :assoc_reset (see SCTP::Socket#reset_association)
+ *   :stream_change (see SCTP::Socket#add_streams)
  *
  * Example:
  *
  *   socket = SCTP::Socket.new
  *
- *   # Bind 2 addresses
- *   socket.bindx(:port => 64325, :addresses => ['10.0.4.5', '10.0.5.5'])
+ *   socket.bind(:port => port, :addresses => ['127.0.0.1'])
+ *   socket.subscribe(:data_io => true, :shutdown => true, :send_failure => true)
  *
- *   # Remove 1 later
- *   socket.bindx(:addresses => ['10.0.4.5'], :flags => SCTP::Socket::BINDX_REM_ADDR)
+ * Without an :association_id the subscriptions apply to the whole socket,
+ * and any event that isn't listed is turned off.
  *
- * If no addresses are specified, then it will bind to all available interfaces. If
- * no port is specified, then one will be assigned by the host.
+ * With an :association_id only the listed events of that association are
+ * changed. An event set to true is turned on, one set to false is turned
+ * off, and the rest are left alone. This lets noisy events be enabled only
+ * for the associations that need them. The :data_io event always applies
+ * to the whole socket, so it can't be combined with an :association_id.
  *
- * Returns the port that it was bound to.
+ *   socket.subscribe(:sender_dry => true, :association_id => info.association_id)
  */
-static VALUE rsctp_bindx(int argc, VALUE* argv, VALUE self){
+static VALUE rsctp_subscribe(VALUE self, VALUE v_options){
   sctp_sock_t fileno;
-  int i, num_ip, flags, domain, port, on;
-  VALUE v_addresses, v_port, v_flags, v_address, v_reuse_addr, v_options;
-
-  rb_scan_args(argc, argv, "01", &v_options);
-
-  if(NIL_P(v_options))
-    v_options = rb_hash_new();
-
-  v_addresses = rb_hash_aref2(v_options, "addresses");
-  v_flags = rb_hash_aref2(v_options, "flags");
-  v_port = rb_hash_aref2(v_options, "port");
-  v_reuse_addr = rb_hash_aref2(v_options, "reuse_addr");
-
-  if(NIL_P(v_port))
-    port = 0;
-  else
-    port = NUM2INT(v_port);
-
-  if(NIL_P(v_flags))
-    flags = SCTP_BINDX_ADD_ADDR;
-  else
-    flags = NUM2INT(v_flags);
-
-  if(NIL_P(v_addresses))
-    num_ip = 1;
-  else
-    num_ip = (int)RARRAY_LEN(v_addresses);
+  struct sctp_event_subscribe events;
+  int stream_reset, assoc_reset, stream_change;
+  VALUE v_assoc_id;
 
-  if(num_ip > MAX_IP_ADDRESSES)
-    rb_raise(rb_eArgError, "too many IP addresses to bind, maximum is eight");
+  bzero(&events, sizeof(events));
+  Check_Type(v_options, T_HASH);
 
   CHECK_SOCKET_CLOSED(self);
 
-  domain = NUM2INT(rb_iv_get(self, "@domain"));
   fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+  v_assoc_id = rb_hash_aref2(v_options, "association_id");
 
-  if(v_reuse_addr == Qtrue){
-    on = 1;
-#ifdef HAVE_USRSCTP_H
-    /* usrsctp runs in userspace; address reuse is not needed/supported. Silently skip. */
-    (void)on;
+  if(!NIL_P(v_assoc_id)){
+#ifdef HAVE_STRUCT_SCTP_EVENT_SE_ASSOC_ID
+    subscribe_association(fileno, NUM2INT(v_assoc_id), v_options);
+    return self;
 #else
-    if(sctp_sys_setsockopt(fileno, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) < 0)
-      rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
+    rb_raise(rb_eNotImpError, "per-association subscriptions are not supported on this platform");
 #endif
   }
 
-  if(domain == AF_INET6){
-    struct sockaddr_in6 addrs6[MAX_IP_ADDRESSES];
-    bzero(&addrs6, sizeof(addrs6));
-
-    if(!NIL_P(v_addresses)){
-      for(i = 0; i < num_ip; i++){
-        v_address = RARRAY_AREF(v_addresses, i);
-        parse_ip_address_v6(StringValueCStr(v_address), port, &addrs6[i]);
-      }
-    }
-    else{
-      set_any_address_v6(port, &addrs6[0]);
-    }
-
-    if(sctp_sys_bindx(fileno, (struct sockaddr *)addrs6, num_ip, flags) != 0)
-      rb_raise(rb_eSystemCallError, "sctp_bindx: %s", strerror(errno));
-  }
-  else{
-    struct sockaddr_in addrs[MAX_IP_ADDRESSES];
-    bzero(&addrs, sizeof(addrs));
-
-    if(!NIL_P(v_addresses)){
-      for(i = 0; i < num_ip; i++){
-        v_address = RARRAY_AREF(v_addresses, i);
-        parse_ip_address_v4(StringValueCStr(v_address), port, &addrs[i]);
-      }
-    }
-    else{
-      set_any_address_v4(port, &addrs[0]);
-    }
-
-    if(sctp_sys_bindx(fileno, (struct sockaddr *)addrs, num_ip, flags) != 0)
-      rb_raise(rb_eSystemCallError, "sctp_bindx: %s", strerror(errno));
-  }
-
-  if(port == 0){
-    struct sockaddr_storage ss;
-    socklen_t len = sizeof(ss);
-    bzero(&ss, len);
-
-    if(sctp_sys_getsockname(fileno, (struct sockaddr *)&ss, &len) == -1)
-      rb_raise(rb_eSystemCallError, "getsockname: %s", strerror(errno));
+  if(RTEST(rb_hash_aref2(v_options, "data_io")))
+    events.sctp_data_io_event = 1;
 
-    if(ss.ss_family == AF_INET6){
-      struct sockaddr_in6* sin6 = (struct sockaddr_in6*)&ss;
-      port = ntohs(sin6->sin6_port);
-    }
-    else{
-      struct sockaddr_in* sin = (struct sockaddr_in*)&ss;
-      port = ntohs(sin->sin_port);
-    }
-  }
+  if(RTEST(rb_hash_aref2(v_options, "association")))
+    events.sctp_association_event = 1;
 
-  rb_iv_set(self, "@port", INT2NUM(port));
+  if(RTEST(rb_hash_aref2(v_options, "address")))
+    events.sctp_address_event = 1;
 
-  return INT2NUM(port);
-}
+  if(RTEST(rb_hash_aref2(v_options, "send_failure")))
+#ifdef HAVE_STRUCT_SCTP_EVENT_SUBSCRIBE_SCTP_SEND_FAILURE_EVENT
+    events.sctp_send_failure_event = 1;
+#else
+    events.sctp_send_failure_event_event = 1;
+#endif
 
-/*
- * call-seq:
- *    SCTP::Socket#connectx(options)
- *
- * Connect the socket to a multihomed peer via the provided array of addresses
- * using the domain specified in the constructor. You must also specify the port.
- *
- * Example:
- *
- *   socket = SCTP::Socket.new
- *   socket.connectx(:port => 62354, :addresses => ['10.0.4.5', '10.0.5.5'])
- *
- * Note that this will also set/update the object's association_id. Also note that
- * this method is not strictly necessary on the client side, since the various send
- * methods will automatically establish associations.
- */
-static VALUE rsctp_connectx(int argc, VALUE* argv, VALUE self){
-  sctp_sock_t fileno;
-  int i, num_ip, domain, port;
-  sctp_assoc_t assoc;
-  VALUE v_address, v_options, v_addresses, v_port;
+  if(RTEST(rb_hash_aref2(v_options, "peer_error")))
+    events.sctp_peer_error_event = 1;
 
-  rb_scan_args(argc, argv, "01", &v_options);
+  if(RTEST(rb_hash_aref2(v_options, "shutdown")))
+    events.sctp_shutdown_event = 1;
 
-  if(NIL_P(v_options))
-    rb_raise(rb_eArgError, "you must specify an array of addresses");
+  if(RTEST(rb_hash_aref2(v_options, "partial_delivery")))
+    events.sctp_partial_delivery_event = 1;
 
-  Check_Type(v_options, T_HASH);
+  if(RTEST(rb_hash_aref2(v_options, "adaptation_layer")))
+    events.sctp_adaptation_layer_event = 1;
 
-  v_addresses = rb_hash_aref2(v_options, "addresses");
-  v_port = rb_hash_aref2(v_options, "port");
+  if(RTEST(rb_hash_aref2(v_options, "authentication")))
+    events.sctp_authentication_event = 1;
 
-  if(NIL_P(v_addresses) || RARRAY_LEN(v_addresses) == 0)
-    rb_raise(rb_eArgError, "you must specify an array of addresses containing at least one address");
+  if(RTEST(rb_hash_aref2(v_options, "sender_dry")))
+    events.sctp_sender_dry_event = 1;
 
-  if(NIL_P(v_port))
-    rb_raise(rb_eArgError, "you must specify a port");
+  stream_reset = RTEST(rb_hash_aref2(v_options, "stream_reset"));
+  assoc_reset = RTEST(rb_hash_aref2(v_options, "assoc_reset"));
+  stream_change = RTEST(rb_hash_aref2(v_options, "stream_change"));
 
-  CHECK_SOCKET_CLOSED(self);
+#ifdef HAVE_STRUCT_SCTP_EVENT_SUBSCRIBE_SCTP_STREAM_RESET_EVENT
+  if(stream_reset)
+    events.sctp_stream_reset_event = 1;
+#endif
 
-  domain = NUM2INT(rb_iv_get(self, "@domain"));
-  port = NUM2INT(v_port);
-  fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+#ifdef HAVE_STRUCT_SCTP_EVENT_SUBSCRIBE_SCTP_ASSOC_RESET_EVENT
+  if(assoc_reset)
+    events.sctp_assoc_reset_event = 1;
+#endif
 
-  num_ip = (int)RARRAY_LEN(v_addresses);
+#ifdef HAVE_STRUCT_SCTP_EVENT_SUBSCRIBE_SCTP_STREAM_CHANGE_EVENT
+  if(stream_change)
+    events.sctp_stream_change_event = 1;
+#endif
 
-  if(num_ip > MAX_IP_ADDRESSES)
-    rb_raise(rb_eArgError, "too many IP addresses, maximum is eight");
+#ifdef HAVE_USRSCTP_H
+  /* usrsctp uses SCTP_EVENT + struct sctp_event for per-event subscription */
+  {
+    struct sctp_event se;
+    memset(&se, 0, sizeof(se));
+    se.se_assoc_id = 0;
 
-  if(domain == AF_INET6){
-    struct sockaddr_in6 addrs6[MAX_IP_ADDRESSES];
-    bzero(&addrs6, sizeof(addrs6));
+    /* data_io: enable via SCTP_RECVRCVINFO sockopt */
+    if(events.sctp_data_io_event)
+      enable_recv_rcvinfo(self, fileno);
 
-    for(i = 0; i < num_ip; i++){
-      v_address = RARRAY_AREF(v_addresses, i);
-      parse_ip_address_v6(StringValueCStr(v_address), port, &addrs6[i]);
+#define SUBSCRIBE_EVENT(field, type) \
+    if(events.field){ \
+      se.se_type = (type); se.se_on = 1; \
+      if(sctp_sys_setsockopt(fileno, IPPROTO_SCTP, SCTP_EVENT, &se, sizeof(se)) < 0) \
+        rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno)); \
     }
 
-    if(sctp_sys_connectx(fileno, (struct sockaddr *)addrs6, num_ip, &assoc) < 0)
-      rb_raise(rb_eSystemCallError, "sctp_connectx: %s", strerror(errno));
-  }
-  else{
-    struct sockaddr_in addrs[MAX_IP_ADDRESSES];
-    bzero(&addrs, sizeof(addrs));
+    SUBSCRIBE_EVENT(sctp_association_event,       SCTP_ASSOC_CHANGE)
+    SUBSCRIBE_EVENT(sctp_address_event,           SCTP_PEER_ADDR_CHANGE)
+    SUBSCRIBE_EVENT(sctp_send_failure_event,      SCTP_SEND_FAILED)
+    SUBSCRIBE_EVENT(sctp_peer_error_event,        SCTP_REMOTE_ERROR)
+    SUBSCRIBE_EVENT(sctp_shutdown_event,          SCTP_SHUTDOWN_EVENT)
+    SUBSCRIBE_EVENT(sctp_partial_delivery_event,  SCTP_PARTIAL_DELIVERY_EVENT)
+    SUBSCRIBE_EVENT(sctp_adaptation_layer_event,  SCTP_ADAPTATION_INDICATION)
+    SUBSCRIBE_EVENT(sctp_authentication_event,    SCTP_AUTHENTICATION_EVENT)
+    SUBSCRIBE_EVENT(sctp_sender_dry_event,        SCTP_SENDER_DRY_EVENT)
+
+#undef SUBSCRIBE_EVENT
 
-    for(i = 0; i < num_ip; i++){
-      v_address = RARRAY_AREF(v_addresses, i);
-      parse_ip_address_v4(StringValueCStr(v_address), port, &addrs[i]);
+    /* The reconfiguration events may have no sctp_event_subscribe member */
+#define SUBSCRIBE_FLAG(flag, type) \
+    if(flag){ \
+      se.se_type = (type); se.se_on = 1; \
+      if(sctp_sys_setsockopt(fileno, IPPROTO_SCTP, SCTP_EVENT, &se, sizeof(se)) < 0) \
+        rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno)); \
     }
 
-    if(sctp_sys_connectx(fileno, (struct sockaddr *)addrs, num_ip, &assoc) < 0)
-      rb_raise(rb_eSystemCallError, "sctp_connectx: %s", strerror(errno));
+    SUBSCRIBE_FLAG(stream_reset,  SCTP_STREAM_RESET_EVENT)
+    SUBSCRIBE_FLAG(assoc_reset,   SCTP_ASSOC_RESET_EVENT)
+    SUBSCRIBE_FLAG(stream_change, SCTP_STREAM_CHANGE_EVENT)
+
+#undef SUBSCRIBE_FLAG
   }
+#else
+  (void)stream_reset;
+  (void)assoc_reset;
+  (void)stream_change;
 
-  rb_iv_set(self, "@association_id", INT2NUM(assoc));
+  if(sctp_sys_setsockopt(fileno, IPPROTO_SCTP, SCTP_EVENTS, &events, sizeof(events)) < 0)
+    rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
+#endif
 
   return self;
 }
 
 /*
  * call-seq:
- *    SCTP::Socket#close
+ *    SCTP::Socket#notification_filter=(options)
  *
- * Close the socket. You should always do this.
+ * Set a native filter for the notifications returned by the receive methods,
+ * so that notifications you don't care about are never turned into Ruby
+ * objects. Swallowed notifications are counted, and the receive method
+ * carries on with the next message.
  *
- * By default the underlying close operation is non-blocking. This means that the
- * bound IP addresses may not be available right away after closing. You may
- * optionally control this behavior with the +linger+ option.
+ * The +options+ hash uses the same event names as SCTP::Socket#subscribe.
+ * Each may be set to true to let every notification of that type through,
+ * or to an array of the states to let through, e.g. SCTP_COMM_LOST for the
+ * :association event. Events that aren't listed are swallowed.
  *
+ * With the :coalesce option, a peer address change notification is also
+ * swallowed if the address is already known to be in that state, which
+ * keeps a flapping link from flooding the receiver.
  *
- * * linger - If present, this should be set to a numeric value, in seconds.
- *     The value will cause the close operation to block for that number of
- *     seconds, after which it will return (i.e. return to non-blocking).
+ * The association table and peer address cache still see every
+ * notification. Pass nil to remove the filter.
  *
  * Example:
  *
- *   socket = SCTP::Socket.new
- *   socket.close # or
- *   socket.close(linger: 5)
+ *   socket.subscribe(:data_io => true, :association => true, :address => true)
+ *
+ *   socket.notification_filter = {
+ *     :association => [SCTP::Socket::SCTP_COMM_LOST],
+ *     :address     => [SCTP::Socket::SCTP_ADDR_UNREACHABLE],
+ *     :coalesce    => true
+ *   }
  */
-static VALUE rsctp_close(int argc, VALUE* argv, VALUE self){
-  VALUE v_options, v_linger, v_fileno;
-  sctp_sock_t fileno;
+static VALUE rsctp_set_notification_filter(VALUE self, VALUE v_options){
+  sctp_notification_filter_t* filter;
+  VALUE v_filter, v_value;
+  uint32_t mask, state;
+  size_t i;
+  long j;
 
-  rb_scan_args(argc, argv, "01", &v_options);
+  CHECK_SOCKET_CLOSED(self);
 
-  if(NIL_P(v_options))
-    v_options = rb_hash_new();
+  if(NIL_P(v_options)){
+    rb_ivar_set(self, rb_intern("notification_filter"), Qnil);
+    return Qnil;
+  }
 
   Check_Type(v_options, T_HASH);
 
-  v_linger = rb_hash_aref2(v_options, "linger");
-  v_fileno = rb_iv_get(self, "@fileno");
+  v_filter = TypedData_Make_Struct(0, sctp_notification_filter_t, &notification_filter_type, filter);
 
-  if(NIL_P(v_fileno)) // Already closed
-    return self;
+  for(i = 0; i < sizeof(notification_names) / sizeof(notification_names[0]); i++){
+    v_value = rb_hash_aref2(v_options, notification_names[i].name);
 
-  fileno = NUM_TO_SCTP_FD(v_fileno);
+    if(RB_TYPE_P(v_value, T_ARRAY)){
+      mask = 0;
 
-  if(!NIL_P(v_linger)){
-#ifdef HAVE_USRSCTP_H
-    /* usrsctp doesn't support SOL_SOCKET options; linger is not available */
-    (void)v_linger;
-#else
-    struct linger lin;
-    int linger_time = NUM2INT(v_linger);
+      for(j = 0; j < RARRAY_LEN(v_value); j++){
+        state = NUM2UINT(RARRAY_AREF(v_value, j));
 
-    if(linger_time < 0)
-      rb_raise(rb_eArgError, "linger time must be non-negative");
+        if(state >= 32)
+          rb_raise(rb_eArgError, "invalid notification state: %u", state);
 
-    lin.l_onoff = 1;
-    lin.l_linger = linger_time;
+        mask |= 1U << state;
+      }
+    }
+    else{
+      mask = RTEST(v_value) ? NOTIFICATION_ALL_STATES : 0;
+    }
 
-    if(sctp_sys_setsockopt(fileno, SOL_SOCKET, SO_LINGER, &lin, sizeof(struct linger)) < 0)
-      rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
-#endif
+    filter->allowed[NOTIFICATION_INDEX(notification_names[i].type)] = mask;
   }
 
-  if(sctp_sys_close(fileno) < 0)
-    rb_raise(rb_eSystemCallError, "close: %s", strerror(errno));
+  filter->coalesce = RTEST(rb_hash_aref2(v_options, "coalesce"));
 
-  // Mark socket as closed
-  rb_iv_set(self, "@fileno", Qnil);
+  rb_ivar_set(self, rb_intern("notification_filter"), v_filter);
 
-  return self;
+  return v_options;
 }
 
 /*
  * call-seq:
- *    SCTP::Socket#closed?
+ *    SCTP::Socket#filtered_notifications
  *
- * Returns true if the socket is closed, false otherwise.
+ * Returns the number of notifications swallowed by the current notification
+ * filter. See SCTP::Socket#notification_filter=.
+ */
+static VALUE rsctp_filtered_notifications(VALUE self){
+  VALUE v_filter = rb_attr_get(self, rb_intern("notification_filter"));
+  sctp_notification_filter_t* filter;
+
+  if(NIL_P(v_filter))
+    return INT2FIX(0);
+
+  filter = (sctp_notification_filter_t*)rb_check_typeddata(v_filter, &notification_filter_type);
+
+  return ULONG2NUM(filter->filtered);
+}
+
+/*
+ * call-seq:
+ *    SCTP::Socket#listen(backlog=128)
+ *
+ * Marks the socket referred to by sockfd as a passive socket, i.e. a socket that
+ * will be used to accept incoming connection requests.
+ *
+ * The backlog argument defines the maximum length to which the queue of
+ * pending connections for sockfd may grow. The default value is 128. The
+ * maximum value is Socket::SOMAXCONN.
+ *
+ * Why a default of 128? The answer is a "best guess" compromise between
+ * handling server load versus avoiding SYN flood attacks. I leave it as an
+ * exercise to the programmer to adjust as desired.
+ *
+ * See https://tangentsoft.com/wskfaq/advanced.html#backlog if you want
+ * more details on the advantages and drawbacks of various values.
  *
  * Example:
- *   socket = SCTP::Socket.new
- *   socket.closed? # => false
- *   socket.close
- *   socket.closed? # => true
+ *
+ *  socket = SCTP::Socket.new
+ *  socket.bind(:port => 62534, :addresses => ['127.0.0.1'])
+ *  socket.listen
  */
-static VALUE rsctp_closed_p(VALUE self){
-  VALUE v_fileno = rb_iv_get(self, "@fileno");
-  return NIL_P(v_fileno) ? Qtrue : Qfalse;
+static VALUE rsctp_listen(int argc, VALUE* argv, VALUE self){
+  VALUE v_backlog;
+  sctp_sock_t fileno;
+  int backlog;
+
+  rb_scan_args(argc, argv, "01", &v_backlog);
+
+  if(NIL_P(v_backlog))
+    backlog = 128;
+  else
+    backlog = NUM2INT(v_backlog);
+
+  if(backlog > SOMAXCONN)
+    rb_raise(rb_eArgError, "backlog value exceeds maximum value of: %i", SOMAXCONN);
+
+  CHECK_SOCKET_CLOSED(self);
+
+  fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+
+  if(sctp_sys_listen(fileno, backlog) < 0)
+    rb_raise(rb_eSystemCallError, "listen: %s", strerror(errno));
+
+  return self;
 }
 
 /*
  * call-seq:
- *    SCTP::Socket#getpeernames
- *
- * Return an array of all addresses of a peer of the current socket
- * and association number.
+ *    SCTP::Socket#peeloff(association_id)
  *
- * You may optionally pass a assocation fileno and association ID. Typically
- * this information would come from the peeloff method.
+ * Extracts an association contained by a one-to-many socket connection into
+ * a one-to-one style socket. Returns the socket descriptor (fileno).
  *
  * Example:
  *
  *   socket = SCTP::Socket.new
- *   # ...
- *   p socket.getpeernames
+ *   # etc...
  *
- *   info = socket.recvmsg
- *   association_fileno = socket.peeloff(info.association_id)
+ *   while true
+ *     info = socket.recvmsg
+ *     assoc_fileno = socket.peeloff(info.association_id)
+ *     # ... Do something with this new fileno
+ *   end
  *
- *   p socket.getpeernames(association_fileno, info.association_id)
+ * Use SCTP::Socket.for_fd to wrap the descriptor in an SCTP::Socket.
+ *
+ * The association's notifications go to the new socket from then on, so
+ * it is dropped from this socket's caches and association table here.
  */
-static VALUE rsctp_getpeernames(int argc, VALUE* argv, VALUE self){
+static VALUE rsctp_peeloff(VALUE self, VALUE v_assoc_id){
+  VALUE v_table;
+  sctp_sock_t fileno, assoc_fileno;
   sctp_assoc_t assoc_id;
-  struct sockaddr* addrs = NULL;
-  sctp_sock_t fileno;
-  int i, num_addrs;
-  char str[IP_BUFFER_SIZE];
-  VALUE v_fileno, v_association_id;
-  VALUE v_array = rb_ary_new();
 
-  rb_scan_args(argc, argv, "02", &v_fileno, &v_association_id);
+  CHECK_SOCKET_CLOSED(self);
 
-  if(NIL_P(v_fileno)){
-    CHECK_SOCKET_CLOSED(self);
-    fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
-  }
-  else{
-    fileno = NUM_TO_SCTP_FD(v_fileno);
-    CHECK_FILENO_VALID(fileno);
-  }
+  fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+  assoc_id = NUM2INT(v_assoc_id);
 
-  if(NIL_P(v_association_id))
-    assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
-  else
-    assoc_id = NUM2INT(v_association_id);
+  assoc_fileno = sctp_sys_peeloff(fileno, assoc_id);
 
-  num_addrs = sctp_sys_getpaddrs(fileno, assoc_id, &addrs);
+  if(SCTP_FD_INVALID(assoc_fileno))
+    rb_raise(rb_eSystemCallError, "sctp_peeloff: %s", strerror(errno));
 
-  if(num_addrs < 0){
-    if(addrs != NULL)
-      sctp_sys_freepaddrs(addrs);
+  forget_association(self, assoc_id);
 
-    rb_raise(rb_eSystemCallError, "sctp_getpaddrs: %s", strerror(errno));
-  }
+  v_table = rb_attr_get(self, rb_intern("associations"));
 
-  for(i = 0; i < num_addrs; i++){
-    struct sockaddr* sa = &addrs[i];
-    bzero(&str, sizeof(str));
+  if(!NIL_P(v_table))
+    rb_hash_delete(v_table, INT2NUM(assoc_id));
 
-    if(sa->sa_family == AF_INET6){
-      struct sockaddr_in6* sin6 = (struct sockaddr_in6*)sa;
-      inet_ntop(AF_INET6, &sin6->sin6_addr, str, sizeof(str));
-    }
-    else{
-      struct sockaddr_in* sin = (struct sockaddr_in*)sa;
-      inet_ntop(AF_INET, &sin->sin_addr, str, sizeof(str));
-    }
+  return SCTP_FD_TO_NUM(assoc_fileno);
+}
+
+/*
+ * call-seq:
+ *    SCTP::Socket#get_default_send_params
+ *
+ * Returns the default set of parameters that a call to the sendto function
+ * uses on this association. This is a struct that contains the following
+ * members:
+ *
+ *  * stream
+ *  * ssn
+ *  * flags
+ *  * ppid
+ *  * context
+ *  * ttl
+ *  * tsn
+ *  * cumtsn
+ *  * association_id
+ */
+static VALUE rsctp_get_default_send_params(VALUE self){
+  sctp_sock_t fileno;
+  socklen_t size;
+  sctp_assoc_t assoc_id;
+
+  CHECK_SOCKET_CLOSED(self);
+
+  fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+  assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
+
+#ifdef HAVE_USRSCTP_H
+  {
+    struct sctp_sndinfo sndinfo;
+    bzero(&sndinfo, sizeof(sndinfo));
+    size = sizeof(sndinfo);
+
+    if(sctp_sys_opt_info(fileno, assoc_id, SCTP_DEFAULT_SNDINFO, (void*)&sndinfo, &size) < 0)
+      rb_raise(rb_eSystemCallError, "sctp_opt_info: %s", strerror(errno));
+
+    return rb_struct_new(
+      v_sctp_default_send_params_struct,
+      INT2NUM(sndinfo.snd_sid),
+      INT2NUM(0),  /* ssn - not available via sndinfo */
+      INT2NUM(sndinfo.snd_flags),
+      INT2NUM(sndinfo.snd_ppid),
+      INT2NUM(sndinfo.snd_context),
+      INT2NUM(0),  /* timetolive - not available via sndinfo */
+      INT2NUM(0),  /* tsn - not available via sndinfo */
+      INT2NUM(0),  /* cumtsn - not available via sndinfo */
+      INT2NUM(sndinfo.snd_assoc_id)
+    );
+  }
+#else
+  {
+    struct sctp_sndrcvinfo sndrcv;
+    bzero(&sndrcv, sizeof(sndrcv));
+    size = sizeof(struct sctp_sndrcvinfo);
+
+    if(sctp_sys_opt_info(fileno, assoc_id, SCTP_DEFAULT_SEND_PARAM, (void*)&sndrcv, &size) < 0)
+      rb_raise(rb_eSystemCallError, "sctp_opt_info: %s", strerror(errno));
 
-    rb_ary_push(v_array, rb_str_new2(str));
+    return rb_struct_new(
+      v_sctp_default_send_params_struct,
+      INT2NUM(sndrcv.sinfo_stream),
+      INT2NUM(sndrcv.sinfo_ssn),
+      INT2NUM(sndrcv.sinfo_flags),
+      INT2NUM(sndrcv.sinfo_ppid),
+      INT2NUM(sndrcv.sinfo_context),
+      INT2NUM(sndrcv.sinfo_timetolive),
+      INT2NUM(sndrcv.sinfo_tsn),
+      INT2NUM(sndrcv.sinfo_cumtsn),
+      INT2NUM(sndrcv.sinfo_assoc_id)
+    );
   }
-
-  sctp_sys_freepaddrs(addrs);
-
-  return v_array;
+#endif
 }
 
 /*
  * call-seq:
- *    SCTP::Socket#getlocalnames
- *
- * Return an array of local addresses that are part of the association.
- *
- * Example:
+ *    SCTP::Socket#get_association_info
  *
- *  socket = SCTP::Socket.new
- *  socket.bind(:addresses => ['10.0.4.5', '10.0.5.5'])
- *  socket.getlocalnames # => ['10.0.4.5', '10.0.5.5'])
+ * Returns the association specific parameters. This is a struct
+ * that contains the following members:
  *
- *  # or get info from a peeled off association...
+ *  * association_id
+ *  * max_retransmission_count
+ *  * number_peer_destinations
+ *  * peer_receive_window
+ *  * local_receive_window
+ *  * cookie_life
  *
- *  assoc_fileno = socket.peeloff(some_association_id)
- *  socket.getlocalnames(assoc_fileno, some_association_id)
+ *  All values that refer to time values are measured in milliseconds.
  */
-static VALUE rsctp_getlocalnames(int argc, VALUE* argv, VALUE self){
-  sctp_assoc_t assoc_id;
-  struct sockaddr* addrs = NULL;
+static VALUE rsctp_get_association_info(VALUE self){
   sctp_sock_t fileno;
-  int i, num_addrs;
-  char str[IP_BUFFER_SIZE];
-  VALUE v_assoc_fileno, v_assoc_id;
-  VALUE v_array = rb_ary_new();
-
-  rb_scan_args(argc, argv, "02", &v_assoc_fileno, &v_assoc_id);
-
-  if(NIL_P(v_assoc_fileno)){
-    CHECK_SOCKET_CLOSED(self);
-    fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
-  }
-  else{
-    fileno = NUM_TO_SCTP_FD(v_assoc_fileno);
-    CHECK_FILENO_VALID(fileno);
-  }
-
-  if(NIL_P(v_assoc_id))
-    assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
-  else
-    assoc_id = NUM2INT(v_assoc_id);
-
-  num_addrs = sctp_sys_getladdrs(fileno, assoc_id, &addrs);
-
-  if(num_addrs < 0){
-    if(addrs != NULL)
-      sctp_sys_freeladdrs(addrs);
-
-    rb_raise(rb_eSystemCallError, "sctp_getladdrs: %s", strerror(errno));
-  }
+  socklen_t size;
+  sctp_assoc_t assoc_id;
+  struct sctp_assocparams assoc;
 
-  for(i = 0; i < num_addrs; i++){
-    struct sockaddr* sa = &addrs[i];
-    bzero(&str, sizeof(str));
+  bzero(&assoc, sizeof(assoc));
 
-    if(sa->sa_family == AF_INET6){
-      struct sockaddr_in6* sin6 = (struct sockaddr_in6*)sa;
-      inet_ntop(AF_INET6, &sin6->sin6_addr, str, sizeof(str));
-    }
-    else{
-      struct sockaddr_in* sin = (struct sockaddr_in*)sa;
-      inet_ntop(AF_INET, &sin->sin_addr, str, sizeof(str));
-    }
+  CHECK_SOCKET_CLOSED(self);
 
-    rb_ary_push(v_array, rb_str_new2(str));
-  }
+  fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+  assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
+  size = sizeof(struct sctp_assocparams);
 
-  sctp_sys_freeladdrs(addrs);
+  if(sctp_sys_opt_info(fileno, assoc_id, SCTP_ASSOCINFO, (void*)&assoc, &size) < 0)
+    rb_raise(rb_eSystemCallError, "sctp_opt_info: %s", strerror(errno));
 
-  return v_array;
+  return rb_struct_new(
+    v_sctp_associnfo_struct,
+    INT2NUM(assoc.sasoc_assoc_id),
+    INT2NUM(assoc.sasoc_asocmaxrxt),
+    INT2NUM(assoc.sasoc_number_peer_destinations),
+    INT2NUM(assoc.sasoc_peer_rwnd),
+    INT2NUM(assoc.sasoc_local_rwnd),
+    INT2NUM(assoc.sasoc_cookie_life)
+  );
 }
 
-#ifdef HAVE_SCTP_SENDV
 /*
  * call-seq:
- *    SCTP::Socket#sendv(options)
- *
- * Transmit a message to an SCTP endpoint using a gather-write. The following
- * hash of options is permitted:
- *
- *  * message   - An array of strings that will be joined into a single message.
- *  * addresses - An array of IP addresses to setup an association to send the message.
- *  * info_type - The type of information provided. The default is SCTP_SENDV_SNDINFO.
- *
- *  Example:
- *
- *    socket = SCTP::Socket.new
+ *    SCTP::Socket#set_association_info(options)
  *
- *    # You can specify addresses here or in an earlier connectx call.
- *    socket.sendv({
- *      :message   => ['Hello ', 'World.'],
- *      :addresses => ['10.0.5.4', '10.0.6.4'],
- *      :info_type => SCTP::Socket:::SCTP_SENDV_SNDINFO
- *    })
+ * Sets the association specific parameters. The +options+ parameter
+ * is a hash that accepts the following keywords:
  *
- *  CAVEAT: Currently info_type is not yet supported.
+ *  * association_id
+ *  * max_retransmission_count
+ *  * number_peer_destinations
+ *  * peer_receive_window
+ *  * local_receive_window
+ *  * cookie_life
  *
- *  Returns the number of bytes sent.
+ *  All values that refer to time values are measured in milliseconds.
  */
-static VALUE rsctp_sendv(VALUE self, VALUE v_options){
-  VALUE v_msg, v_message, v_addresses;
-  struct iovec iov[IOV_MAX];
-  struct sctp_sendv_spa spa;
+static VALUE rsctp_set_association_info(VALUE self, VALUE v_options){
+  VALUE v_assoc_id, v_max_rxt, v_nbr_peer, v_peer_rw, v_local_rw, v_cookie;
   sctp_sock_t fileno;
-  int i, size, num_ip, domain, port;
-  ssize_t num_bytes;
-
-  Check_Type(v_options, T_HASH);
-
-  bzero(&iov, sizeof(iov));
-  bzero(&spa, sizeof(spa));
-
-  v_message   = rb_hash_aref2(v_options, "message");
-  v_addresses = rb_hash_aref2(v_options, "addresses");
-
-  // Validate required message parameter
-  if(NIL_P(v_message))
-    rb_raise(rb_eArgError, "message parameter is required");
+  sctp_assoc_t assoc_id;
+  struct sctp_assocparams assoc;
 
-  Check_Type(v_message, T_ARRAY);
+  bzero(&assoc, sizeof(assoc));
 
   CHECK_SOCKET_CLOSED(self);
 
-  if(!NIL_P(v_addresses)){
-    Check_Type(v_addresses, T_ARRAY);
-    num_ip = (int)RARRAY_LEN(v_addresses);
-
-    if(num_ip > MAX_IP_ADDRESSES)
-      rb_raise(rb_eArgError, "too many IP addresses, maximum is eight");
-  }
-  else{
-    num_ip = 0;
-  }
-
   fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
-  size = (int)RARRAY_LEN(v_message);
 
-  if(!size)
-    rb_raise(rb_eArgError, "Must contain at least one message");
+  v_assoc_id = rb_hash_aref2(v_options, "association_id");
+  v_max_rxt  = rb_hash_aref2(v_options, "max_retransmission_count");
+  v_nbr_peer = rb_hash_aref2(v_options, "number_peer_destinations");
+  v_peer_rw  = rb_hash_aref2(v_options, "peer_receive_window");
+  v_local_rw = rb_hash_aref2(v_options, "local_receive_window");
+  v_cookie   = rb_hash_aref2(v_options, "cookie_life");
 
-  if(size > IOV_MAX)
-    rb_raise(rb_eArgError, "Array size is greater than IOV_MAX");
+  if(NIL_P(v_assoc_id))
+    assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
+  else
+    assoc_id = NUM2INT(v_assoc_id);
 
-  // TODO: Make this configurable
-  spa.sendv_flags = SCTP_SEND_SNDINFO_VALID;
-  spa.sendv_sndinfo.snd_flags = SCTP_UNORDERED;
-  spa.sendv_sndinfo.snd_assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
+  assoc.sasoc_assoc_id = assoc_id;
 
-  for(i = 0; i < size; i++){
-    v_msg = RARRAY_AREF(v_message, i);
-    iov[i].iov_base = StringValueCStr(v_msg);
-    iov[i].iov_len = RSTRING_LEN(v_msg);
-  }
+  if(!NIL_P(v_max_rxt))
+    assoc.sasoc_asocmaxrxt = NUM2INT(v_max_rxt);
 
-  domain = NUM2INT(rb_iv_get(self, "@domain"));
+  if(!NIL_P(v_nbr_peer))
+    assoc.sasoc_number_peer_destinations = NUM2INT(v_nbr_peer);
 
-  if(num_ip > 0){
-    VALUE v_address, v_port;
+  if(!NIL_P(v_peer_rw))
+    assoc.sasoc_peer_rwnd = NUM2INT(v_peer_rw);
 
-    v_port = rb_iv_get(self, "@port");
+  if(!NIL_P(v_local_rw))
+    assoc.sasoc_local_rwnd = NUM2INT(v_local_rw);
 
-    if(NIL_P(v_port))
-      port = 0;
-    else
-      port = NUM2INT(v_port);
+  if(!NIL_P(v_cookie))
+    assoc.sasoc_cookie_life = NUM2INT(v_cookie);
 
-    if(domain == AF_INET6){
-      struct sockaddr_in6* addrs6 = (struct sockaddr_in6*)alloca(num_ip * sizeof(struct sockaddr_in6));
-      bzero(addrs6, num_ip * sizeof(struct sockaddr_in6));
+  if(sctp_sys_setsockopt(fileno, IPPROTO_SCTP, SCTP_ASSOCINFO, &assoc, sizeof(assoc)) < 0)
+    rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
 
-      for(i = 0; i < num_ip; i++){
-        v_address = RARRAY_AREF(v_addresses, i);
-        parse_ip_address_v6(StringValueCStr(v_address), port, &addrs6[i]);
-      }
+  return rb_struct_new(
+    v_sctp_associnfo_struct,
+    INT2NUM(assoc.sasoc_assoc_id),
+    INT2NUM(assoc.sasoc_asocmaxrxt),
+    INT2NUM(assoc.sasoc_number_peer_destinations),
+    INT2NUM(assoc.sasoc_peer_rwnd),
+    INT2NUM(assoc.sasoc_local_rwnd),
+    INT2NUM(assoc.sasoc_cookie_life)
+  );
+}
 
-      num_bytes = (ssize_t)sctp_sys_sendv(
-        fileno,
-        iov,
-        size,
-        (struct sockaddr*)addrs6,
-        num_ip,
-        &spa,
-        sizeof(spa),
-        SCTP_SENDV_SPA,
-        0
-      );
-    }
-    else{
-      struct sockaddr_in* addrs = (struct sockaddr_in*)alloca(num_ip * sizeof(struct sockaddr_in));
-      bzero(addrs, num_ip * sizeof(struct sockaddr_in));
+/*
+ * call-seq:
+ *    SCTP::Socket#shutdown
+ *
+ * Shuts down socket send and receive operations.
+ *
+ * Optionally accepts an argument that specifieds the type of shutdown.
+ * This can be one of the following values:
+ *
+ *  * SHUT_RD   - Disables further receive operations.
+ *  * SHUT_WR   - Disables further send operations.
+ *  * SHUT_RDWR - Disables further send and receive operations.
+ *
+ *  The default is SHUT_RDWR.
+ */
+static VALUE rsctp_shutdown(int argc, VALUE* argv, VALUE self){
+  sctp_sock_t fileno;
+  int how;
+  VALUE v_how;
 
-      for(i = 0; i < num_ip; i++){
-        v_address = RARRAY_AREF(v_addresses, i);
-        parse_ip_address_v4(StringValueCStr(v_address), port, &addrs[i]);
-      }
+  CHECK_SOCKET_CLOSED(self);
 
-      num_bytes = (ssize_t)sctp_sys_sendv(
-        fileno,
-        iov,
-        size,
-        (struct sockaddr*)addrs,
-        num_ip,
-        &spa,
-        sizeof(spa),
-        SCTP_SENDV_SPA,
-        0
-      );
-    }
+  fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+
+  rb_scan_args(argc, argv, "01", &v_how);
+
+  if(NIL_P(v_how)){
+    how = SHUT_RDWR;
   }
   else{
-    num_bytes = (ssize_t)sctp_sys_sendv(
-      fileno,
-      iov,
-      size,
-      NULL,
-      0,
-      &spa,
-      sizeof(spa),
-      SCTP_SENDV_SPA,
-      0
-    );
+    Check_Type(v_how, T_FIXNUM);
+    how = NUM2INT(v_how);
   }
 
-  if(num_bytes < 0)
-    rb_raise(rb_eSystemCallError, "sctp_sendv: %s", strerror(errno));
+  if(sctp_sys_shutdown(fileno, how) < 0)
+    rb_raise(rb_eSystemCallError, "shutdown: %s", strerror(errno));
 
-  return LONG2NUM(num_bytes);
+  return self;
 }
-#endif
 
 /*
- * GVL-release helpers for blocking receive calls.
+ * call-seq:
+ *    SCTP::Socket#get_retransmission_info
  *
- * usrsctp_recvv blocks on internal userspace locks, not real system calls,
- * so Ruby's signal-handling thread never gets a chance to run.  By releasing
- * the GVL around the blocking call, other Ruby threads (including the signal
- * thread) can execute.  The UBF (unblock function) is invoked by Ruby when
- * it needs to interrupt the blocking call (e.g. Ctrl-C).
+ * Returns the protocol parameters that are used to initialize and bind the
+ * retransmission timeout (RTO) tunable. This is a struct with the following
+ * members:
  *
- * For native SCTP we use RUBY_UBF_IO which sends a signal that interrupts
- * the real recvmsg() syscall.  For usrsctp we shut down the read side of
- * the socket, which causes usrsctp_recvv to return with an error.
+ *  * association_id
+ *  * initial
+ *  * max
+ *  * min
  */
+static VALUE rsctp_get_retransmission_info(VALUE self){
+  sctp_sock_t fileno;
+  socklen_t size;
+  sctp_assoc_t assoc_id;
+  struct sctp_rtoinfo rto;
 
-/* --- recvmsg (sctp_recvmsg / usrsctp_recvv via sctp_sys_recvmsg) --- */
+  bzero(&rto, sizeof(rto));
 
-struct recvmsg_nogvl_args {
-  sctp_sock_t fd;
-  void       *buf;
-  size_t      len;
-  struct sockaddr *from;
-  socklen_t       *fromlen;
-  struct sctp_sndrcvinfo *sinfo;
-  int        *msg_flags;
-  ssize_t     result;
-  int         saved_errno;
-};
+  CHECK_SOCKET_CLOSED(self);
 
-static void *recvmsg_nogvl(void *arg){
-  struct recvmsg_nogvl_args *a = (struct recvmsg_nogvl_args *)arg;
-  a->result = sctp_sys_recvmsg(a->fd, a->buf, a->len,
-      a->from, a->fromlen, a->sinfo, a->msg_flags);
-  a->saved_errno = errno;
-  return NULL;
-}
+  fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+  assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
+  size = sizeof(struct sctp_rtoinfo);
 
-#ifdef HAVE_USRSCTP_H
-static void recvmsg_ubf(void *arg){
-  struct recvmsg_nogvl_args *a = (struct recvmsg_nogvl_args *)arg;
-  usrsctp_shutdown(a->fd, SHUT_RD);
+  if(sctp_sys_opt_info(fileno, assoc_id, SCTP_RTOINFO, (void*)&rto, &size) < 0)
+    rb_raise(rb_eSystemCallError, "sctp_opt_info: %s", strerror(errno));
+
+  return rb_struct_new(
+    v_sctp_rtoinfo_struct,
+    INT2NUM(rto.srto_assoc_id),
+    INT2NUM(rto.srto_initial),
+    INT2NUM(rto.srto_max),
+    INT2NUM(rto.srto_min)
+  );
 }
-#endif
 
-/* --- recvv (sctp_recvv / usrsctp_recvv via sctp_sys_recvv) --- */
+/*
+ * call-seq:
+ *    SCTP::Socket#set_retransmission_info(options)
+ *
+ * Sets the protocol parameters that are used to initialize and bind the
+ * retransmission timeout (RTO) tunable. The method accepts a hash with
+ * the following possible keys:
+ *
+ *  * association_id
+ *  * initial
+ *  * max
+ *  * min
+ *
+ *  The +initial+, +max+ and +min+ options default to zero (unchanged).
+ */
+static VALUE rsctp_set_retransmission_info(VALUE self, VALUE v_options){
+  VALUE v_assoc_id, v_initial, v_max, v_min;
+  sctp_sock_t fileno;
+  sctp_assoc_t assoc_id;
+  struct sctp_rtoinfo rto;
 
-struct recvv_nogvl_args {
-  sctp_sock_t fd;
-  const struct iovec *iov;
-  int          iovcnt;
-  struct sockaddr *from;
-  socklen_t       *fromlen;
-  void            *info;
-  socklen_t       *infolen;
-  unsigned int    *infotype;
-  int             *flags;
-  ssize_t          result;
-  int              saved_errno;
-};
+  bzero(&rto, sizeof(rto));
 
-static void *recvv_nogvl(void *arg){
-  struct recvv_nogvl_args *a = (struct recvv_nogvl_args *)arg;
-  a->result = sctp_sys_recvv(a->fd, a->iov, a->iovcnt,
-      a->from, a->fromlen, a->info, a->infolen, a->infotype, a->flags);
-  a->saved_errno = errno;
-  return NULL;
-}
+  CHECK_SOCKET_CLOSED(self);
 
-#ifdef HAVE_USRSCTP_H
-static void recvv_ubf(void *arg){
-  struct recvv_nogvl_args *a = (struct recvv_nogvl_args *)arg;
-  usrsctp_shutdown(a->fd, SHUT_RD);
+  fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+
+  v_assoc_id = rb_hash_aref2(v_options, "association_id");
+  v_initial = rb_hash_aref2(v_options, "initial");
+  v_max = rb_hash_aref2(v_options, "max");
+  v_min = rb_hash_aref2(v_options, "min");
+
+  if(NIL_P(v_assoc_id))
+    v_assoc_id = rb_iv_get(self, "@association_id");
+
+  assoc_id = NUM2INT(v_assoc_id);
+
+  rto.srto_assoc_id = assoc_id;
+
+  if(!NIL_P(v_initial))
+    rto.srto_initial = NUM2INT(v_initial);
+
+  if(!NIL_P(v_max))
+    rto.srto_max = NUM2INT(v_max);
+
+  if(!NIL_P(v_min))
+    rto.srto_min = NUM2INT(v_min);
+
+  if(sctp_sys_setsockopt(fileno, IPPROTO_SCTP, SCTP_RTOINFO, &rto, sizeof(rto)) < 0)
+    rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
+
+  return rb_struct_new(
+    v_sctp_rtoinfo_struct,
+    v_assoc_id,
+    v_initial,
+    v_max,
+    v_min
+  );
 }
-#endif
 
-#ifdef HAVE_SCTP_RECVV
 /*
  * call-seq:
- *    SCTP::Socket#recvv(flags=0, buffer_size=1024)
- *
- * Receive a message using sctp_recvv from another SCTP endpoint.
+ *    SCTP::Socket#get_status
  *
- * The optional buffer_size parameter specifies the size of the receive buffer
- * in bytes. Defaults to 1024 bytes if not specified.
+ * Get the status of a connected socket.
  *
  * Example:
  *
- *   begin
- *     socket = SCTP::Socket.new
- *     socket.bind(:port => 62534, :addresses => ['10.0.4.5', '10.0.5.5'])
- *     socket.listen
+ *   socket = SCTP::Socket.new
+ *   socket.connect(...)
+ *   socket.get_status
+ *
+ * Returns a Struct::Status object, which contains the following fields:
+ *
+ *  * association_id
+ *  * state
+ *  * receive_window
+ *  * unacknowledged_data
+ *  * pending_data
+ *  * inbound_streams
+ *  * outbound_streams
+ *  * fragmentation_point
+ *  * primary (IP)
+ *  * primary_srtt (smoothed round trip time of the primary path, in ms)
+ *  * primary_rto (retransmission timeout of the primary path, in ms)
+ *  * primary_cwnd (congestion window of the primary path, in bytes)
+ *  * primary_mtu (path MTU of the primary path)
+ */
+static VALUE rsctp_get_status(VALUE self){
+  sctp_sock_t fileno;
+  socklen_t size;
+  sctp_assoc_t assoc_id;
+  struct sctp_status status;
+  struct sctp_paddrinfo* spinfo;
+  char tmpname[INET6_ADDRSTRLEN];
+
+  bzero(&status, sizeof(status));
+
+  CHECK_SOCKET_CLOSED(self);
+
+  fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+  assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
+  size = sizeof(struct sctp_status);
+
+  if(sctp_sys_opt_info(fileno, assoc_id, SCTP_STATUS, (void*)&status, &size) < 0)
+    rb_raise(rb_eSystemCallError, "sctp_opt_info: %s", strerror(errno));
+
+  spinfo = &status.sstat_primary;
+
+  if (spinfo->spinfo_address.ss_family == AF_INET6) {
+		struct sockaddr_in6 *sin6;
+		sin6 = (struct sockaddr_in6 *)&spinfo->spinfo_address;
+		inet_ntop(AF_INET6, &sin6->sin6_addr, tmpname, sizeof (tmpname));
+	}
+  else {
+		struct sockaddr_in *sin;
+		sin = (struct sockaddr_in *)&spinfo->spinfo_address;
+		inet_ntop(AF_INET, &sin->sin_addr, tmpname, sizeof (tmpname));
+  }
+
+  return rb_struct_new(v_sctp_status_struct,
+    INT2NUM(status.sstat_assoc_id),
+    INT2NUM(status.sstat_state),
+    INT2NUM(status.sstat_rwnd),
+    INT2NUM(status.sstat_unackdata),
+    INT2NUM(status.sstat_penddata),
+    INT2NUM(status.sstat_instrms),
+    INT2NUM(status.sstat_outstrms),
+    INT2NUM(status.sstat_fragmentation_point),
+    rb_str_new2(tmpname),
+    UINT2NUM(spinfo->spinfo_srtt),
+    UINT2NUM(spinfo->spinfo_rto),
+    UINT2NUM(spinfo->spinfo_cwnd),
+    UINT2NUM(spinfo->spinfo_mtu)
+  );
+}
+
+/*
+ * call-seq:
+ *    SCTP::Socket#get_subscriptions
  *
- *     while true
- *       info = socket.recvv
- *       puts "Received message: #{info.message}"
+ * Returns a struct of events detailing which events have been
+ * subscribed to by the socket. The struct contains the following
+ * members:
  *
- *       # Or with custom buffer size
- *       info = socket.recvv(0, 4096)
- *       puts "Received message: #{info.message}"
- *     end
- *   ensure
- *     socket.close
- *   end
+ *  * data_io
+ *  * association
+ *  * address
+ *  * send_failure
+ *  * peer_error
+ *  * shutdown
+ *  * partial_delivery
+ *  * adaptation_layer
+ *  * authentication
+ *  * sender_dry
+ *  * stream_reset
+ *  * assoc_reset
+ *  * stream_change
+ *  * send_failure_event
  */
-static VALUE rsctp_recvv(int argc, VALUE* argv, VALUE self){
-  VALUE v_flags, v_buffer_size;
+static VALUE rsctp_get_subscriptions(VALUE self){
   sctp_sock_t fileno;
-  int flags, on, buffer_size;
-  ssize_t bytes;
-  uint infotype;
-  socklen_t infolen;
-  struct iovec iov[1];
-  struct sctp_rcvinfo info;
-  char *buffer;
-
-  bzero(&iov, sizeof(iov));
-  bzero(&info, sizeof(info));
+  sctp_assoc_t assoc_id;
+  struct sctp_event_subscribe events;
+#ifndef HAVE_USRSCTP_H
+  socklen_t size;
+#endif
 
-  rb_scan_args(argc, argv, "02", &v_flags, &v_buffer_size);
+  bzero(&events, sizeof(events));
 
   CHECK_SOCKET_CLOSED(self);
 
   fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+  assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
 
-  if(NIL_P(v_flags))
-    flags = 0;
-  else
-    flags = NUM2INT(v_flags);
-
-  if(NIL_P(v_buffer_size))
-    buffer_size = 1024;
-  else
-    buffer_size = NUM2INT(v_buffer_size);
+#ifdef HAVE_USRSCTP_H
+  /* usrsctp uses SCTP_EVENT + struct sctp_event for per-event query */
+  {
+    struct sctp_event se;
+    socklen_t se_size;
 
-  if(buffer_size <= 0)
-    rb_raise(rb_eArgError, "buffer size must be positive");
+    memset(&events, 0, sizeof(events));
 
-  buffer = (char*)malloc(buffer_size);
-  if(buffer == NULL)
-    rb_raise(rb_eNoMemError, "failed to allocate buffer");
+    /* data_io: check SCTP_RECVRCVINFO sockopt */
+    {
+      int on = 0;
+      socklen_t on_size = sizeof(on);
+      if(sctp_sys_getsockopt(fileno, IPPROTO_SCTP, SCTP_RECVRCVINFO, &on, &on_size) == 0 && on)
+        events.sctp_data_io_event = 1;
+    }
 
-  bzero(buffer, buffer_size);
+#define QUERY_EVENT(field, type) \
+    memset(&se, 0, sizeof(se)); \
+    se.se_assoc_id = assoc_id; \
+    se.se_type = (type); \
+    se_size = sizeof(se); \
+    if(sctp_sys_getsockopt(fileno, IPPROTO_SCTP, SCTP_EVENT, &se, &se_size) == 0 && se.se_on) \
+      events.field = 1;
 
-	iov->iov_base = buffer;
-	iov->iov_len = buffer_size;
+    QUERY_EVENT(sctp_association_event,       SCTP_ASSOC_CHANGE)
+    QUERY_EVENT(sctp_address_event,           SCTP_PEER_ADDR_CHANGE)
+    QUERY_EVENT(sctp_send_failure_event,      SCTP_SEND_FAILED)
+    QUERY_EVENT(sctp_peer_error_event,        SCTP_REMOTE_ERROR)
+    QUERY_EVENT(sctp_shutdown_event,          SCTP_SHUTDOWN_EVENT)
+    QUERY_EVENT(sctp_partial_delivery_event,  SCTP_PARTIAL_DELIVERY_EVENT)
+    QUERY_EVENT(sctp_adaptation_layer_event,  SCTP_ADAPTATION_INDICATION)
+    QUERY_EVENT(sctp_authentication_event,    SCTP_AUTHENTICATION_EVENT)
+    QUERY_EVENT(sctp_sender_dry_event,        SCTP_SENDER_DRY_EVENT)
+#ifdef HAVE_STRUCT_SCTP_EVENT_SUBSCRIBE_SCTP_STREAM_RESET_EVENT
+    QUERY_EVENT(sctp_stream_reset_event,      SCTP_STREAM_RESET_EVENT)
+#endif
 
-  on = 1;
-  if(sctp_sys_setsockopt(fileno, IPPROTO_SCTP, SCTP_RECVRCVINFO, &on, sizeof(on)) < 0){
-    free(buffer);
-    rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
+#undef QUERY_EVENT
   }
-
-  infolen = sizeof(struct sctp_rcvinfo);
-  infotype = 0;
-
-  {
-    struct recvv_nogvl_args recv_args;
-    recv_args.fd       = fileno;
-    recv_args.iov      = iov;
-    recv_args.iovcnt   = 1;
-    recv_args.from     = NULL;
-    recv_args.fromlen  = NULL;
-    recv_args.info     = &info;
-    recv_args.infolen  = &infolen;
-    recv_args.infotype = &infotype;
-    recv_args.flags    = &flags;
-
-#ifdef HAVE_USRSCTP_H
-    rb_thread_call_without_gvl(recvv_nogvl, &recv_args, recvv_ubf, &recv_args);
 #else
-    rb_thread_call_without_gvl(recvv_nogvl, &recv_args, RUBY_UBF_IO, NULL);
+  size = sizeof(struct sctp_event_subscribe);
+  if(sctp_sys_opt_info(fileno, assoc_id, SCTP_EVENTS, (void*)&events, &size) < 0)
+    rb_raise(rb_eSystemCallError, "sctp_opt_info: %s", strerror(errno));
 #endif
 
-    bytes = recv_args.result;
-    errno = recv_args.saved_errno;
-  }
-
-  if(bytes < 0){
-    free(buffer);
-    rb_raise(rb_eSystemCallError, "sctp_recvv: %s", strerror(errno));
-  }
-
-  if(infotype != SCTP_RECVV_RCVINFO){
-    free(buffer);
-    return Qnil;
-  }
-  else{
-    VALUE result = rb_struct_new(
-      v_sctp_receive_info_struct,
-      rb_str_new(iov->iov_base, bytes),
-      UINT2NUM(info.rcv_sid),
-      UINT2NUM(info.rcv_ssn),
-      UINT2NUM(info.rcv_flags),
-      UINT2NUM(info.rcv_ppid),
-      UINT2NUM(info.rcv_tsn),
-      UINT2NUM(info.rcv_cumtsn),
-      UINT2NUM(info.rcv_context),
-      UINT2NUM(info.rcv_assoc_id)
-    );
-    free(buffer);
-    return result;
-  }
-}
+  return rb_struct_new(
+    v_sctp_event_subscribe_struct,
+    (events.sctp_data_io_event ? Qtrue : Qfalse),
+    (events.sctp_association_event ? Qtrue : Qfalse),
+    (events.sctp_address_event ? Qtrue : Qfalse),
+    (events.sctp_send_failure_event ? Qtrue : Qfalse),
+    (events.sctp_peer_error_event ? Qtrue : Qfalse),
+    (events.sctp_shutdown_event ? Qtrue : Qfalse),
+    (events.sctp_partial_delivery_event ? Qtrue : Qfalse),
+    (events.sctp_adaptation_layer_event ? Qtrue : Qfalse),
+    (events.sctp_authentication_event ? Qtrue : Qfalse),
+    (events.sctp_sender_dry_event ? Qtrue : Qfalse)
+#ifdef HAVE_STRUCT_SCTP_EVENT_SUBSCRIBE_SCTP_STREAM_RESET_EVENT
+    ,(events.sctp_stream_reset_event ? Qtrue : Qfalse)
+#endif
+#ifdef HAVE_STRUCT_SCTP_EVENT_SUBSCRIBE_SCTP_ASSOC_RESET_EVENT
+    ,(events.sctp_assoc_reset_event ? Qtrue : Qfalse)
+#endif
+#ifdef HAVE_STRUCT_SCTP_EVENT_SUBSCRIBE_SCTP_STREAM_CHANGE_EVENT
+    ,(events.sctp_stream_change_event ? Qtrue : Qfalse)
 #endif
+#ifdef HAVE_STRUCT_SCTP_EVENT_SUBSCRIBE_SCTP_SEND_FAILURE_EVENT_EVENT
+    ,(events.sctp_send_failure_event_event ? Qtrue : Qfalse)
+#endif
+  );
+}
 
 /*
  * call-seq:
- *    SCTP::Socket.send(options)
- *
- * Send a message on an already-connected socket to a specific association.
- *
- * Example:
+ *    SCTP::Socket#get_peer_address_params
  *
- *   socket = SCTP::Socket.new
- *   socket.connect(:port => 42000, :addresses => ['10.0.4.5', '10.0.5.5'])
+ * Applications can enable or disable heartbeats for any peer address of
+ * an association, modify an address's heartbeat interval, force a
+ * heartbeat to be sent immediately, and adjust the address's maximum
+ * number of retransmissions sent before an address is considered
+ * unreachable.
  *
- *   socket.send(:message => "Hello World")
- *   socket.send(:message => "Hello World", :association_id => 37)
+ * This method returns a struct that contains this information. It contains
+ * the following struct members.
  *
+ * * association_id
+ * * address
+ * * heartbeat_interval
+ * * max_retransmission_count
+ * * path_mtu
+ * * flags
+ * * ipv6_flowlabel
  */
-static VALUE rsctp_send(VALUE self, VALUE v_options){
-  uint16_t stream;
-  uint32_t ppid, send_flags, ctrl_flags, ttl, context;
-  ssize_t num_bytes;
+static VALUE rsctp_get_peer_address_params(VALUE self){
   sctp_sock_t fileno;
+  char str[IP_BUFFER_SIZE];
+  socklen_t size;
   sctp_assoc_t assoc_id;
-  struct sctp_sndrcvinfo info;
-  VALUE v_msg, v_stream, v_ppid, v_context, v_send_flags, v_ctrl_flags, v_ttl, v_assoc_id;
-
-  Check_Type(v_options, T_HASH);
-
-  v_msg        = rb_hash_aref2(v_options, "message");
-  v_stream     = rb_hash_aref2(v_options, "stream");
-  v_ppid       = rb_hash_aref2(v_options, "ppid");
-  v_context    = rb_hash_aref2(v_options, "context");
-  v_send_flags = rb_hash_aref2(v_options, "send_flags");
-  v_ctrl_flags = rb_hash_aref2(v_options, "control_flags");
-  v_ttl        = rb_hash_aref2(v_options, "ttl");
-  v_assoc_id   = rb_hash_aref2(v_options, "association_id");
-
-  if(NIL_P(v_stream))
-    stream = 0;
-  else
-    stream = NUM2INT(v_stream);
-
-  if(NIL_P(v_send_flags))
-    send_flags = 0;
-  else
-    send_flags = NUM2INT(v_send_flags);
-
-  if(NIL_P(v_ctrl_flags))
-    ctrl_flags = 0;
-  else
-    ctrl_flags = NUM2INT(v_ctrl_flags);
-
-  if(NIL_P(v_ttl)){
-    ttl = 0;
-  }
-  else{
-    ttl = NUM2INT(v_ttl);
-    send_flags |= SCTP_PR_SCTP_TTL;
-  }
-
-  if(NIL_P(v_ppid))
-    ppid = 0;
-  else
-    ppid = NUM2INT(v_ppid);
-
-  if(NIL_P(v_context))
-    context = 0;
-  else
-    context = NUM2INT(v_context);
+  struct sctp_paddrparams paddr;
 
-  if(NIL_P(v_assoc_id))
-    assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
-  else
-    assoc_id = NUM2INT(v_assoc_id);
+  bzero(&paddr, sizeof(paddr));
+  bzero(&str, sizeof(str));
 
   CHECK_SOCKET_CLOSED(self);
 
-  info.sinfo_stream = stream;
-  info.sinfo_flags = send_flags;
-  info.sinfo_ppid = ppid;
-  info.sinfo_context = context;
-  info.sinfo_timetolive = ttl;
-  info.sinfo_assoc_id = assoc_id;
-
   fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+  assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
+  size = sizeof(struct sctp_paddrparams);
 
-  num_bytes = (ssize_t)sctp_sys_send(
-    fileno,
-    StringValueCStr(v_msg),
-    RSTRING_LEN(v_msg),
-    &info,
-    ctrl_flags
-  );
+  if(sctp_sys_opt_info(fileno, assoc_id, SCTP_PEER_ADDR_PARAMS, (void*)&paddr, &size) < 0)
+    rb_raise(rb_eSystemCallError, "sctp_opt_info: %s", strerror(errno));
 
-  if(num_bytes < 0)
-    rb_raise(rb_eSystemCallError, "sctp_send: %s", strerror(errno));
+  {
+    struct sockaddr* sa = (struct sockaddr*)&paddr.spp_address;
 
-  return LONG2NUM(num_bytes);
+    if(sa->sa_family == AF_INET6){
+      struct sockaddr_in6* sin6 = (struct sockaddr_in6*)sa;
+      inet_ntop(AF_INET6, &sin6->sin6_addr, str, sizeof(str));
+    }
+    else{
+      struct sockaddr_in* sin = (struct sockaddr_in*)sa;
+      inet_ntop(AF_INET, &sin->sin_addr, str, sizeof(str));
+    }
+  }
+
+  return rb_struct_new(
+    v_sctp_peer_addr_params_struct,
+    INT2NUM(paddr.spp_assoc_id),
+    rb_str_new2(str),
+    INT2NUM(paddr.spp_hbinterval),
+    INT2NUM(paddr.spp_pathmaxrxt),
+    INT2NUM(paddr.spp_pathmtu),
+    INT2NUM(paddr.spp_flags),
+    INT2NUM(paddr.spp_ipv6_flowlabel)
+  );
 }
 
 /*
  * call-seq:
- *    SCTP::Socket#sendmsg(options)
- *
- * Transmit a message to an SCTP endpoint. The following hash of options
- * is permitted:
- *
- *  :message   -> The message to send to the endpoint. Mandatory.
- *  :stream    -> The SCTP stream number you wish to send the message on.
- *  :addresses -> An array of addresses to send the message to.
- *  :context   -> The default context used for the sendmsg call if the send fails.
- *  :ppid      -> The payload protocol identifier that is passed to the peer endpoint.
- *  :flags     -> A bitwise integer that contain one or more values that control behavior.
+ *    SCTP::Socket#get_init_msg
  *
- *  Note that the :addresses option is not mandatory in a one-to-one (SOCK_STREAM)
- *  socket connection. However, it must have been set previously via the
- *  connect method.
+ * Returns a structure that contains various initialization parameters.
  *
- *  Example:
+ * * num_ostreams: A number representing the number of streams that the
+ *     application wishes to be able to send to.
  *
- *    socket = SCTP::Socket.new
+ * * max_instreams: The maximum number of inbound streams the application
+ *     is prepared to support.
  *
- *    socket.sendmsg(
- *      :message   => "Hello World!",
- *      :stream    => 3,
- *      :flags     => SCTP::Socket::SCTP_UNORDERED | SCTP::Socket::SCTP_SENDALL,
- *      :ttl       => 100,
- *      :addresses => ['10.0.5.4', '10.0.6.4']
- *    )
+ * * max_attempts: The number of attempts the SCTP endpoint should make at
+ *     resending the INIT.
  *
- *  Returns the number of bytes sent.
+ * * max_init_timeout: This value represents the largest Timeout or RTO value
+ *     (in milliseconds) to use in attempting an INIT.
  */
-static VALUE rsctp_sendmsg(VALUE self, VALUE v_options){
-  VALUE v_msg, v_ppid, v_flags, v_stream, v_ttl, v_context, v_addresses;
-  uint16_t stream;
-  uint32_t ppid, flags, ttl, context;
-  ssize_t num_bytes;
+static VALUE rsctp_get_init_msg(VALUE self){
   sctp_sock_t fileno;
-  int num_ip, domain;
-
-  Check_Type(v_options, T_HASH);
-
-  v_msg       = rb_hash_aref2(v_options, "message");
-  v_stream    = rb_hash_aref2(v_options, "stream");
-  v_ppid      = rb_hash_aref2(v_options, "ppid");
-  v_context   = rb_hash_aref2(v_options, "context");
-  v_flags     = rb_hash_aref2(v_options, "flags");
-  v_ttl       = rb_hash_aref2(v_options, "ttl");
-  v_addresses = rb_hash_aref2(v_options, "addresses");
-
-  if(NIL_P(v_msg))
-    rb_raise(rb_eArgError, "message parameter is required");
-
-  if(NIL_P(v_stream))
-    stream = 0;
-  else
-    stream = NUM2INT(v_stream);
-
-  if(NIL_P(v_flags))
-    flags = 0;
-  else
-    flags = NUM2INT(v_flags);
-
-  if(NIL_P(v_ttl)){
-    ttl = 0;
-  }
-  else{
-    ttl = NUM2INT(v_ttl);
-    flags |= SCTP_PR_SCTP_TTL;
-  }
-
-  if(NIL_P(v_ppid))
-    ppid = 0;
-  else
-    ppid = NUM2INT(v_ppid);
+  socklen_t size;
+  sctp_assoc_t assoc_id;
+  struct sctp_initmsg initmsg;
 
-  if(NIL_P(v_context))
-    context = 0;
-  else
-    context = NUM2INT(v_context);
+  bzero(&initmsg, sizeof(initmsg));
 
   CHECK_SOCKET_CLOSED(self);
 
   fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
-  domain = NUM2INT(rb_iv_get(self, "@domain"));
-
-  if(!NIL_P(v_addresses)){
-    int i, port;
-    VALUE v_address, v_port;
-
-    Check_Type(v_addresses, T_ARRAY);
-    num_ip = (int)RARRAY_LEN(v_addresses);
-
-    if(num_ip > MAX_IP_ADDRESSES)
-      rb_raise(rb_eArgError, "too many IP addresses, maximum is eight");
-
-    v_port = rb_hash_aref2(v_options, "port");
-
-    if(NIL_P(v_port))
-      port = 0;
-    else
-      port = NUM2INT(v_port);
-
-    if(domain == AF_INET6){
-      struct sockaddr_in6 addrs6[MAX_IP_ADDRESSES];
-
-      bzero(&addrs6, sizeof(addrs6));
+  assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
+  size = sizeof(struct sctp_initmsg);
 
-      for(i = 0; i < num_ip; i++){
-        v_address = RARRAY_AREF(v_addresses, i);
-        parse_ip_address_v6(StringValueCStr(v_address), port, &addrs6[i]);
-      }
+  if(sctp_sys_opt_info(fileno, assoc_id, SCTP_INITMSG, (void*)&initmsg, &size) < 0)
+    rb_raise(rb_eSystemCallError, "sctp_opt_info: %s", strerror(errno));
 
-      num_bytes = (ssize_t)sctp_sys_sendmsg(
-        fileno,
-        StringValueCStr(v_msg),
-        RSTRING_LEN(v_msg),
-        (struct sockaddr*)addrs6,
-        num_ip,
-        ppid,
-        flags,
-        stream,
-        ttl,
-        context
-      );
-    }
-    else{
-      struct sockaddr_in addrs[MAX_IP_ADDRESSES];
+  return rb_struct_new(
+    v_sctp_initmsg_struct,
+    INT2NUM(initmsg.sinit_num_ostreams),
+    INT2NUM(initmsg.sinit_max_instreams),
+    INT2NUM(initmsg.sinit_max_attempts),
+    INT2NUM(initmsg.sinit_max_init_timeo)
+  );
+}
 
-      bzero(&addrs, sizeof(addrs));
+/*
+ * call-seq:
+ *    SCTP::Socket#nodelay?
+ *
+ * Returns whether or not the nodelay option has been set.
+ */
+static VALUE rsctp_get_nodelay(VALUE self){
+  sctp_sock_t fileno;
+  socklen_t size;
+  sctp_assoc_t assoc_id;
+  int value;
 
-      for(i = 0; i < num_ip; i++){
-        v_address = RARRAY_AREF(v_addresses, i);
-        parse_ip_address_v4(StringValueCStr(v_address), port, &addrs[i]);
-      }
+  CHECK_SOCKET_CLOSED(self);
 
-      num_bytes = (ssize_t)sctp_sys_sendmsg(
-        fileno,
-        StringValueCStr(v_msg),
-        RSTRING_LEN(v_msg),
-        (struct sockaddr*)addrs,
-        num_ip,
-        ppid,
-        flags,
-        stream,
-        ttl,
-        context
-      );
-    }
-  }
-  else{
-    // No addresses - use empty addrs
-    num_ip = 0;
-    num_bytes = (ssize_t)sctp_sys_sendmsg(
-      fileno,
-      StringValueCStr(v_msg),
-      RSTRING_LEN(v_msg),
-      NULL,
-      0,
-      ppid,
-      flags,
-      stream,
-      ttl,
-      context
-    );
-  }
+  fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+  assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
+  size = sizeof(int);
 
-  if(num_bytes < 0)
-    rb_raise(rb_eSystemCallError, "sctp_sendmsg: %s", strerror(errno));
+  if(sctp_sys_opt_info(fileno, assoc_id, SCTP_NODELAY, (void*)&value, &size) < 0)
+    rb_raise(rb_eSystemCallError, "sctp_opt_info: %s", strerror(errno));
 
-  return LONG2NUM(num_bytes);
+  if(value)
+    return Qtrue;
+  else
+    return Qfalse;
 }
 
 /*
  * call-seq:
- *    SCTP::Socket#recvmsg(flags=0, buffer_size=1024)
- *
- * Receive a message from another SCTP endpoint.
- *
- * The optional buffer_size parameter specifies the size of the receive buffer
- * in bytes. Defaults to 1024 bytes if not specified.
- *
- * Example:
- *
- *   begin
- *     socket = SCTP::Socket.new
- *     socket.bind(:port => 62534, :addresses => ['10.0.4.5', '10.0.5.5'])
- *     socket.subscribe(:data_io => 1)
- *     socket.listen
- *
- *     while true
- *       info = socket.recvmsg
- *       puts "Received message: #{info.message}"
+ *    SCTP::Socket#nodelay=(bool)
  *
- *       # Or with custom buffer size
- *       info = socket.recvmsg(0, 4096)
- *       puts "Received message: #{info.message}"
- *     end
- *   ensure
- *     socket.close
- *   end
+ * Turn on/off any Nagle-like algorithm. This means that packets are generally
+ * sent as soon as possible and no unnecessary delays are introduced, at the
+ * cost of more packets in the network.
  */
-static VALUE rsctp_recvmsg(int argc, VALUE* argv, VALUE self){
-  VALUE v_flags, v_buffer_size, v_notification, v_message;
-  struct sctp_sndrcvinfo sndrcvinfo;
-  struct sockaddr_in clientaddr;
+static VALUE rsctp_set_nodelay(VALUE self, VALUE v_bool){
   sctp_sock_t fileno;
-  int flags, buffer_size;
-  ssize_t bytes;
-  char *buffer;
-  socklen_t length;
+  socklen_t size;
+  int value;
 
-  rb_scan_args(argc, argv, "02", &v_flags, &v_buffer_size);
+  CHECK_SOCKET_CLOSED(self);
+
+  fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+  size = sizeof(int);
 
-  if(NIL_P(v_flags))
-    flags = 0;
+  if(NIL_P(v_bool) || v_bool == Qfalse)
+    value = 0;
   else
-    flags = NUM2INT(v_flags);
+    value = 1;
 
-  if(NIL_P(v_buffer_size))
-    buffer_size = 1024;
-  else
-    buffer_size = NUM2INT(v_buffer_size);
+  if(sctp_sys_setsockopt(fileno, IPPROTO_SCTP, SCTP_NODELAY, &value, size) < 0)
+    rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
 
-  if(buffer_size <= 0)
-    rb_raise(rb_eArgError, "buffer size must be positive");
+  if(value)
+    return Qtrue;
+  else
+    return Qfalse;
+}
 
-  buffer = (char*)malloc(buffer_size);
-  if(buffer == NULL)
-    rb_raise(rb_eNoMemError, "failed to allocate buffer");
+/*
+ * call-seq:
+ *    SCTP::Socket#disable_fragments=(bool)
+ *
+ * This option is a on/off flag and is passed an integer where a non-
+ * zero is on and a zero is off.  If enabled no SCTP message
+ * fragmentation will be performed.  Instead if a message being sent
+ * exceeds the current PMTU size, the message will NOT be sent and
+ * instead a error will be indicated to the user.
+ */
+static VALUE rsctp_disable_fragments(VALUE self, VALUE v_bool){
+  sctp_sock_t fileno;
+  socklen_t size;
+  sctp_assoc_t assoc_id;
+  int value;
 
   CHECK_SOCKET_CLOSED(self);
 
   fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
-  length = sizeof(struct sockaddr_in);
-
-  bzero(buffer, buffer_size);
-  bzero(&clientaddr, sizeof(clientaddr));
-  bzero(&sndrcvinfo, sizeof(sndrcvinfo));
-
-  {
-    struct recvmsg_nogvl_args recv_args;
-    recv_args.fd       = fileno;
-    recv_args.buf      = buffer;
-    recv_args.len      = buffer_size;
-    recv_args.from     = (struct sockaddr*)&clientaddr;
-    recv_args.fromlen  = &length;
-    recv_args.sinfo    = &sndrcvinfo;
-    recv_args.msg_flags = &flags;
+  assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
+  size = sizeof(int);
 
-#ifdef HAVE_USRSCTP_H
-    rb_thread_call_without_gvl(recvmsg_nogvl, &recv_args, recvmsg_ubf, &recv_args);
-#else
-    rb_thread_call_without_gvl(recvmsg_nogvl, &recv_args, RUBY_UBF_IO, NULL);
-#endif
+  if(NIL_P(v_bool) || v_bool == Qfalse)
+    value = 0;
+  else
+    value = 1;
 
-    bytes = recv_args.result;
-    errno = recv_args.saved_errno;
-  }
+  if(sctp_sys_opt_info(fileno, assoc_id, SCTP_DISABLE_FRAGMENTS, (void*)&value, &size) < 0)
+    rb_raise(rb_eSystemCallError, "sctp_opt_info: %s", strerror(errno));
 
-  if(bytes < 0){
-    free(buffer);
-    rb_raise(rb_eSystemCallError, "sctp_recvmsg: %s", strerror(errno));
-  }
+  if(value)
+    return Qtrue;
+  else
+    return Qfalse;
+}
 
-  v_notification = Qnil;
+/*
+ * call-seq:
+ *    SCTP::Socket#autoclose
+ *
+ * Returns the number of seconds before socket associations automatically
+ * shut down.
+ */
+static VALUE rsctp_get_autoclose(VALUE self){
+  sctp_sock_t fileno;
+  socklen_t size;
+  sctp_assoc_t assoc_id;
+  int value;
 
-  if(flags & MSG_NOTIFICATION)
-    v_notification = get_notification_info(buffer);
+  CHECK_SOCKET_CLOSED(self);
 
-  if(NIL_P(v_notification))
-    v_message = rb_str_new(buffer, bytes);
-  else
-    v_message = Qnil;
+  fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+  assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
+  size = sizeof(int);
 
-  free(buffer);
+  if(sctp_sys_opt_info(fileno, assoc_id, SCTP_AUTOCLOSE, (void*)&value, &size) < 0)
+    rb_raise(rb_eSystemCallError, "sctp_opt_info: %s", strerror(errno));
 
-  return rb_struct_new(v_sndrcv_struct,
-    v_message,
-    UINT2NUM(sndrcvinfo.sinfo_stream),
-    UINT2NUM(sndrcvinfo.sinfo_flags),
-    UINT2NUM(sndrcvinfo.sinfo_ppid),
-    UINT2NUM(sndrcvinfo.sinfo_context),
-    UINT2NUM(sndrcvinfo.sinfo_timetolive),
-    UINT2NUM(sndrcvinfo.sinfo_assoc_id),
-    v_notification,
-    convert_sockaddr_in_to_struct(&clientaddr)
-  );
+  return INT2NUM(value);
 }
 
 /*
  * call-seq:
- *    SCTP::Socket#set_initmsg(options)
- *
- * Set the initial parameters used by the socket when sending out the INIT message.
- *
- * Example:
+ *    SCTP::Socket#autoclose=(seconds=0)
  *
- *  socket = SCTP::Socket.new
- *  socket.set_initmsg(:output_streams => 5, :input_streams => 5, :max_attempts => 4, :timeout => 30)
+ * When set it will cause associations that are idle for more than the specified
+ * number of seconds to automatically close using the graceful shutdown
+ * procedure. An association being idle is defined as an association that has
+ * NOT sent or received user data.
  *
- * The following parameters can be configured:
+ * The special value of 0 indicates that no automatic close of any associations
+ * should be performed, this is the default value. The option expects an integer
+ * defining the number of seconds of idle time before an association is closed.
  *
- *  :output_streams - The number of outbound SCTP streams an application would like to request.
- *  :input_streams  - The maximum number of inbound streams an application is prepared to allow.
- *  :max_attempts   - How many times the the SCTP stack should send the initial INIT message before it's considered unreachable.
- *  :timeout        - The maximum RTO value for the INIT timer.
+ * An application using this option should enable receiving the association
+ * change notification. This is the only mechanism an application is informed
+ * about the closing of an association. After an association is closed, the
+ * association ID assigned to it can be reused. An application should be aware
+ * of this to avoid the possible problem of sending data to an incorrect peer
+ * end point.
  *
- * By default these values are set to zero (i.e. ignored).
+ * This socket option is applicable to the one-to-many style socket only.
  */
-static VALUE rsctp_set_initmsg(VALUE self, VALUE v_options){
+static VALUE rsctp_set_autoclose(VALUE self, VALUE v_seconds){
   sctp_sock_t fileno;
-  struct sctp_initmsg initmsg;
-  VALUE v_output, v_input, v_attempts, v_timeout;
-
-  bzero(&initmsg, sizeof(initmsg));
+  int value;
 
   CHECK_SOCKET_CLOSED(self);
 
-  v_output   = rb_hash_aref2(v_options, "output_streams");
-  v_input    = rb_hash_aref2(v_options, "input_streams");
-  v_attempts = rb_hash_aref2(v_options, "max_attempts");
-  v_timeout  = rb_hash_aref2(v_options, "timeout");
-
+  value = NUM2INT(v_seconds);
   fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
 
-  if(!NIL_P(v_output))
-    initmsg.sinit_num_ostreams = NUM2INT(v_output);
+  if(sctp_sys_setsockopt(fileno, IPPROTO_SCTP, SCTP_AUTOCLOSE, &value, sizeof(value)) < 0)
+    rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
 
-  if(!NIL_P(v_input))
-    initmsg.sinit_max_instreams = NUM2INT(v_input);
+  return INT2NUM(value);
+}
 
-  if(!NIL_P(v_attempts))
-    initmsg.sinit_max_attempts = NUM2INT(v_attempts);
+/*
+ * call-seq:
+ *    SCTP::Socket#get_maxseg
+ *
+ * Returns the maximum size of the DATA chunks that user messages are broken
+ * into when sent, in bytes. A value of 0 means the size is determined by the
+ * current path MTU.
+ */
+static VALUE rsctp_get_maxseg(VALUE self){
+  sctp_sock_t fileno;
+  socklen_t size;
+  sctp_assoc_t assoc_id;
+  struct sctp_assoc_value assoc_value;
 
-  if(!NIL_P(v_timeout))
-    initmsg.sinit_max_init_timeo = NUM2INT(v_timeout);
+  CHECK_SOCKET_CLOSED(self);
 
-  if(sctp_sys_setsockopt(fileno, IPPROTO_SCTP, SCTP_INITMSG, &initmsg, sizeof(initmsg)) < 0)
-    rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
+  fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+  assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
+  size = sizeof(struct sctp_assoc_value);
 
-  return self;
+  bzero(&assoc_value, sizeof(assoc_value));
+  assoc_value.assoc_id = assoc_id;
+
+  if(sctp_sys_opt_info(fileno, assoc_id, SCTP_MAXSEG, (void*)&assoc_value, &size) < 0)
+    rb_raise(rb_eSystemCallError, "sctp_opt_info: %s", strerror(errno));
+
+  return UINT2NUM(assoc_value.assoc_value);
 }
 
 /*
  * call-seq:
- *    SCTP::Socket#subscribe(options)
- *
- * Subscribe to various notification type events, which will generate additional
- * data that the socket may receive. The possible notification type events are
- * as follows:
- *
- *   :association
- *   - A change has occurred to an association, either a new one has begun or an existing one has end.
- *
- *   :address
- *   - The state of one of the peer's addresses has experienced a change.
- *
- *   :send_failure
- *   - The message could not be delivered to a peer.
- *
- *   :shutdown
- *   - The peer has sent a shutdown to the local endpoint.
- *
- *   :data_io
- *   - Message data was received. You will want to subscribe to this in most cases.
- *
- *   Others:
- *
- *   :adaptation
- *   :authentication
- *   :partial_delivery
- *   :sender_dry
- *   :peer_error (aka remote error)
+ *    SCTP::Socket#maxseg=(bytes)
  *
- * Example:
- *
- *   socket = SCTP::Socket.new
+ * Sets the maximum size of the DATA chunks that user messages are broken
+ * into when sent. Messages larger than this are fragmented. If the value is
+ * larger than the path MTU allows, the path MTU is used instead. Setting it
+ * to 0 restores the default, i.e. fragmenting only when the path MTU
+ * requires it.
  *
- *   socket.bind(:port => port, :addresses => ['127.0.0.1'])
- *   socket.subscribe(:data_io => true, :shutdown => true, :send_failure => true)
+ * Smaller fragments let chunks from other streams be interleaved sooner, at
+ * the cost of more per-chunk overhead.
  */
-static VALUE rsctp_subscribe(VALUE self, VALUE v_options){
+static VALUE rsctp_set_maxseg(VALUE self, VALUE v_bytes){
   sctp_sock_t fileno;
-  struct sctp_event_subscribe events;
-
-  bzero(&events, sizeof(events));
-  Check_Type(v_options, T_HASH);
+  struct sctp_assoc_value assoc_value;
 
   CHECK_SOCKET_CLOSED(self);
 
   fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
 
-  if(RTEST(rb_hash_aref2(v_options, "data_io")))
-    events.sctp_data_io_event = 1;
-
-  if(RTEST(rb_hash_aref2(v_options, "association")))
-    events.sctp_association_event = 1;
-
-  if(RTEST(rb_hash_aref2(v_options, "address")))
-    events.sctp_address_event = 1;
-
-  if(RTEST(rb_hash_aref2(v_options, "send_failure")))
-#ifdef HAVE_STRUCT_SCTP_EVENT_SUBSCRIBE_SCTP_SEND_FAILURE_EVENT
-    events.sctp_send_failure_event = 1;
-#else
-    events.sctp_send_failure_event_event = 1;
-#endif
+  bzero(&assoc_value, sizeof(assoc_value));
+  assoc_value.assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
+  assoc_value.assoc_value = NUM2UINT(v_bytes);
 
-  if(RTEST(rb_hash_aref2(v_options, "peer_error")))
-    events.sctp_peer_error_event = 1;
+  if(sctp_sys_setsockopt(fileno, IPPROTO_SCTP, SCTP_MAXSEG, &assoc_value, sizeof(assoc_value)) < 0)
+    rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
 
-  if(RTEST(rb_hash_aref2(v_options, "shutdown")))
-    events.sctp_shutdown_event = 1;
+  return v_bytes;
+}
 
-  if(RTEST(rb_hash_aref2(v_options, "partial_delivery")))
-    events.sctp_partial_delivery_event = 1;
+/*
+ * call-seq:
+ *    SCTP::Socket#get_partial_delivery_point
+ *
+ * Returns the size, in bytes, that a partially received message must reach
+ * before the partial delivery API is invoked for it.
+ */
+static VALUE rsctp_get_partial_delivery_point(VALUE self){
+  sctp_sock_t fileno;
+  socklen_t size;
+  sctp_assoc_t assoc_id;
+  uint32_t value;
 
-  if(RTEST(rb_hash_aref2(v_options, "adaptation_layer")))
-    events.sctp_adaptation_layer_event = 1;
+  CHECK_SOCKET_CLOSED(self);
 
-  if(RTEST(rb_hash_aref2(v_options, "authentication")))
-    events.sctp_authentication_event = 1;
+  fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+  assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
+  size = sizeof(value);
 
-  if(RTEST(rb_hash_aref2(v_options, "sender_dry")))
-    events.sctp_sender_dry_event = 1;
+  if(sctp_sys_opt_info(fileno, assoc_id, SCTP_PARTIAL_DELIVERY_POINT, (void*)&value, &size) < 0)
+    rb_raise(rb_eSystemCallError, "sctp_opt_info: %s", strerror(errno));
 
-#ifdef HAVE_USRSCTP_H
-  /* usrsctp uses SCTP_EVENT + struct sctp_event for per-event subscription */
-  {
-    struct sctp_event se;
-    memset(&se, 0, sizeof(se));
-    se.se_assoc_id = 0;
+  return UINT2NUM(value);
+}
 
-    /* data_io: enable via SCTP_RECVRCVINFO sockopt */
-    if(events.sctp_data_io_event){
-      int on = 1;
-      if(sctp_sys_setsockopt(fileno, IPPROTO_SCTP, SCTP_RECVRCVINFO, &on, sizeof(on)) < 0)
-        rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
-    }
+/*
+ * call-seq:
+ *    SCTP::Socket#partial_delivery_point=(bytes)
+ *
+ * Sets the size, in bytes, at which the partial delivery API is invoked for
+ * a message that is still being received. Lower values let the application
+ * start reading large messages sooner, see SCTP::Socket#recvmsg for how to
+ * reassemble them.
+ */
+static VALUE rsctp_set_partial_delivery_point(VALUE self, VALUE v_bytes){
+  sctp_sock_t fileno;
+  uint32_t value;
 
-#define SUBSCRIBE_EVENT(field, type) \
-    if(events.field){ \
-      se.se_type = (type); se.se_on = 1; \
-      if(sctp_sys_setsockopt(fileno, IPPROTO_SCTP, SCTP_EVENT, &se, sizeof(se)) < 0) \
-        rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno)); \
-    }
+  CHECK_SOCKET_CLOSED(self);
 
-    SUBSCRIBE_EVENT(sctp_association_event,       SCTP_ASSOC_CHANGE)
-    SUBSCRIBE_EVENT(sctp_address_event,           SCTP_PEER_ADDR_CHANGE)
-    SUBSCRIBE_EVENT(sctp_send_failure_event,      SCTP_SEND_FAILED)
-    SUBSCRIBE_EVENT(sctp_peer_error_event,        SCTP_REMOTE_ERROR)
-    SUBSCRIBE_EVENT(sctp_shutdown_event,          SCTP_SHUTDOWN_EVENT)
-    SUBSCRIBE_EVENT(sctp_partial_delivery_event,  SCTP_PARTIAL_DELIVERY_EVENT)
-    SUBSCRIBE_EVENT(sctp_adaptation_layer_event,  SCTP_ADAPTATION_INDICATION)
-    SUBSCRIBE_EVENT(sctp_authentication_event,    SCTP_AUTHENTICATION_EVENT)
-    SUBSCRIBE_EVENT(sctp_sender_dry_event,        SCTP_SENDER_DRY_EVENT)
+  value = NUM2UINT(v_bytes);
+  fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
 
-#undef SUBSCRIBE_EVENT
-  }
-#else
-  if(sctp_sys_setsockopt(fileno, IPPROTO_SCTP, SCTP_EVENTS, &events, sizeof(events)) < 0)
+  if(sctp_sys_setsockopt(fileno, IPPROTO_SCTP, SCTP_PARTIAL_DELIVERY_POINT, &value, sizeof(value)) < 0)
     rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
-#endif
 
-  return self;
+  return v_bytes;
 }
 
 /*
  * call-seq:
- *    SCTP::Socket#listen(backlog=128)
- *
- * Marks the socket referred to by sockfd as a passive socket, i.e. a socket that
- * will be used to accept incoming connection requests.
+ *    SCTP::Socket#get_fragment_interleave
  *
- * The backlog argument defines the maximum length to which the queue of
- * pending connections for sockfd may grow. The default value is 128. The
- * maximum value is Socket::SOMAXCONN.
- *
- * Why a default of 128? The answer is a "best guess" compromise between
- * handling server load versus avoiding SYN flood attacks. I leave it as an
- * exercise to the programmer to adjust as desired.
+ * Returns the fragment interleave level for the socket. See
+ * SCTP::Socket#fragment_interleave= for the meaning of the levels.
+ */
+static VALUE rsctp_get_fragment_interleave(VALUE self){
+  sctp_sock_t fileno;
+  socklen_t size;
+  sctp_assoc_t assoc_id;
+  int value;
+
+  CHECK_SOCKET_CLOSED(self);
+
+  fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+  assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
+  size = sizeof(int);
+
+  if(sctp_sys_opt_info(fileno, assoc_id, SCTP_FRAGMENT_INTERLEAVE, (void*)&value, &size) < 0)
+    rb_raise(rb_eSystemCallError, "sctp_opt_info: %s", strerror(errno));
+
+  return INT2NUM(value);
+}
+
+/*
+ * call-seq:
+ *    SCTP::Socket#fragment_interleave=(level)
  *
- * See https://tangentsoft.com/wskfaq/advanced.html#backlog if you want
- * more details on the advantages and drawbacks of various values.
+ * Sets how partially delivered messages may be interleaved with others on
+ * receive. The level may be one of:
  *
- * Example:
+ * * 0: A partial delivery blocks all other messages on the socket.
+ * * 1: A partial delivery only blocks other messages from the same association.
+ * * 2: Messages from other streams in the same association may also be interleaved.
  *
- *  socket = SCTP::Socket.new
- *  socket.bind(:port => 62534, :addresses => ['127.0.0.1'])
- *  socket.listen
+ * Level 2 is required to enable I-DATA, see SCTP::Socket#interleaving_supported=.
+ * When interleaving, check the association_id and stream of each piece
+ * returned by SCTP::Socket#recvmsg to tell which message it belongs to.
  */
-static VALUE rsctp_listen(int argc, VALUE* argv, VALUE self){
-  VALUE v_backlog;
+static VALUE rsctp_set_fragment_interleave(VALUE self, VALUE v_level){
   sctp_sock_t fileno;
-  int backlog;
+  int value;
 
-  rb_scan_args(argc, argv, "01", &v_backlog);
+  CHECK_SOCKET_CLOSED(self);
 
-  if(NIL_P(v_backlog))
-    backlog = 128;
-  else
-    backlog = NUM2INT(v_backlog);
+  value = NUM2INT(v_level);
+  fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
 
-  if(backlog > SOMAXCONN)
-    rb_raise(rb_eArgError, "backlog value exceeds maximum value of: %i", SOMAXCONN);
+  if(sctp_sys_setsockopt(fileno, IPPROTO_SCTP, SCTP_FRAGMENT_INTERLEAVE, &value, sizeof(value)) < 0)
+    rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
+
+  return INT2NUM(value);
+}
+
+#ifdef SCTP_INTERLEAVING_SUPPORTED
+/*
+ * call-seq:
+ *    SCTP::Socket#interleaving_supported?
+ *
+ * Returns whether or not user message interleaving (I-DATA, RFC 8260) is
+ * enabled for the association.
+ */
+static VALUE rsctp_get_interleaving_supported(VALUE self){
+  sctp_sock_t fileno;
+  socklen_t size;
+  sctp_assoc_t assoc_id;
+  struct sctp_assoc_value assoc_value;
 
   CHECK_SOCKET_CLOSED(self);
 
   fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+  assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
+  size = sizeof(struct sctp_assoc_value);
 
-  if(sctp_sys_listen(fileno, backlog) < 0)
-    rb_raise(rb_eSystemCallError, "listen: %s", strerror(errno));
+  bzero(&assoc_value, sizeof(assoc_value));
+  assoc_value.assoc_id = assoc_id;
 
-  return self;
+  if(sctp_sys_opt_info(fileno, assoc_id, SCTP_INTERLEAVING_SUPPORTED, (void*)&assoc_value, &size) < 0)
+    rb_raise(rb_eSystemCallError, "sctp_opt_info: %s", strerror(errno));
+
+  if(assoc_value.assoc_value)
+    return Qtrue;
+  else
+    return Qfalse;
 }
 
 /*
  * call-seq:
- *    SCTP::Socket#peeloff(association_id)
- *
- * Extracts an association contained by a one-to-many socket connection into
- * a one-to-one style socket. Returns the socket descriptor (fileno).
- *
- * Example:
+ *    SCTP::Socket#interleaving_supported=(bool)
  *
- *   socket = SCTP::Socket.new
- *   # etc...
+ * Enables or disables user message interleaving (I-DATA, RFC 8260) for
+ * future associations. With interleaving a large message on one stream no
+ * longer blocks smaller messages on other streams of the same association.
  *
- *   while true
- *     info = socket.recvmsg
- *     assoc_fileno = socket.peeloff(info.association_id)
- *     # ... Do something with this new fileno
- *   end
+ * The fragment interleave level must be set to 2 first, see
+ * SCTP::Socket#fragment_interleave=. Both peers must support it.
  */
-static VALUE rsctp_peeloff(VALUE self, VALUE v_assoc_id){
-  sctp_sock_t fileno, assoc_fileno;
-  sctp_assoc_t assoc_id;
+static VALUE rsctp_set_interleaving_supported(VALUE self, VALUE v_bool){
+  sctp_sock_t fileno;
+  struct sctp_assoc_value assoc_value;
 
   CHECK_SOCKET_CLOSED(self);
 
   fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
-  assoc_id = NUM2INT(v_assoc_id);
 
-  assoc_fileno = sctp_sys_peeloff(fileno, assoc_id);
+  bzero(&assoc_value, sizeof(assoc_value));
+  assoc_value.assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
 
-  if(SCTP_FD_INVALID(assoc_fileno))
-    rb_raise(rb_eSystemCallError, "sctp_peeloff: %s", strerror(errno));
+  if(NIL_P(v_bool) || v_bool == Qfalse)
+    assoc_value.assoc_value = 0;
+  else
+    assoc_value.assoc_value = 1;
 
-  return SCTP_FD_TO_NUM(assoc_fileno);
+  if(sctp_sys_setsockopt(fileno, IPPROTO_SCTP, SCTP_INTERLEAVING_SUPPORTED, &assoc_value, sizeof(assoc_value)) < 0)
+    rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
+
+  if(assoc_value.assoc_value)
+    return Qtrue;
+  else
+    return Qfalse;
 }
+#endif
 
+#ifdef SCTP_STREAM_SCHEDULER
 /*
  * call-seq:
- *    SCTP::Socket#get_default_send_params
- *
- * Returns the default set of parameters that a call to the sendto function
- * uses on this association. This is a struct that contains the following
- * members:
+ *    SCTP::Socket#get_stream_scheduler(association_id=nil)
  *
- *  * stream
- *  * ssn
- *  * flags
- *  * ppid
- *  * context
- *  * ttl
- *  * tsn
- *  * cumtsn
- *  * association_id
+ * Returns the stream scheduler in use for the association, which is one of
+ * the SCTP_SS_* constants.
  */
-static VALUE rsctp_get_default_send_params(VALUE self){
+static VALUE rsctp_get_stream_scheduler(int argc, VALUE* argv, VALUE self){
+  VALUE v_assoc_id;
   sctp_sock_t fileno;
   socklen_t size;
   sctp_assoc_t assoc_id;
+  struct sctp_assoc_value assoc_value;
+
+  rb_scan_args(argc, argv, "01", &v_assoc_id);
 
   CHECK_SOCKET_CLOSED(self);
 
   fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
-  assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
 
-#ifdef HAVE_USRSCTP_H
-  {
-    struct sctp_sndinfo sndinfo;
-    bzero(&sndinfo, sizeof(sndinfo));
-    size = sizeof(sndinfo);
+  if(NIL_P(v_assoc_id))
+    v_assoc_id = rb_iv_get(self, "@association_id");
 
-    if(sctp_sys_opt_info(fileno, assoc_id, SCTP_DEFAULT_SNDINFO, (void*)&sndinfo, &size) < 0)
-      rb_raise(rb_eSystemCallError, "sctp_opt_info: %s", strerror(errno));
+  assoc_id = NUM2INT(v_assoc_id);
+  size = sizeof(struct sctp_assoc_value);
 
-    return rb_struct_new(
-      v_sctp_default_send_params_struct,
-      INT2NUM(sndinfo.snd_sid),
-      INT2NUM(0),  /* ssn - not available via sndinfo */
-      INT2NUM(sndinfo.snd_flags),
-      INT2NUM(sndinfo.snd_ppid),
-      INT2NUM(sndinfo.snd_context),
-      INT2NUM(0),  /* timetolive - not available via sndinfo */
-      INT2NUM(0),  /* tsn - not available via sndinfo */
-      INT2NUM(0),  /* cumtsn - not available via sndinfo */
-      INT2NUM(sndinfo.snd_assoc_id)
-    );
-  }
-#else
-  {
-    struct sctp_sndrcvinfo sndrcv;
-    bzero(&sndrcv, sizeof(sndrcv));
-    size = sizeof(struct sctp_sndrcvinfo);
+  bzero(&assoc_value, sizeof(assoc_value));
+  assoc_value.assoc_id = assoc_id;
 
-    if(sctp_sys_opt_info(fileno, assoc_id, SCTP_DEFAULT_SEND_PARAM, (void*)&sndrcv, &size) < 0)
-      rb_raise(rb_eSystemCallError, "sctp_opt_info: %s", strerror(errno));
+  if(sctp_sys_opt_info(fileno, assoc_id, SCTP_STREAM_SCHEDULER, (void*)&assoc_value, &size) < 0)
+    rb_raise(rb_eSystemCallError, "sctp_opt_info: %s", strerror(errno));
 
-    return rb_struct_new(
-      v_sctp_default_send_params_struct,
-      INT2NUM(sndrcv.sinfo_stream),
-      INT2NUM(sndrcv.sinfo_ssn),
-      INT2NUM(sndrcv.sinfo_flags),
-      INT2NUM(sndrcv.sinfo_ppid),
-      INT2NUM(sndrcv.sinfo_context),
-      INT2NUM(sndrcv.sinfo_timetolive),
-      INT2NUM(sndrcv.sinfo_tsn),
-      INT2NUM(sndrcv.sinfo_cumtsn),
-      INT2NUM(sndrcv.sinfo_assoc_id)
-    );
-  }
-#endif
+  return UINT2NUM(assoc_value.assoc_value);
 }
 
 /*
  * call-seq:
- *    SCTP::Socket#get_association_info
+ *    SCTP::Socket#set_stream_scheduler(options)
  *
- * Returns the association specific parameters. This is a struct
- * that contains the following members:
+ * Selects the scheduler that decides which outgoing stream is served next
+ * when several streams have data queued. By default streams are served
+ * first come, first served, so a bulk transfer on one stream can hold up
+ * small messages on another. The priority and round robin schedulers avoid
+ * this.
  *
- *  * association_id
- *  * max_retransmission_count
- *  * number_peer_destinations
- *  * peer_receive_window
- *  * local_receive_window
- *  * cookie_life
+ * The +options+ hash may contain the following keys:
  *
- *  All values that refer to time values are measured in milliseconds.
+ * * scheduler: One of the SCTP_SS_* constants (required)
+ * * association_id: The association identification (ignored for one-to-one sockets)
+ *
+ * Example:
+ *
+ *   socket.set_stream_scheduler(:scheduler => SCTP::Socket::SCTP_SS_PRIO)
  */
-static VALUE rsctp_get_association_info(VALUE self){
+static VALUE rsctp_set_stream_scheduler(VALUE self, VALUE v_options){
+  VALUE v_scheduler, v_assoc_id;
   sctp_sock_t fileno;
-  socklen_t size;
-  sctp_assoc_t assoc_id;
-  struct sctp_assocparams assoc;
+  struct sctp_assoc_value assoc_value;
 
-  bzero(&assoc, sizeof(assoc));
+  if(!RB_TYPE_P(v_options, T_HASH))
+    rb_raise(rb_eTypeError, "options must be a hash");
 
   CHECK_SOCKET_CLOSED(self);
 
   fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
-  assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
-  size = sizeof(struct sctp_assocparams);
 
-  if(sctp_sys_opt_info(fileno, assoc_id, SCTP_ASSOCINFO, (void*)&assoc, &size) < 0)
-    rb_raise(rb_eSystemCallError, "sctp_opt_info: %s", strerror(errno));
+  v_scheduler = rb_hash_aref2(v_options, "scheduler");
+  v_assoc_id = rb_hash_aref2(v_options, "association_id");
 
-  return rb_struct_new(
-    v_sctp_associnfo_struct,
-    INT2NUM(assoc.sasoc_assoc_id),
-    INT2NUM(assoc.sasoc_asocmaxrxt),
-    INT2NUM(assoc.sasoc_number_peer_destinations),
-    INT2NUM(assoc.sasoc_peer_rwnd),
-    INT2NUM(assoc.sasoc_local_rwnd),
-    INT2NUM(assoc.sasoc_cookie_life)
-  );
+  if(NIL_P(v_scheduler))
+    rb_raise(rb_eArgError, "scheduler parameter is required");
+
+  if(NIL_P(v_assoc_id))
+    v_assoc_id = rb_iv_get(self, "@association_id");
+
+  bzero(&assoc_value, sizeof(assoc_value));
+  assoc_value.assoc_id = NUM2INT(v_assoc_id);
+  assoc_value.assoc_value = NUM2UINT(v_scheduler);
+
+  if(sctp_sys_setsockopt(fileno, IPPROTO_SCTP, SCTP_STREAM_SCHEDULER, &assoc_value, sizeof(assoc_value)) < 0)
+    rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
+
+  return v_options;
 }
 
 /*
  * call-seq:
- *    SCTP::Socket#set_association_info(options)
- *
- * Sets the association specific parameters. The +options+ parameter
- * is a hash that accepts the following keywords:
- *
- *  * association_id
- *  * max_retransmission_count
- *  * number_peer_destinations
- *  * peer_receive_window
- *  * local_receive_window
- *  * cookie_life
+ *    SCTP::Socket#get_stream_scheduler_value(stream, association_id=nil)
  *
- *  All values that refer to time values are measured in milliseconds.
+ * Returns a struct containing the association_id, stream and scheduler
+ * value, i.e. priority or weight, for the given outgoing stream.
  */
-static VALUE rsctp_set_association_info(VALUE self, VALUE v_options){
-  VALUE v_assoc_id, v_max_rxt, v_nbr_peer, v_peer_rw, v_local_rw, v_cookie;
+static VALUE rsctp_get_stream_scheduler_value(int argc, VALUE* argv, VALUE self){
+  VALUE v_stream, v_assoc_id;
   sctp_sock_t fileno;
+  socklen_t size;
   sctp_assoc_t assoc_id;
-  struct sctp_assocparams assoc;
+  struct sctp_stream_value stream_value;
 
-  bzero(&assoc, sizeof(assoc));
+  rb_scan_args(argc, argv, "11", &v_stream, &v_assoc_id);
 
   CHECK_SOCKET_CLOSED(self);
 
   fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
 
-  v_assoc_id = rb_hash_aref2(v_options, "association_id");
-  v_max_rxt  = rb_hash_aref2(v_options, "max_retransmission_count");
-  v_nbr_peer = rb_hash_aref2(v_options, "number_peer_destinations");
-  v_peer_rw  = rb_hash_aref2(v_options, "peer_receive_window");
-  v_local_rw = rb_hash_aref2(v_options, "local_receive_window");
-  v_cookie   = rb_hash_aref2(v_options, "cookie_life");
-
   if(NIL_P(v_assoc_id))
-    assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
-  else
-    assoc_id = NUM2INT(v_assoc_id);
-
-  assoc.sasoc_assoc_id = assoc_id;
-
-  if(!NIL_P(v_max_rxt))
-    assoc.sasoc_asocmaxrxt = NUM2INT(v_max_rxt);
-
-  if(!NIL_P(v_nbr_peer))
-    assoc.sasoc_number_peer_destinations = NUM2INT(v_nbr_peer);
-
-  if(!NIL_P(v_peer_rw))
-    assoc.sasoc_peer_rwnd = NUM2INT(v_peer_rw);
+    v_assoc_id = rb_iv_get(self, "@association_id");
 
-  if(!NIL_P(v_local_rw))
-    assoc.sasoc_local_rwnd = NUM2INT(v_local_rw);
+  assoc_id = NUM2INT(v_assoc_id);
+  size = sizeof(struct sctp_stream_value);
 
-  if(!NIL_P(v_cookie))
-    assoc.sasoc_cookie_life = NUM2INT(v_cookie);
+  bzero(&stream_value, sizeof(stream_value));
+  stream_value.assoc_id = assoc_id;
+  stream_value.stream_id = NUM2USHORT(v_stream);
 
-  if(sctp_sys_setsockopt(fileno, IPPROTO_SCTP, SCTP_ASSOCINFO, &assoc, sizeof(assoc)) < 0)
-    rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
+  if(sctp_sys_opt_info(fileno, assoc_id, SCTP_STREAM_SCHEDULER_VALUE, (void*)&stream_value, &size) < 0)
+    rb_raise(rb_eSystemCallError, "sctp_opt_info: %s", strerror(errno));
 
   return rb_struct_new(
-    v_sctp_associnfo_struct,
-    INT2NUM(assoc.sasoc_assoc_id),
-    INT2NUM(assoc.sasoc_asocmaxrxt),
-    INT2NUM(assoc.sasoc_number_peer_destinations),
-    INT2NUM(assoc.sasoc_peer_rwnd),
-    INT2NUM(assoc.sasoc_local_rwnd),
-    INT2NUM(assoc.sasoc_cookie_life)
+    v_sctp_stream_value_struct,
+    INT2NUM(stream_value.assoc_id),
+    UINT2NUM(stream_value.stream_id),
+    UINT2NUM(stream_value.stream_value)
   );
 }
 
 /*
  * call-seq:
- *    SCTP::Socket#shutdown
+ *    SCTP::Socket#set_stream_scheduler_value(options)
  *
- * Shuts down socket send and receive operations.
+ * Sets the scheduler value for an outgoing stream. Its meaning depends on
+ * the scheduler. For the priority scheduler it is the priority, where lower
+ * values are served first. For weighted schedulers it is the weight.
  *
- * Optionally accepts an argument that specifieds the type of shutdown.
- * This can be one of the following values:
+ * The +options+ hash may contain the following keys:
  *
- *  * SHUT_RD   - Disables further receive operations.
- *  * SHUT_WR   - Disables further send operations.
- *  * SHUT_RDWR - Disables further send and receive operations.
+ * * stream: The stream number (required)
+ * * value: The priority or weight for the stream (required)
+ * * association_id: The association identification (ignored for one-to-one sockets)
  *
- *  The default is SHUT_RDWR.
+ * Example:
+ *
+ *   # Serve signalling on stream 0 ahead of bulk data on stream 1
+ *   socket.set_stream_scheduler(:scheduler => SCTP::Socket::SCTP_SS_PRIO)
+ *   socket.set_stream_scheduler_value(:stream => 0, :value => 0)
+ *   socket.set_stream_scheduler_value(:stream => 1, :value => 10)
  */
-static VALUE rsctp_shutdown(int argc, VALUE* argv, VALUE self){
+static VALUE rsctp_set_stream_scheduler_value(VALUE self, VALUE v_options){
+  VALUE v_stream, v_value, v_assoc_id;
   sctp_sock_t fileno;
-  int how;
-  VALUE v_how;
+  struct sctp_stream_value stream_value;
+
+  if(!RB_TYPE_P(v_options, T_HASH))
+    rb_raise(rb_eTypeError, "options must be a hash");
 
   CHECK_SOCKET_CLOSED(self);
 
   fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
 
-  rb_scan_args(argc, argv, "01", &v_how);
+  v_stream = rb_hash_aref2(v_options, "stream");
+  v_value = rb_hash_aref2(v_options, "value");
+  v_assoc_id = rb_hash_aref2(v_options, "association_id");
 
-  if(NIL_P(v_how)){
-    how = SHUT_RDWR;
-  }
-  else{
-    Check_Type(v_how, T_FIXNUM);
-    how = NUM2INT(v_how);
-  }
+  if(NIL_P(v_stream))
+    rb_raise(rb_eArgError, "stream parameter is required");
 
-  if(sctp_sys_shutdown(fileno, how) < 0)
-    rb_raise(rb_eSystemCallError, "shutdown: %s", strerror(errno));
+  if(NIL_P(v_value))
+    rb_raise(rb_eArgError, "value parameter is required");
 
-  return self;
+  if(NIL_P(v_assoc_id))
+    v_assoc_id = rb_iv_get(self, "@association_id");
+
+  bzero(&stream_value, sizeof(stream_value));
+  stream_value.assoc_id = NUM2INT(v_assoc_id);
+  stream_value.stream_id = NUM2USHORT(v_stream);
+  stream_value.stream_value = NUM2USHORT(v_value);
+
+  if(sctp_sys_setsockopt(fileno, IPPROTO_SCTP, SCTP_STREAM_SCHEDULER_VALUE, &stream_value, sizeof(stream_value)) < 0)
+    rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
+
+  return v_options;
 }
+#endif
 
+#ifdef SCTP_DEFAULT_PRINFO
 /*
  * call-seq:
- *    SCTP::Socket#get_retransmission_info
- *
- * Returns the protocol parameters that are used to initialize and bind the
- * retransmission timeout (RTO) tunable. This is a struct with the following
- * members:
+ *    SCTP::Socket#get_default_prinfo(association_id=nil)
  *
- *  * association_id
- *  * initial
- *  * max
- *  * min
+ * Returns a struct containing the association_id, policy and value of the
+ * default partial reliability policy, which applies to messages sent
+ * without one of their own.
  */
-static VALUE rsctp_get_retransmission_info(VALUE self){
+static VALUE rsctp_get_default_prinfo(int argc, VALUE* argv, VALUE self){
+  VALUE v_assoc_id;
   sctp_sock_t fileno;
   socklen_t size;
   sctp_assoc_t assoc_id;
-  struct sctp_rtoinfo rto;
+  struct sctp_default_prinfo prinfo;
 
-  bzero(&rto, sizeof(rto));
+  rb_scan_args(argc, argv, "01", &v_assoc_id);
 
   CHECK_SOCKET_CLOSED(self);
 
   fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
-  assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
-  size = sizeof(struct sctp_rtoinfo);
 
-  if(sctp_sys_opt_info(fileno, assoc_id, SCTP_RTOINFO, (void*)&rto, &size) < 0)
+  if(NIL_P(v_assoc_id))
+    v_assoc_id = rb_iv_get(self, "@association_id");
+
+  assoc_id = NUM2INT(v_assoc_id);
+  size = sizeof(struct sctp_default_prinfo);
+
+  bzero(&prinfo, sizeof(prinfo));
+  prinfo.pr_assoc_id = assoc_id;
+
+  if(sctp_sys_opt_info(fileno, assoc_id, SCTP_DEFAULT_PRINFO, (void*)&prinfo, &size) < 0)
     rb_raise(rb_eSystemCallError, "sctp_opt_info: %s", strerror(errno));
 
   return rb_struct_new(
-    v_sctp_rtoinfo_struct,
-    INT2NUM(rto.srto_assoc_id),
-    INT2NUM(rto.srto_initial),
-    INT2NUM(rto.srto_max),
-    INT2NUM(rto.srto_min)
+    v_sctp_default_prinfo_struct,
+    INT2NUM(prinfo.pr_assoc_id),
+    UINT2NUM(prinfo.pr_policy),
+    UINT2NUM(prinfo.pr_value)
   );
 }
 
 /*
  * call-seq:
- *    SCTP::Socket#set_retransmission_info(options)
+ *    SCTP::Socket#set_default_prinfo(options)
  *
- * Sets the protocol parameters that are used to initialize and bind the
- * retransmission timeout (RTO) tunable. The method accepts a hash with
- * the following possible keys:
+ * Sets the default partial reliability policy for messages that are sent
+ * without one of their own. This lets an application abandon stale data,
+ * rather than retransmit it, without passing a policy on every send.
  *
- *  * association_id
- *  * initial
- *  * max
- *  * min
+ * The +options+ hash may contain the following keys:
  *
- *  The +initial+, +max+ and +min+ options default to zero (unchanged).
+ * * policy: One of the SCTP_PR_SCTP_* constants (required)
+ * * value: The lifetime in milliseconds for SCTP_PR_SCTP_TTL, or the
+ *     maximum number of retransmissions for SCTP_PR_SCTP_RTX
+ * * association_id: The association identification (ignored for one-to-one sockets)
+ *
+ * Example:
+ *
+ *   # Abandon anything that has not been delivered within 50ms
+ *   socket.set_default_prinfo(:policy => SCTP::Socket::SCTP_PR_SCTP_TTL, :value => 50)
  */
-static VALUE rsctp_set_retransmission_info(VALUE self, VALUE v_options){
-  VALUE v_assoc_id, v_initial, v_max, v_min;
+static VALUE rsctp_set_default_prinfo(VALUE self, VALUE v_options){
+  VALUE v_policy, v_value, v_assoc_id;
   sctp_sock_t fileno;
-  sctp_assoc_t assoc_id;
-  struct sctp_rtoinfo rto;
+  struct sctp_default_prinfo prinfo;
 
-  bzero(&rto, sizeof(rto));
+  if(!RB_TYPE_P(v_options, T_HASH))
+    rb_raise(rb_eTypeError, "options must be a hash");
 
   CHECK_SOCKET_CLOSED(self);
 
   fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
 
+  v_policy = rb_hash_aref2(v_options, "policy");
+  v_value = rb_hash_aref2(v_options, "value");
   v_assoc_id = rb_hash_aref2(v_options, "association_id");
-  v_initial = rb_hash_aref2(v_options, "initial");
-  v_max = rb_hash_aref2(v_options, "max");
-  v_min = rb_hash_aref2(v_options, "min");
+
+  if(NIL_P(v_policy))
+    rb_raise(rb_eArgError, "policy parameter is required");
 
   if(NIL_P(v_assoc_id))
     v_assoc_id = rb_iv_get(self, "@association_id");
 
-  assoc_id = NUM2INT(v_assoc_id);
+  bzero(&prinfo, sizeof(prinfo));
+  prinfo.pr_assoc_id = NUM2INT(v_assoc_id);
+  prinfo.pr_policy = get_pr_policy(v_policy);
 
-  rto.srto_assoc_id = assoc_id;
+  if(!NIL_P(v_value))
+    prinfo.pr_value = NUM2UINT(v_value);
 
-  if(!NIL_P(v_initial))
-    rto.srto_initial = NUM2INT(v_initial);
+  if(sctp_sys_setsockopt(fileno, IPPROTO_SCTP, SCTP_DEFAULT_PRINFO, &prinfo, sizeof(prinfo)) < 0)
+    rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
 
-  if(!NIL_P(v_max))
-    rto.srto_max = NUM2INT(v_max);
+  return v_options;
+}
+#endif
 
-  if(!NIL_P(v_min))
-    rto.srto_min = NUM2INT(v_min);
+#ifdef SCTP_PR_ASSOC_STATUS
+/*
+ * Helper function for get_pr_assoc_status and get_pr_stream_status.
+ */
+static VALUE get_pr_status(VALUE self, int option, VALUE v_stream, VALUE v_policy, VALUE v_assoc_id){
+  sctp_sock_t fileno;
+  socklen_t size;
+  sctp_assoc_t assoc_id;
+  struct sctp_prstatus prstatus;
 
-  if(sctp_sys_setsockopt(fileno, IPPROTO_SCTP, SCTP_RTOINFO, &rto, sizeof(rto)) < 0)
-    rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
+  CHECK_SOCKET_CLOSED(self);
+
+  fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+
+  if(NIL_P(v_assoc_id))
+    v_assoc_id = rb_iv_get(self, "@association_id");
+
+  assoc_id = NUM2INT(v_assoc_id);
+  size = sizeof(struct sctp_prstatus);
+
+  bzero(&prstatus, sizeof(prstatus));
+  prstatus.sprstat_assoc_id = assoc_id;
+
+  if(!NIL_P(v_stream))
+    prstatus.sprstat_sid = NUM2USHORT(v_stream);
+
+  if(NIL_P(v_policy)){
+#ifdef HAVE_CONST_SCTP_PR_SCTP_ALL
+    prstatus.sprstat_policy = SCTP_PR_SCTP_ALL;
+#else
+    rb_raise(rb_eArgError, "policy parameter is required");
+#endif
+  }
+  else{
+    prstatus.sprstat_policy = NUM2USHORT(v_policy);
+  }
+
+  if(sctp_sys_getsockopt(fileno, IPPROTO_SCTP, option, (void*)&prstatus, &size) < 0)
+    rb_raise(rb_eSystemCallError, "getsockopt: %s", strerror(errno));
 
   return rb_struct_new(
-    v_sctp_rtoinfo_struct,
-    v_assoc_id,
-    v_initial,
-    v_max,
-    v_min
+    v_sctp_prstatus_struct,
+    INT2NUM(prstatus.sprstat_assoc_id),
+    UINT2NUM(prstatus.sprstat_sid),
+    UINT2NUM(prstatus.sprstat_policy),
+    ULL2NUM(prstatus.sprstat_abandoned_unsent),
+    ULL2NUM(prstatus.sprstat_abandoned_sent)
   );
 }
 
 /*
  * call-seq:
- *    SCTP::Socket#get_status
- *
- * Get the status of a connected socket.
+ *    SCTP::Socket#get_pr_assoc_status(policy=SCTP_PR_SCTP_ALL, association_id=nil)
  *
- * Example:
+ * Returns a struct with the number of messages that have been abandoned
+ * under the given partial reliability policy for the whole association,
+ * split into those abandoned before they were sent (abandoned_unsent) and
+ * after (abandoned_sent).
+ */
+static VALUE rsctp_get_pr_assoc_status(int argc, VALUE* argv, VALUE self){
+  VALUE v_policy, v_assoc_id;
+
+  rb_scan_args(argc, argv, "02", &v_policy, &v_assoc_id);
+
+  return get_pr_status(self, SCTP_PR_ASSOC_STATUS, Qnil, v_policy, v_assoc_id);
+}
+
+/*
+ * call-seq:
+ *    SCTP::Socket#get_pr_stream_status(stream, policy=SCTP_PR_SCTP_ALL, association_id=nil)
  *
- *   socket = SCTP::Socket.new
- *   socket.connect(...)
- *   socket.get_status
+ * Returns the same information as SCTP::Socket#get_pr_assoc_status, but for
+ * a single outgoing stream.
+ */
+static VALUE rsctp_get_pr_stream_status(int argc, VALUE* argv, VALUE self){
+  VALUE v_stream, v_policy, v_assoc_id;
+
+  rb_scan_args(argc, argv, "12", &v_stream, &v_policy, &v_assoc_id);
+
+  return get_pr_status(self, SCTP_PR_STREAM_STATUS, v_stream, v_policy, v_assoc_id);
+}
+#endif
+
+#ifdef SCTP_RESET_STREAMS
+/*
+ * call-seq:
+ *    SCTP::Socket#enable_stream_reset(flags = all, association_id=nil)
  *
- * Returns a Struct::Status object, which contains the following fields:
+ * Enables the stream reconfiguration requests (RFC 6525) that the peer may
+ * send and that this endpoint will accept. The +flags+ are a bitwise OR of
+ * SCTP_ENABLE_RESET_STREAM_REQ, SCTP_ENABLE_RESET_ASSOC_REQ and
+ * SCTP_ENABLE_CHANGE_ASSOC_REQ. By default all three are enabled.
  *
- *  * association_id
- *  * state
- *  * receive_window
- *  * unacknowledged_data
- *  * pending_data
- *  * inbound_streams
- *  * outbound_streams
- *  * fragmentation_point
- *  * primary (IP)
+ * Both endpoints must enable reconfiguration, typically before the
+ * association is established, for SCTP::Socket#reset_streams,
+ * SCTP::Socket#reset_association and SCTP::Socket#add_streams to work.
  */
-static VALUE rsctp_get_status(VALUE self){
+static VALUE rsctp_enable_stream_reset(int argc, VALUE* argv, VALUE self){
+  VALUE v_flags, v_assoc_id;
   sctp_sock_t fileno;
-  socklen_t size;
-  sctp_assoc_t assoc_id;
-  struct sctp_status status;
-  struct sctp_paddrinfo* spinfo;
-  char tmpname[INET6_ADDRSTRLEN];
+  struct sctp_assoc_value assoc_value;
 
-  bzero(&status, sizeof(status));
+  rb_scan_args(argc, argv, "02", &v_flags, &v_assoc_id);
 
   CHECK_SOCKET_CLOSED(self);
 
   fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
-  assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
-  size = sizeof(struct sctp_status);
 
-  if(sctp_sys_opt_info(fileno, assoc_id, SCTP_STATUS, (void*)&status, &size) < 0)
-    rb_raise(rb_eSystemCallError, "sctp_opt_info: %s", strerror(errno));
+  if(NIL_P(v_assoc_id))
+    v_assoc_id = rb_iv_get(self, "@association_id");
 
-  spinfo = &status.sstat_primary;
+  bzero(&assoc_value, sizeof(assoc_value));
+  assoc_value.assoc_id = NUM2INT(v_assoc_id);
 
-  if (spinfo->spinfo_address.ss_family == AF_INET6) {
-		struct sockaddr_in6 *sin6;
-		sin6 = (struct sockaddr_in6 *)&spinfo->spinfo_address;
-		inet_ntop(AF_INET6, &sin6->sin6_addr, tmpname, sizeof (tmpname));
-	}
-  else {
-		struct sockaddr_in *sin;
-		sin = (struct sockaddr_in *)&spinfo->spinfo_address;
-		inet_ntop(AF_INET, &sin->sin_addr, tmpname, sizeof (tmpname));
-  }
+  if(NIL_P(v_flags))
+    assoc_value.assoc_value = SCTP_ENABLE_RESET_STREAM_REQ | SCTP_ENABLE_RESET_ASSOC_REQ | SCTP_ENABLE_CHANGE_ASSOC_REQ;
+  else
+    assoc_value.assoc_value = NUM2UINT(v_flags);
 
-  return rb_struct_new(v_sctp_status_struct,
-    INT2NUM(status.sstat_assoc_id),
-    INT2NUM(status.sstat_state),
-    INT2NUM(status.sstat_rwnd),
-    INT2NUM(status.sstat_unackdata),
-    INT2NUM(status.sstat_penddata),
-    INT2NUM(status.sstat_instrms),
-    INT2NUM(status.sstat_outstrms),
-    INT2NUM(status.sstat_fragmentation_point),
-    rb_str_new2(tmpname)
-  );
+  if(sctp_sys_setsockopt(fileno, IPPROTO_SCTP, SCTP_ENABLE_STREAM_RESET, &assoc_value, sizeof(assoc_value)) < 0)
+    rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
+
+  return self;
 }
 
 /*
  * call-seq:
- *    SCTP::Socket#get_subscriptions
+ *    SCTP::Socket#reset_streams(options = {})
  *
- * Returns a struct of events detailing which events have been
- * subscribed to by the socket. The struct contains the following
- * members:
+ * Resets the sequence numbers of some or all streams of an association,
+ * without tearing the association down. The following options are
+ * permitted:
+ *
+ * * streams: An array of stream numbers to reset. The default is all of them.
+ * * flags: SCTP_STREAM_RESET_OUTGOING, SCTP_STREAM_RESET_INCOMING, or both.
+ *     The default is SCTP_STREAM_RESET_OUTGOING.
+ * * association_id: The association identification (ignored for one-to-one sockets)
+ *
+ * The outcome is reported asynchronously by a StreamResetEvent notification
+ * if you have subscribed to :stream_reset.
+ *
+ * Example:
  *
- *  * data_io
- *  * association
- *  * address
- *  * send_failure
- *  * peer_error
- *  * shutdown
- *  * partial_delivery
- *  * adaptation_layer
- *  * authentication
- *  * sender_dry
- *  * stream_reset
- *  * assoc_reset
- *  * stream_change
- *  * send_failure_event
+ *   socket.reset_streams(:streams => [1, 2])
  */
-static VALUE rsctp_get_subscriptions(VALUE self){
+static VALUE rsctp_reset_streams(int argc, VALUE* argv, VALUE self){
+  VALUE v_options, v_streams, v_flags, v_assoc_id, v_tmp;
   sctp_sock_t fileno;
-  sctp_assoc_t assoc_id;
-  struct sctp_event_subscribe events;
-#ifndef HAVE_USRSCTP_H
-  socklen_t size;
-#endif
+  struct sctp_reset_streams* srs;
+  size_t size;
+  long i, num_streams;
 
-  bzero(&events, sizeof(events));
+  rb_scan_args(argc, argv, "01", &v_options);
+
+  if(NIL_P(v_options))
+    v_options = rb_hash_new();
+
+  Check_Type(v_options, T_HASH);
 
   CHECK_SOCKET_CLOSED(self);
 
   fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
-  assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
 
-#ifdef HAVE_USRSCTP_H
-  /* usrsctp uses SCTP_EVENT + struct sctp_event for per-event query */
-  {
-    struct sctp_event se;
-    socklen_t se_size;
+  v_streams = rb_hash_aref2(v_options, "streams");
+  v_flags = rb_hash_aref2(v_options, "flags");
+  v_assoc_id = rb_hash_aref2(v_options, "association_id");
 
-    memset(&events, 0, sizeof(events));
+  if(NIL_P(v_streams)){
+    num_streams = 0;
+  }
+  else{
+    Check_Type(v_streams, T_ARRAY);
+    num_streams = RARRAY_LEN(v_streams);
 
-    /* data_io: check SCTP_RECVRCVINFO sockopt */
-    {
-      int on = 0;
-      socklen_t on_size = sizeof(on);
-      if(sctp_sys_getsockopt(fileno, IPPROTO_SCTP, SCTP_RECVRCVINFO, &on, &on_size) == 0 && on)
-        events.sctp_data_io_event = 1;
-    }
+    if(num_streams > UINT16_MAX)
+      rb_raise(rb_eArgError, "too many streams");
+  }
 
-#define QUERY_EVENT(field, type) \
-    memset(&se, 0, sizeof(se)); \
-    se.se_assoc_id = assoc_id; \
-    se.se_type = (type); \
-    se_size = sizeof(se); \
-    if(sctp_sys_getsockopt(fileno, IPPROTO_SCTP, SCTP_EVENT, &se, &se_size) == 0 && se.se_on) \
-      events.field = 1;
+  if(NIL_P(v_assoc_id))
+    v_assoc_id = rb_iv_get(self, "@association_id");
 
-    QUERY_EVENT(sctp_association_event,       SCTP_ASSOC_CHANGE)
-    QUERY_EVENT(sctp_address_event,           SCTP_PEER_ADDR_CHANGE)
-    QUERY_EVENT(sctp_send_failure_event,      SCTP_SEND_FAILED)
-    QUERY_EVENT(sctp_peer_error_event,        SCTP_REMOTE_ERROR)
-    QUERY_EVENT(sctp_shutdown_event,          SCTP_SHUTDOWN_EVENT)
-    QUERY_EVENT(sctp_partial_delivery_event,  SCTP_PARTIAL_DELIVERY_EVENT)
-    QUERY_EVENT(sctp_adaptation_layer_event,  SCTP_ADAPTATION_INDICATION)
-    QUERY_EVENT(sctp_authentication_event,    SCTP_AUTHENTICATION_EVENT)
-    QUERY_EVENT(sctp_sender_dry_event,        SCTP_SENDER_DRY_EVENT)
-#ifdef HAVE_STRUCT_SCTP_EVENT_SUBSCRIBE_SCTP_STREAM_RESET_EVENT
-    QUERY_EVENT(sctp_stream_reset_event,      SCTP_STREAM_RESET_EVENT)
-#endif
+  size = sizeof(struct sctp_reset_streams) + num_streams * sizeof(uint16_t);
+  srs = (struct sctp_reset_streams*)ALLOCV(v_tmp, size);
+  bzero(srs, size);
 
-#undef QUERY_EVENT
+  srs->srs_assoc_id = NUM2INT(v_assoc_id);
+  srs->srs_number_streams = (uint16_t)num_streams;
+
+  if(NIL_P(v_flags))
+    srs->srs_flags = SCTP_STREAM_RESET_OUTGOING;
+  else
+    srs->srs_flags = NUM2USHORT(v_flags);
+
+  for(i = 0; i < num_streams; i++)
+    srs->srs_stream_list[i] = NUM2USHORT(RARRAY_AREF(v_streams, i));
+
+  if(sctp_sys_setsockopt(fileno, IPPROTO_SCTP, SCTP_RESET_STREAMS, srs, (socklen_t)size) < 0){
+    ALLOCV_END(v_tmp);
+    rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
   }
-#else
-  size = sizeof(struct sctp_event_subscribe);
-  if(sctp_sys_opt_info(fileno, assoc_id, SCTP_EVENTS, (void*)&events, &size) < 0)
-    rb_raise(rb_eSystemCallError, "sctp_opt_info: %s", strerror(errno));
-#endif
 
-  return rb_struct_new(
-    v_sctp_event_subscribe_struct,
-    (events.sctp_data_io_event ? Qtrue : Qfalse),
-    (events.sctp_association_event ? Qtrue : Qfalse),
-    (events.sctp_address_event ? Qtrue : Qfalse),
-    (events.sctp_send_failure_event ? Qtrue : Qfalse),
-    (events.sctp_peer_error_event ? Qtrue : Qfalse),
-    (events.sctp_shutdown_event ? Qtrue : Qfalse),
-    (events.sctp_partial_delivery_event ? Qtrue : Qfalse),
-    (events.sctp_adaptation_layer_event ? Qtrue : Qfalse),
-    (events.sctp_authentication_event ? Qtrue : Qfalse),
-    (events.sctp_sender_dry_event ? Qtrue : Qfalse)
-#ifdef HAVE_STRUCT_SCTP_EVENT_SUBSCRIBE_SCTP_STREAM_RESET_EVENT
-    ,(events.sctp_stream_reset_event ? Qtrue : Qfalse)
-#endif
-#ifdef HAVE_STRUCT_SCTP_EVENT_SUBSCRIBE_SCTP_ASSOC_RESET_EVENT
-    ,(events.sctp_assoc_reset_event ? Qtrue : Qfalse)
-#endif
-#ifdef HAVE_STRUCT_SCTP_EVENT_SUBSCRIBE_SCTP_STREAM_CHANGE_EVENT
-    ,(events.sctp_stream_change_event ? Qtrue : Qfalse)
-#endif
-#ifdef HAVE_STRUCT_SCTP_EVENT_SUBSCRIBE_SCTP_SEND_FAILURE_EVENT_EVENT
-    ,(events.sctp_send_failure_event_event ? Qtrue : Qfalse)
-#endif
-  );
+  ALLOCV_END(v_tmp);
+
+  return self;
 }
 
 /*
  * call-seq:
- *    SCTP::Socket#get_peer_address_params
- *
- * Applications can enable or disable heartbeats for any peer address of
- * an association, modify an address's heartbeat interval, force a
- * heartbeat to be sent immediately, and adjust the address's maximum
- * number of retransmissions sent before an address is considered
- * unreachable.
+ *    SCTP::Socket#reset_association(association_id=nil)
  *
- * This method returns a struct that contains this information. It contains
- * the following struct members.
+ * Resets the TSNs of the association, and the sequence numbers of all of
+ * its streams, without tearing the association down.
  *
- * * association_id
- * * address
- * * heartbeat_interval
- * * max_retransmission_count
- * * path_mtu
- * * flags
- * * ipv6_flowlabel
+ * The outcome is reported asynchronously by an AssocResetEvent notification
+ * if you have subscribed to :assoc_reset.
  */
-static VALUE rsctp_get_peer_address_params(VALUE self){
+static VALUE rsctp_reset_association(int argc, VALUE* argv, VALUE self){
+  VALUE v_assoc_id;
   sctp_sock_t fileno;
-  char str[IP_BUFFER_SIZE];
-  socklen_t size;
   sctp_assoc_t assoc_id;
-  struct sctp_paddrparams paddr;
 
-  bzero(&paddr, sizeof(paddr));
-  bzero(&str, sizeof(str));
+  rb_scan_args(argc, argv, "01", &v_assoc_id);
 
   CHECK_SOCKET_CLOSED(self);
 
   fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
-  assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
-  size = sizeof(struct sctp_paddrparams);
 
-  if(sctp_sys_opt_info(fileno, assoc_id, SCTP_PEER_ADDR_PARAMS, (void*)&paddr, &size) < 0)
-    rb_raise(rb_eSystemCallError, "sctp_opt_info: %s", strerror(errno));
+  if(NIL_P(v_assoc_id))
+    v_assoc_id = rb_iv_get(self, "@association_id");
 
-  {
-    struct sockaddr* sa = (struct sockaddr*)&paddr.spp_address;
+  assoc_id = NUM2INT(v_assoc_id);
 
-    if(sa->sa_family == AF_INET6){
-      struct sockaddr_in6* sin6 = (struct sockaddr_in6*)sa;
-      inet_ntop(AF_INET6, &sin6->sin6_addr, str, sizeof(str));
-    }
-    else{
-      struct sockaddr_in* sin = (struct sockaddr_in*)sa;
-      inet_ntop(AF_INET, &sin->sin_addr, str, sizeof(str));
-    }
-  }
+  if(sctp_sys_setsockopt(fileno, IPPROTO_SCTP, SCTP_RESET_ASSOC, &assoc_id, sizeof(assoc_id)) < 0)
+    rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
 
-  return rb_struct_new(
-    v_sctp_peer_addr_params_struct,
-    INT2NUM(paddr.spp_assoc_id),
-    rb_str_new2(str),
-    INT2NUM(paddr.spp_hbinterval),
-    INT2NUM(paddr.spp_pathmaxrxt),
-    INT2NUM(paddr.spp_pathmtu),
-    INT2NUM(paddr.spp_flags),
-    INT2NUM(paddr.spp_ipv6_flowlabel)
-  );
+  return self;
 }
 
 /*
  * call-seq:
- *    SCTP::Socket#get_init_msg
+ *    SCTP::Socket#add_streams(options)
  *
- * Returns a structure that contains various initialization parameters.
+ * Adds streams to an existing association, without tearing it down. The
+ * following options are permitted:
  *
- * * num_ostreams: A number representing the number of streams that the
- *     application wishes to be able to send to.
+ * * output_streams: The number of outgoing streams to add.
+ * * input_streams: The number of incoming streams to add.
+ * * association_id: The association identification (ignored for one-to-one sockets)
  *
- * * max_instreams: The maximum number of inbound streams the application
- *     is prepared to support.
+ * The outcome is reported asynchronously by a StreamChangeEvent notification
+ * if you have subscribed to :stream_change.
  *
- * * max_attempts: The number of attempts the SCTP endpoint should make at
- *     resending the INIT.
+ * Example:
  *
- * * max_init_timeout: This value represents the largest Timeout or RTO value
- *     (in milliseconds) to use in attempting an INIT.
+ *   socket.add_streams(:output_streams => 10)
  */
-static VALUE rsctp_get_init_msg(VALUE self){
+static VALUE rsctp_add_streams(VALUE self, VALUE v_options){
+  VALUE v_output, v_input, v_assoc_id;
   sctp_sock_t fileno;
-  socklen_t size;
-  sctp_assoc_t assoc_id;
-  struct sctp_initmsg initmsg;
+  struct sctp_add_streams sas;
 
-  bzero(&initmsg, sizeof(initmsg));
+  Check_Type(v_options, T_HASH);
 
   CHECK_SOCKET_CLOSED(self);
 
   fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
-  assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
-  size = sizeof(struct sctp_initmsg);
 
-  if(sctp_sys_opt_info(fileno, assoc_id, SCTP_INITMSG, (void*)&initmsg, &size) < 0)
-    rb_raise(rb_eSystemCallError, "sctp_opt_info: %s", strerror(errno));
+  v_output = rb_hash_aref2(v_options, "output_streams");
+  v_input = rb_hash_aref2(v_options, "input_streams");
+  v_assoc_id = rb_hash_aref2(v_options, "association_id");
 
-  return rb_struct_new(
-    v_sctp_initmsg_struct,
-    INT2NUM(initmsg.sinit_num_ostreams),
-    INT2NUM(initmsg.sinit_max_instreams),
-    INT2NUM(initmsg.sinit_max_attempts),
-    INT2NUM(initmsg.sinit_max_init_timeo)
-  );
+  if(NIL_P(v_output) && NIL_P(v_input))
+    rb_raise(rb_eArgError, "output_streams or input_streams parameter is required");
+
+  if(NIL_P(v_assoc_id))
+    v_assoc_id = rb_iv_get(self, "@association_id");
+
+  bzero(&sas, sizeof(sas));
+  sas.sas_assoc_id = NUM2INT(v_assoc_id);
+
+  if(!NIL_P(v_output))
+    sas.sas_outstrms = NUM2USHORT(v_output);
+
+  if(!NIL_P(v_input))
+    sas.sas_instrms = NUM2USHORT(v_input);
+
+  if(sctp_sys_setsockopt(fileno, IPPROTO_SCTP, SCTP_ADD_STREAMS, &sas, sizeof(sas)) < 0)
+    rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
+
+  return self;
+}
+#endif
+
+/*
+ * Helper function to get an integer SOL_SOCKET option.
+ */
+static int get_socket_int_option(sctp_sock_t fileno, int option){
+  int value = 0;
+  socklen_t size = sizeof(value);
+
+  if(sctp_sys_getsockopt(fileno, SOL_SOCKET, option, &value, &size) < 0)
+    rb_raise(rb_eSystemCallError, "getsockopt: %s", strerror(errno));
+
+  return value;
 }
 
 /*
  * call-seq:
- *    SCTP::Socket#nodelay?
+ *    SCTP::Socket#get_send_buffer_size
  *
- * Returns whether or not the nodelay option has been set.
+ * Returns the size of the socket send buffer (SO_SNDBUF) in bytes. Note that
+ * on Linux this is double the value that was set, since the kernel reserves
+ * room for its own bookkeeping.
  */
-static VALUE rsctp_get_nodelay(VALUE self){
+static VALUE rsctp_get_send_buffer_size(VALUE self){
+  CHECK_SOCKET_CLOSED(self);
+  return INT2NUM(get_socket_int_option(NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno")), SO_SNDBUF));
+}
+
+/*
+ * call-seq:
+ *    SCTP::Socket#send_buffer_size=(bytes)
+ *
+ * Sets the size of the socket send buffer (SO_SNDBUF) in bytes. The kernel
+ * caps this at net.core.wmem_max unless the process has CAP_NET_ADMIN.
+ */
+static VALUE rsctp_set_send_buffer_size(VALUE self, VALUE v_bytes){
   sctp_sock_t fileno;
-  socklen_t size;
-  sctp_assoc_t assoc_id;
   int value;
 
   CHECK_SOCKET_CLOSED(self);
 
+  value = NUM2INT(v_bytes);
   fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
-  assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
-  size = sizeof(int);
 
-  if(sctp_sys_opt_info(fileno, assoc_id, SCTP_NODELAY, (void*)&value, &size) < 0)
-    rb_raise(rb_eSystemCallError, "sctp_opt_info: %s", strerror(errno));
+  if(sctp_sys_setsockopt(fileno, SOL_SOCKET, SO_SNDBUF, &value, sizeof(value)) < 0)
+    rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
 
-  if(value)
-    return Qtrue;
-  else
-    return Qfalse;
+  return v_bytes;
 }
 
 /*
  * call-seq:
- *    SCTP::Socket#nodelay=(bool)
+ *    SCTP::Socket#get_receive_buffer_size
  *
- * Turn on/off any Nagle-like algorithm. This means that packets are generally
- * sent as soon as possible and no unnecessary delays are introduced, at the
- * cost of more packets in the network.
+ * Returns the size of the socket receive buffer (SO_RCVBUF) in bytes. The
+ * receive window advertised to the peer is derived from this value.
  */
-static VALUE rsctp_set_nodelay(VALUE self, VALUE v_bool){
+static VALUE rsctp_get_receive_buffer_size(VALUE self){
+  CHECK_SOCKET_CLOSED(self);
+  return INT2NUM(get_socket_int_option(NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno")), SO_RCVBUF));
+}
+
+/*
+ * call-seq:
+ *    SCTP::Socket#receive_buffer_size=(bytes)
+ *
+ * Sets the size of the socket receive buffer (SO_RCVBUF) in bytes. The
+ * kernel caps this at net.core.rmem_max unless the process has
+ * CAP_NET_ADMIN.
+ *
+ * The initial receive window is fixed when an association is set up, so
+ * set this before calling connectx or listen for it to take full effect.
+ */
+static VALUE rsctp_set_receive_buffer_size(VALUE self, VALUE v_bytes){
   sctp_sock_t fileno;
-  socklen_t size;
   int value;
 
   CHECK_SOCKET_CLOSED(self);
 
+  value = NUM2INT(v_bytes);
   fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
-  size = sizeof(int);
-
-  if(NIL_P(v_bool) || v_bool == Qfalse)
-    value = 0;
-  else
-    value = 1;
 
-  if(sctp_sys_setsockopt(fileno, IPPROTO_SCTP, SCTP_NODELAY, &value, size) < 0)
+  if(sctp_sys_setsockopt(fileno, SOL_SOCKET, SO_RCVBUF, &value, sizeof(value)) < 0)
     rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
 
-  if(value)
-    return Qtrue;
-  else
-    return Qfalse;
+  return v_bytes;
 }
 
 /*
  * call-seq:
- *    SCTP::Socket#disable_fragments=(bool)
+ *    SCTP::Socket#tune_buffers(options)
  *
- * This option is a on/off flag and is passed an integer where a non-
- * zero is on and a zero is off.  If enabled no SCTP message
- * fragmentation will be performed.  Instead if a message being sent
- * exceeds the current PMTU size, the message will NOT be sent and
- * instead a error will be indicated to the user.
+ * Sizes the send and receive buffers to the bandwidth-delay product of the
+ * path, so that a bulk transfer is not limited by the window. The following
+ * options are permitted:
+ *
+ * * bandwidth: The target bandwidth in bits per second (required).
+ * * rtt: The round trip time in milliseconds. By default the smoothed round
+ *     trip time of the primary path is used, as reported by SCTP_STATUS, which
+ *     requires an established association. If there is no RTT sample yet the
+ *     retransmission timeout is used instead, and at least 1ms.
+ * * factor: A multiplier for the bandwidth-delay product, to leave headroom
+ *     for RTT variance and retransmissions. The default is 2.
+ *
+ * The sizes are never reduced below their current values. Returns a
+ * Struct::BufferSizes whose send_buffer and receive_buffer members hold the
+ * sizes in effect afterwards, which may be lower than requested if the
+ * kernel limits (net.core.wmem_max and net.core.rmem_max) are too small.
+ *
+ * Example:
+ *
+ *   # Aim for 1Gbit/s using the measured RTT
+ *   socket.connectx(:addresses => addresses, :port => port)
+ *   socket.tune_buffers(:bandwidth => 1_000_000_000)
  */
-static VALUE rsctp_disable_fragments(VALUE self, VALUE v_bool){
+static VALUE rsctp_tune_buffers(VALUE self, VALUE v_options){
+  VALUE v_bandwidth, v_rtt, v_factor;
   sctp_sock_t fileno;
-  socklen_t size;
-  sctp_assoc_t assoc_id;
+  double bandwidth, rtt, factor, bdp;
   int value;
 
+  Check_Type(v_options, T_HASH);
+
   CHECK_SOCKET_CLOSED(self);
 
   fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
-  assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
-  size = sizeof(int);
 
-  if(NIL_P(v_bool) || v_bool == Qfalse)
-    value = 0;
+  v_bandwidth = rb_hash_aref2(v_options, "bandwidth");
+  v_rtt = rb_hash_aref2(v_options, "rtt");
+  v_factor = rb_hash_aref2(v_options, "factor");
+
+  if(NIL_P(v_bandwidth))
+    rb_raise(rb_eArgError, "bandwidth parameter is required");
+
+  bandwidth = NUM2DBL(v_bandwidth);
+
+  if(bandwidth <= 0)
+    rb_raise(rb_eArgError, "bandwidth must be positive");
+
+  if(NIL_P(v_factor))
+    factor = 2;
   else
-    value = 1;
+    factor = NUM2DBL(v_factor);
 
-  if(sctp_sys_opt_info(fileno, assoc_id, SCTP_DISABLE_FRAGMENTS, (void*)&value, &size) < 0)
-    rb_raise(rb_eSystemCallError, "sctp_opt_info: %s", strerror(errno));
+  if(NIL_P(v_rtt)){
+    struct sctp_status status;
+    socklen_t size = sizeof(struct sctp_status);
+    sctp_assoc_t assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
 
-  if(value)
-    return Qtrue;
+    bzero(&status, sizeof(status));
+
+    if(sctp_sys_opt_info(fileno, assoc_id, SCTP_STATUS, (void*)&status, &size) < 0)
+      rb_raise(rb_eSystemCallError, "sctp_opt_info: %s", strerror(errno));
+
+    rtt = status.sstat_primary.spinfo_srtt;
+
+    // There is no RTT sample yet, or it rounds to zero, e.g. on loopback
+    if(rtt <= 0)
+      rtt = status.sstat_primary.spinfo_rto;
+
+    if(rtt < 1)
+      rtt = 1;
+  }
+  else{
+    rtt = NUM2DBL(v_rtt);
+
+    if(rtt <= 0)
+      rb_raise(rb_eArgError, "rtt must be positive");
+  }
+
+  bdp = (bandwidth / 8) * (rtt / 1000) * factor;
+
+  if(bdp > INT_MAX)
+    value = INT_MAX;
   else
-    return Qfalse;
+    value = (int)bdp;
+
+  if(value > get_socket_int_option(fileno, SO_SNDBUF)){
+    if(sctp_sys_setsockopt(fileno, SOL_SOCKET, SO_SNDBUF, &value, sizeof(value)) < 0)
+      rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
+  }
+
+  if(value > get_socket_int_option(fileno, SO_RCVBUF)){
+    if(sctp_sys_setsockopt(fileno, SOL_SOCKET, SO_RCVBUF, &value, sizeof(value)) < 0)
+      rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
+  }
+
+  return rb_struct_new(
+    v_buffer_sizes_struct,
+    INT2NUM(get_socket_int_option(fileno, SO_SNDBUF)),
+    INT2NUM(get_socket_int_option(fileno, SO_RCVBUF))
+  );
 }
 
 /*
  * call-seq:
- *    SCTP::Socket#autoclose
+ *    SCTP::Socket#next_info?
  *
- * Returns the number of seconds before socket associations automatically
- * shut down.
+ * Returns whether or not information about the next message is returned by
+ * SCTP::Socket#recvv.
  */
-static VALUE rsctp_get_autoclose(VALUE self){
+static VALUE rsctp_get_next_info(VALUE self){
   sctp_sock_t fileno;
   socklen_t size;
-  sctp_assoc_t assoc_id;
-  int value;
+  int value = 0;
 
   CHECK_SOCKET_CLOSED(self);
 
   fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
-  assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
   size = sizeof(int);
 
-  if(sctp_sys_opt_info(fileno, assoc_id, SCTP_AUTOCLOSE, (void*)&value, &size) < 0)
-    rb_raise(rb_eSystemCallError, "sctp_opt_info: %s", strerror(errno));
+  if(sctp_sys_getsockopt(fileno, IPPROTO_SCTP, SCTP_RECVNXTINFO, &value, &size) < 0)
+    rb_raise(rb_eSystemCallError, "getsockopt: %s", strerror(errno));
 
-  return INT2NUM(value);
+  if(value)
+    return Qtrue;
+  else
+    return Qfalse;
 }
 
 /*
  * call-seq:
- *    SCTP::Socket#autoclose=(seconds=0)
+ *    SCTP::Socket#next_info=(bool)
  *
- * When set it will cause associations that are idle for more than the specified
- * number of seconds to automatically close using the graceful shutdown
- * procedure. An association being idle is defined as an association that has
- * NOT sent or received user data.
+ * When enabled, SCTP::Socket#recvv also returns the stream, flags, ppid and
+ * length of the next message waiting to be received, if any, in the +next+
+ * member of the struct it returns. This lets a dispatcher pick the right
+ * buffer size and handler before the next receive.
  *
- * The special value of 0 indicates that no automatic close of any associations
- * should be performed, this is the default value. The option expects an integer
- * defining the number of seconds of idle time before an association is closed.
+ * Example:
  *
- * An application using this option should enable receiving the association
- * change notification. This is the only mechanism an application is informed
- * about the closing of an association. After an association is closed, the
- * association ID assigned to it can be reused. An application should be aware
- * of this to avoid the possible problem of sending data to an incorrect peer
- * end point.
+ *   socket.next_info = true
+ *   info = socket.recvv
  *
- * This socket option is applicable to the one-to-many style socket only.
+ *   if info.next
+ *     info = socket.recvv(0, info.next.length)
+ *   end
  */
-static VALUE rsctp_set_autoclose(VALUE self, VALUE v_seconds){
+static VALUE rsctp_set_next_info(VALUE self, VALUE v_bool){
   sctp_sock_t fileno;
   int value;
 
   CHECK_SOCKET_CLOSED(self);
 
-  value = NUM2INT(v_seconds);
   fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
 
-  if(sctp_sys_setsockopt(fileno, IPPROTO_SCTP, SCTP_AUTOCLOSE, &value, sizeof(value)) < 0)
+  if(NIL_P(v_bool) || v_bool == Qfalse)
+    value = 0;
+  else
+    value = 1;
+
+  if(sctp_sys_setsockopt(fileno, IPPROTO_SCTP, SCTP_RECVNXTINFO, &value, sizeof(value)) < 0)
     rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
 
-  return INT2NUM(value);
+  if(value)
+    return Qtrue;
+  else
+    return Qfalse;
 }
 
 /*
@@ -3264,118 +7259,482 @@ static VALUE rsctp_set_default_send_params(VALUE self, VALUE v_options){
 
 /*
  * call-seq:
- *    SCTP::Socket#set_peer_address_params(options)
+ *    SCTP::Socket#set_peer_address_params(options)
+ *
+ * Sets the peer address parameters. This allows applications to enable or
+ * disable heartbeats for any peer address of an association, set the maximum
+ * number of retransmissions to a destination address, and set the path MTU.
+ *
+ * The +options+ hash may contain the following keys:
+ *
+ * * association_id: The association identification
+ * * address: The address of the remote peer
+ * * hbinterval: The heartbeat interval (in milliseconds)
+ * * pathmaxrxt: The maximum number of retransmissions
+ * * pathmtu: The path MTU
+ * * flags: Flags to control heartbeats, etc.
+ * * ipv6_flowlabel: IPv6 flow label (only for IPv6 addresses)
+ *
+ * Example:
+ *
+ *   socket.set_peer_address_params(:hbinterval => 5000, :pathmaxrxt => 5)
+ */
+static VALUE rsctp_set_peer_address_params(VALUE self, VALUE v_options){
+  VALUE v_assoc_id, v_address, v_hbinterval, v_pathmaxrxt, v_pathmtu, v_flags, v_ipv6_flowlabel;
+  sctp_sock_t fileno;
+  int domain;
+  sctp_assoc_t assoc_id;
+  struct sctp_paddrparams paddr;
+
+  if(!RB_TYPE_P(v_options, T_HASH))
+    rb_raise(rb_eTypeError, "options must be a hash");
+
+  bzero(&paddr, sizeof(paddr));
+
+  CHECK_SOCKET_CLOSED(self);
+
+  fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+  domain = NUM2INT(rb_iv_get(self, "@domain"));
+
+  v_assoc_id = rb_hash_aref2(v_options, "association_id");
+  v_address = rb_hash_aref2(v_options, "address");
+  v_hbinterval = rb_hash_aref2(v_options, "hbinterval");
+  v_pathmaxrxt = rb_hash_aref2(v_options, "pathmaxrxt");
+  v_pathmtu = rb_hash_aref2(v_options, "pathmtu");
+  v_flags = rb_hash_aref2(v_options, "flags");
+  v_ipv6_flowlabel = rb_hash_aref2(v_options, "ipv6_flowlabel");
+
+  if(NIL_P(v_assoc_id))
+    v_assoc_id = rb_iv_get(self, "@association_id");
+
+  assoc_id = NUM2INT(v_assoc_id);
+  paddr.spp_assoc_id = assoc_id;
+
+  // If address is provided, set up the sockaddr structure based on domain
+  if(!NIL_P(v_address)){
+    const char* addr_str = StringValueCStr(v_address);
+
+    if(domain == AF_INET6){
+      struct sockaddr_in6* sin6 = (struct sockaddr_in6*)&paddr.spp_address;
+      sin6->sin6_family = AF_INET6;
+      if(inet_pton(AF_INET6, addr_str, &sin6->sin6_addr) <= 0)
+        rb_raise(rb_eArgError, "invalid IPv6 address: %s", addr_str);
+#ifdef BSD
+      sin6->sin6_len = sizeof(struct sockaddr_in6);
+#endif
+    }
+    else{
+      struct sockaddr_in* sin = (struct sockaddr_in*)&paddr.spp_address;
+      sin->sin_family = AF_INET;
+      if(inet_pton(AF_INET, addr_str, &sin->sin_addr) <= 0)
+        rb_raise(rb_eArgError, "invalid IPv4 address: %s", addr_str);
+#ifdef BSD
+      sin->sin_len = sizeof(struct sockaddr_in);
+#endif
+    }
+  }
+
+  if(!NIL_P(v_hbinterval))
+    paddr.spp_hbinterval = NUM2INT(v_hbinterval);
+
+  if(!NIL_P(v_pathmaxrxt))
+    paddr.spp_pathmaxrxt = NUM2INT(v_pathmaxrxt);
+
+  if(!NIL_P(v_pathmtu))
+    paddr.spp_pathmtu = NUM2INT(v_pathmtu);
+
+  if(!NIL_P(v_flags))
+    paddr.spp_flags = NUM2INT(v_flags);
+
+  if(!NIL_P(v_ipv6_flowlabel))
+    paddr.spp_ipv6_flowlabel = NUM2INT(v_ipv6_flowlabel);
+
+  if(sctp_sys_setsockopt(fileno, IPPROTO_SCTP, SCTP_PEER_ADDR_PARAMS, &paddr, sizeof(paddr)) < 0)
+    rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
+
+  return rb_struct_new(
+    v_sctp_peer_addr_params_struct,
+    v_assoc_id,
+    v_address,
+    v_hbinterval,
+    v_pathmaxrxt,
+    v_pathmtu,
+    v_flags,
+    v_ipv6_flowlabel
+  );
+}
+
+/*
+ * Helper function that returns the port to use with an address passed to
+ * an option. The stack matches addresses by address and port, so unless
+ * one is given this is the port of the association's peer addresses, or
+ * of its local addresses if local is true. If the association has none,
+ * e.g. on a one-to-many socket without an association id, the socket's
+ * port is used.
+ */
+static int get_option_port(VALUE self, VALUE v_port, sctp_assoc_t assoc_id, int local){
+  sctp_sock_t fileno;
+  struct sockaddr* addrs = NULL;
+  int num_addrs, port = -1;
+
+  if(!NIL_P(v_port))
+    return NUM2INT(v_port);
+
+  fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+
+  if(local)
+    num_addrs = sctp_sys_getladdrs(fileno, assoc_id, &addrs);
+  else
+    num_addrs = sctp_sys_getpaddrs(fileno, assoc_id, &addrs);
+
+  if(num_addrs > 0){
+    if(addrs->sa_family == AF_INET6)
+      port = ntohs(((struct sockaddr_in6*)addrs)->sin6_port);
+    else
+      port = ntohs(((struct sockaddr_in*)addrs)->sin_port);
+  }
+
+  if(addrs != NULL){
+    if(local)
+      sctp_sys_freeladdrs(addrs);
+    else
+      sctp_sys_freepaddrs(addrs);
+  }
+
+  if(port < 0){
+    v_port = rb_iv_get(self, "@port");
+    port = NIL_P(v_port) ? 0 : NUM2INT(v_port);
+  }
+
+  return port;
+}
+
+/*
+ * Helper function that fills in a sockaddr_storage for the given address
+ * string and port, based on the socket's domain, for the options that take
+ * a single peer or local address.
+ */
+static void parse_option_address(VALUE self, VALUE v_address, int port, struct sockaddr_storage* addr){
+  bzero(addr, sizeof(*addr));
+
+  if(NIL_P(v_address))
+    return;
+
+  if(NUM2INT(rb_iv_get(self, "@domain")) == AF_INET6)
+    parse_ip_address_v6(StringValueCStr(v_address), port, (struct sockaddr_in6*)addr);
+  else
+    parse_ip_address_v4(StringValueCStr(v_address), port, (struct sockaddr_in*)addr);
+}
+
+#ifdef SCTP_PEER_ADDR_THLDS
+/*
+ * Helper function that reads the current thresholds for an address, or
+ * for the whole association if no address is given.
+ */
+static void get_paddr_thresholds(VALUE self, VALUE v_address, VALUE v_port, sctp_assoc_t assoc_id, struct sctp_paddrthlds* thlds){
+  sctp_sock_t fileno;
+  socklen_t size;
+  struct sockaddr_storage addr;
+
+  fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+  size = sizeof(struct sctp_paddrthlds);
+
+  if(NIL_P(v_address))
+    parse_option_address(self, v_address, 0, &addr);
+  else
+    parse_option_address(self, v_address, get_option_port(self, v_port, assoc_id, 0), &addr);
+
+  bzero(thlds, sizeof(*thlds));
+  thlds->spt_assoc_id = assoc_id;
+  memcpy(&thlds->spt_address, &addr, sizeof(addr));
+
+  if(sctp_sys_opt_info(fileno, assoc_id, SCTP_PEER_ADDR_THLDS, (void*)thlds, &size) < 0)
+    rb_raise(rb_eSystemCallError, "sctp_opt_info: %s", strerror(errno));
+}
+
+/*
+ * call-seq:
+ *    SCTP::Socket#get_peer_address_thresholds(address=nil, association_id=nil, port=nil)
+ *
+ * Returns a struct with the failover thresholds of a peer address, or of
+ * the association as a whole if no address is given. The port defaults to
+ * the port of the association's peer addresses. The struct contains the
+ * following members:
+ *
+ * * association_id
+ * * address
+ * * max_retransmission_count: The number of retransmissions after which
+ *     the address is considered unreachable.
+ * * pf_threshold: The number of retransmissions after which the address
+ *     is considered potentially failed, so that traffic moves to another
+ *     path without waiting for it to become unreachable.
+ */
+static VALUE rsctp_get_peer_address_thresholds(int argc, VALUE* argv, VALUE self){
+  VALUE v_address, v_assoc_id, v_port;
+  struct sctp_paddrthlds thlds;
+
+  rb_scan_args(argc, argv, "03", &v_address, &v_assoc_id, &v_port);
+
+  CHECK_SOCKET_CLOSED(self);
+
+  if(NIL_P(v_assoc_id))
+    v_assoc_id = rb_iv_get(self, "@association_id");
+
+  get_paddr_thresholds(self, v_address, v_port, NUM2INT(v_assoc_id), &thlds);
+
+  return rb_struct_new(
+    v_sctp_peer_addr_thresholds_struct,
+    v_assoc_id,
+    v_address,
+    UINT2NUM(thlds.spt_pathmaxrxt),
+    UINT2NUM(thlds.spt_pathpfthld)
+  );
+}
+
+/*
+ * call-seq:
+ *    SCTP::Socket#set_peer_address_thresholds(options)
  *
- * Sets the peer address parameters. This allows applications to enable or
- * disable heartbeats for any peer address of an association, set the maximum
- * number of retransmissions to a destination address, and set the path MTU.
+ * Sets the failover thresholds of a peer address, or of every address of
+ * the association if no address is given. Thresholds that are not passed
+ * keep their current value.
  *
  * The +options+ hash may contain the following keys:
  *
  * * association_id: The association identification
  * * address: The address of the remote peer
- * * hbinterval: The heartbeat interval (in milliseconds)
- * * pathmaxrxt: The maximum number of retransmissions
- * * pathmtu: The path MTU
- * * flags: Flags to control heartbeats, etc.
- * * ipv6_flowlabel: IPv6 flow label (only for IPv6 addresses)
+ * * port: The port of the remote peer. The default is the port of the
+ *     association's peer addresses.
+ * * pathmaxrxt: The number of retransmissions before the address is
+ *     considered unreachable
+ * * pathpfthld: The number of retransmissions before the address is
+ *     considered potentially failed. Zero moves traffic to another path
+ *     on the first retransmission timeout.
+ *
+ * With the default thresholds a failed path is only abandoned after
+ * several exponentially backed off retransmissions, which can take tens
+ * of seconds. A low pathpfthld, together with a low RTO minimum and
+ * maximum (see SCTP::Socket#set_retransmission_info), brings that down
+ * to well under a second.
  *
  * Example:
  *
- *   socket.set_peer_address_params(:hbinterval => 5000, :pathmaxrxt => 5)
+ *   socket.set_peer_address_thresholds(:pathmaxrxt => 5, :pathpfthld => 0)
  */
-static VALUE rsctp_set_peer_address_params(VALUE self, VALUE v_options){
-  VALUE v_assoc_id, v_address, v_hbinterval, v_pathmaxrxt, v_pathmtu, v_flags, v_ipv6_flowlabel;
+static VALUE rsctp_set_peer_address_thresholds(VALUE self, VALUE v_options){
+  VALUE v_assoc_id, v_address, v_port, v_pathmaxrxt, v_pathpfthld;
   sctp_sock_t fileno;
-  int domain;
-  sctp_assoc_t assoc_id;
-  struct sctp_paddrparams paddr;
+  struct sctp_paddrthlds thlds;
 
   if(!RB_TYPE_P(v_options, T_HASH))
     rb_raise(rb_eTypeError, "options must be a hash");
 
-  bzero(&paddr, sizeof(paddr));
-
   CHECK_SOCKET_CLOSED(self);
 
   fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
-  domain = NUM2INT(rb_iv_get(self, "@domain"));
 
   v_assoc_id = rb_hash_aref2(v_options, "association_id");
   v_address = rb_hash_aref2(v_options, "address");
-  v_hbinterval = rb_hash_aref2(v_options, "hbinterval");
+  v_port = rb_hash_aref2(v_options, "port");
   v_pathmaxrxt = rb_hash_aref2(v_options, "pathmaxrxt");
-  v_pathmtu = rb_hash_aref2(v_options, "pathmtu");
-  v_flags = rb_hash_aref2(v_options, "flags");
-  v_ipv6_flowlabel = rb_hash_aref2(v_options, "ipv6_flowlabel");
+  v_pathpfthld = rb_hash_aref2(v_options, "pathpfthld");
 
   if(NIL_P(v_assoc_id))
     v_assoc_id = rb_iv_get(self, "@association_id");
 
-  assoc_id = NUM2INT(v_assoc_id);
-  paddr.spp_assoc_id = assoc_id;
+  // The stack resets the pf threshold to whatever is passed, so start
+  // from the current values
+  get_paddr_thresholds(self, v_address, v_port, NUM2INT(v_assoc_id), &thlds);
 
-  // If address is provided, set up the sockaddr structure based on domain
-  if(!NIL_P(v_address)){
-    const char* addr_str = StringValueCStr(v_address);
+  if(!NIL_P(v_pathmaxrxt))
+    thlds.spt_pathmaxrxt = NUM2USHORT(v_pathmaxrxt);
 
-    if(domain == AF_INET6){
-      struct sockaddr_in6* sin6 = (struct sockaddr_in6*)&paddr.spp_address;
-      sin6->sin6_family = AF_INET6;
-      if(inet_pton(AF_INET6, addr_str, &sin6->sin6_addr) <= 0)
-        rb_raise(rb_eArgError, "invalid IPv6 address: %s", addr_str);
-#ifdef BSD
-      sin6->sin6_len = sizeof(struct sockaddr_in6);
+  if(!NIL_P(v_pathpfthld))
+    thlds.spt_pathpfthld = NUM2USHORT(v_pathpfthld);
+
+  if(sctp_sys_setsockopt(fileno, IPPROTO_SCTP, SCTP_PEER_ADDR_THLDS, &thlds, sizeof(thlds)) < 0)
+    rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
+
+  return rb_struct_new(
+    v_sctp_peer_addr_thresholds_struct,
+    v_assoc_id,
+    v_address,
+    UINT2NUM(thlds.spt_pathmaxrxt),
+    UINT2NUM(thlds.spt_pathpfthld)
+  );
+}
 #endif
-    }
-    else{
-      struct sockaddr_in* sin = (struct sockaddr_in*)&paddr.spp_address;
-      sin->sin_family = AF_INET;
-      if(inet_pton(AF_INET, addr_str, &sin->sin_addr) <= 0)
-        rb_raise(rb_eArgError, "invalid IPv4 address: %s", addr_str);
-#ifdef BSD
-      sin->sin_len = sizeof(struct sockaddr_in);
+
+#ifdef SCTP_PRIMARY_ADDR
+/*
+ * call-seq:
+ *    SCTP::Socket#set_primary_address(address, association_id=nil, port=nil)
+ *
+ * Makes the given peer address the primary path of the association, so
+ * that new data is sent there. This is how an application switches paths
+ * by hand, e.g. back to the preferred link once it has recovered. The
+ * port defaults to the port of the association's peer addresses.
+ *
+ * The current primary address is reported by SCTP::Socket#get_status.
+ *
+ * Example:
+ *
+ *   socket.set_primary_address('10.0.5.5')
+ */
+static VALUE rsctp_set_primary_address(int argc, VALUE* argv, VALUE self){
+  VALUE v_address, v_assoc_id, v_port;
+  sctp_sock_t fileno;
+  struct sockaddr_storage addr;
+  struct sctp_setprim prim;
+
+  rb_scan_args(argc, argv, "12", &v_address, &v_assoc_id, &v_port);
+
+  CHECK_SOCKET_CLOSED(self);
+
+  fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+
+  if(NIL_P(v_assoc_id))
+    v_assoc_id = rb_iv_get(self, "@association_id");
+
+  parse_option_address(self, v_address, get_option_port(self, v_port, NUM2INT(v_assoc_id), 0), &addr);
+
+  bzero(&prim, sizeof(prim));
+  prim.ssp_assoc_id = NUM2INT(v_assoc_id);
+  memcpy(&prim.ssp_addr, &addr, sizeof(addr));
+
+  if(sctp_sys_setsockopt(fileno, IPPROTO_SCTP, SCTP_PRIMARY_ADDR, &prim, sizeof(prim)) < 0)
+    rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
+
+  return v_address;
+}
 #endif
-    }
-  }
 
-  if(!NIL_P(v_hbinterval))
-    paddr.spp_hbinterval = NUM2INT(v_hbinterval);
+#ifdef SCTP_SET_PEER_PRIMARY_ADDR
+/*
+ * call-seq:
+ *    SCTP::Socket#set_peer_primary_address(address, association_id=nil, port=nil)
+ *
+ * Asks the peer to make the given local address the primary path for
+ * the data it sends to us. The address must be bound to this socket,
+ * and both endpoints must support dynamic address reconfiguration
+ * (ASCONF, RFC 5061). The port defaults to the port of the association's
+ * local addresses.
+ *
+ * Example:
+ *
+ *   socket.set_peer_primary_address('10.0.4.5')
+ */
+static VALUE rsctp_set_peer_primary_address(int argc, VALUE* argv, VALUE self){
+  VALUE v_address, v_assoc_id, v_port;
+  sctp_sock_t fileno;
+  struct sockaddr_storage addr;
+  struct sctp_setpeerprim prim;
 
-  if(!NIL_P(v_pathmaxrxt))
-    paddr.spp_pathmaxrxt = NUM2INT(v_pathmaxrxt);
+  rb_scan_args(argc, argv, "12", &v_address, &v_assoc_id, &v_port);
 
-  if(!NIL_P(v_pathmtu))
-    paddr.spp_pathmtu = NUM2INT(v_pathmtu);
+  CHECK_SOCKET_CLOSED(self);
 
-  if(!NIL_P(v_flags))
-    paddr.spp_flags = NUM2INT(v_flags);
+  fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
 
-  if(!NIL_P(v_ipv6_flowlabel))
-    paddr.spp_ipv6_flowlabel = NUM2INT(v_ipv6_flowlabel);
+  if(NIL_P(v_assoc_id))
+    v_assoc_id = rb_iv_get(self, "@association_id");
 
-  if(sctp_sys_setsockopt(fileno, IPPROTO_SCTP, SCTP_PEER_ADDR_PARAMS, &paddr, sizeof(paddr)) < 0)
+  parse_option_address(self, v_address, get_option_port(self, v_port, NUM2INT(v_assoc_id), 1), &addr);
+
+  bzero(&prim, sizeof(prim));
+  prim.sspp_assoc_id = NUM2INT(v_assoc_id);
+  memcpy(&prim.sspp_addr, &addr, sizeof(addr));
+
+  if(sctp_sys_setsockopt(fileno, IPPROTO_SCTP, SCTP_SET_PEER_PRIMARY_ADDR, &prim, sizeof(prim)) < 0)
     rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
 
-  return rb_struct_new(
-    v_sctp_peer_addr_params_struct,
-    v_assoc_id,
-    v_address,
-    v_hbinterval,
-    v_pathmaxrxt,
-    v_pathmtu,
-    v_flags,
-    v_ipv6_flowlabel
-  );
+  return v_address;
+}
+#endif
+
+#ifdef SCTP_EXPOSE_POTENTIALLY_FAILED_STATE
+/*
+ * call-seq:
+ *    SCTP::Socket#expose_pf_state?
+ *
+ * Returns whether peer address change notifications are sent when an
+ * address becomes potentially failed. See SCTP::Socket#expose_pf_state=.
+ */
+static VALUE rsctp_get_expose_pf_state(VALUE self){
+  sctp_sock_t fileno;
+  socklen_t size;
+  sctp_assoc_t assoc_id;
+  struct sctp_assoc_value assoc_value;
+
+  CHECK_SOCKET_CLOSED(self);
+
+  fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+  assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
+  size = sizeof(struct sctp_assoc_value);
+
+  bzero(&assoc_value, sizeof(assoc_value));
+  assoc_value.assoc_id = assoc_id;
+
+  if(sctp_sys_opt_info(fileno, assoc_id, SCTP_EXPOSE_POTENTIALLY_FAILED_STATE, (void*)&assoc_value, &size) < 0)
+    rb_raise(rb_eSystemCallError, "sctp_opt_info: %s", strerror(errno));
+
+  // 0 leaves it to the net.sctp.pf_expose sysctl, 1 disables, 2 enables
+  if(assoc_value.assoc_value == 2)
+    return Qtrue;
+  else
+    return Qfalse;
+}
+
+/*
+ * call-seq:
+ *    SCTP::Socket#expose_pf_state=(bool)
+ *
+ * Enables or disables peer address change notifications with the
+ * SCTP_ADDR_POTENTIALLY_FAILED state. Linux does not send them unless
+ * this, or the net.sctp.pf_expose sysctl, is turned on.
+ */
+static VALUE rsctp_set_expose_pf_state(VALUE self, VALUE v_bool){
+  sctp_sock_t fileno;
+  struct sctp_assoc_value assoc_value;
+
+  CHECK_SOCKET_CLOSED(self);
+
+  fileno = NUM_TO_SCTP_FD(rb_iv_get(self, "@fileno"));
+
+  bzero(&assoc_value, sizeof(assoc_value));
+  assoc_value.assoc_id = NUM2INT(rb_iv_get(self, "@association_id"));
+
+  if(NIL_P(v_bool) || v_bool == Qfalse)
+    assoc_value.assoc_value = 1;
+  else
+    assoc_value.assoc_value = 2;
+
+  if(sctp_sys_setsockopt(fileno, IPPROTO_SCTP, SCTP_EXPOSE_POTENTIALLY_FAILED_STATE, &assoc_value, sizeof(assoc_value)) < 0)
+    rb_raise(rb_eSystemCallError, "setsockopt: %s", strerror(errno));
+
+  return v_bool;
 }
+#endif
 
 void Init_socket(void){
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+  /*
+   * All state lives in the socket objects themselves, and the globals
+   * below are only written here, so sockets can be used from any Ractor.
+   */
+  rb_ext_ractor_safe(true);
+#endif
+
+  // Initialize the SCTP stack (usrsctp only) while we're still single threaded
+  sctp_sys_global_init();
+
   mSCTP   = rb_define_module("SCTP");
   cSocket = rb_define_class_under(mSCTP, "Socket", rb_cObject);
 
   v_sndrcv_struct = rb_struct_define(
     "SendReceiveInfo", "message", "stream", "flags",
-    "ppid", "context", "ttl", "association_id", "notification", "client", NULL
+    "ppid", "context", "ttl", "association_id", "notification", "client",
+    "msg_flags", NULL
   );
 
   v_assoc_change_struct = rb_struct_define(
@@ -3421,13 +7780,28 @@ void Init_socket(void){
     "SenderDryEvent", "type", "flags", "length", "association_id", NULL
   );
 
+  v_stream_reset_event_struct = rb_struct_define(
+    "StreamResetEvent", "type", "flags", "length", "association_id", "streams", NULL
+  );
+
+  v_assoc_reset_event_struct = rb_struct_define(
+    "AssocResetEvent", "type", "flags", "length", "association_id",
+    "local_tsn", "remote_tsn", NULL
+  );
+
+  v_stream_change_event_struct = rb_struct_define(
+    "StreamChangeEvent", "type", "flags", "length", "association_id",
+    "inbound_streams", "outbound_streams", NULL
+  );
+
   v_sockaddr_in_struct = rb_struct_define(
     "SockAddrIn", "family", "port", "address", NULL
   );
 
   v_sctp_status_struct = rb_struct_define(
     "Status", "association_id", "state", "receive_window", "unacknowledged_data",
-    "pending_data", "inbound_streams", "outbound_streams", "fragmentation_point", "primary", NULL
+    "pending_data", "inbound_streams", "outbound_streams", "fragmentation_point", "primary",
+    "primary_srtt", "primary_rto", "primary_cwnd", "primary_mtu", NULL
   );
 
   v_sctp_rtoinfo_struct = rb_struct_define(
@@ -3454,7 +7828,11 @@ void Init_socket(void){
 
   v_sctp_receive_info_struct = rb_struct_define(
     "ReceiveInfo", "message", "sid", "ssn", "flags", "ppid", "tsn",
-    "cumtsn", "context", "association_id", NULL
+    "cumtsn", "context", "association_id", "next", NULL
+  );
+
+  v_sctp_next_info_struct = rb_struct_define(
+    "NextInfo", "sid", "flags", "ppid", "length", "association_id", NULL
   );
 
   v_sctp_peer_addr_params_struct = rb_struct_define(
@@ -3463,10 +7841,70 @@ void Init_socket(void){
     "ipv6_flowlabel", NULL
   );
 
+  v_sctp_peer_addr_thresholds_struct = rb_struct_define(
+    "PeerAddressThresholds", "association_id", "address",
+    "max_retransmission_count", "pf_threshold", NULL
+  );
+
   v_sctp_initmsg_struct = rb_struct_define(
     "InitMsg", "num_ostreams", "max_instreams", "max_attempts", "max_init_timeout", NULL
   );
 
+  v_latency_struct = rb_struct_define(
+    "Latency", "count", "min", "mean", "max", "p50", "p90", "p99", "p999", NULL
+  );
+
+  v_association_struct = rb_struct_define(
+    "Association", "association_id", "state", "outbound_streams", "inbound_streams",
+    "peer_addresses", "last_activity", "pending", NULL
+  );
+
+  v_sctp_stream_value_struct = rb_struct_define(
+    "StreamValue", "association_id", "stream", "value", NULL
+  );
+
+  v_sctp_default_prinfo_struct = rb_struct_define(
+    "DefaultPRInfo", "association_id", "policy", "value", NULL
+  );
+
+  v_buffer_sizes_struct = rb_struct_define(
+    "BufferSizes", "send_buffer", "receive_buffer", NULL
+  );
+
+  v_sctp_prstatus_struct = rb_struct_define(
+    "PRStatus", "association_id", "stream", "policy",
+    "abandoned_unsent", "abandoned_sent", NULL
+  );
+
+  id_call = rb_intern("call");
+
+  cMessage = rb_define_class_under(mSCTP, "Message", rb_cObject);
+  rb_undef_alloc_func(cMessage);
+  rb_define_method(cMessage, "association_id", rsctp_message_association_id, 0);
+  rb_define_method(cMessage, "client", rsctp_message_client, 0);
+  rb_define_method(cMessage, "context", rsctp_message_context, 0);
+  rb_define_method(cMessage, "flags", rsctp_message_flags, 0);
+  rb_define_method(cMessage, "message", rsctp_message_message, 0);
+  rb_define_method(cMessage, "msg_flags", rsctp_message_msg_flags, 0);
+  rb_define_method(cMessage, "timestamp", rsctp_message_timestamp, 0);
+  rb_define_method(cMessage, "notification", rsctp_message_notification, 0);
+  rb_define_method(cMessage, "notification?", rsctp_message_notification_p, 0);
+  rb_define_method(cMessage, "ppid", rsctp_message_ppid, 0);
+  rb_define_method(cMessage, "stream", rsctp_message_stream, 0);
+  rb_define_method(cMessage, "ttl", rsctp_message_ttl, 0);
+
+  cSendParams = rb_define_class_under(mSCTP, "SendParams", rb_cObject);
+  rb_define_alloc_func(cSendParams, rsctp_send_params_alloc);
+  rb_define_method(cSendParams, "initialize", rsctp_send_params_init, -1);
+  rb_define_method(cSendParams, "association_id", rsctp_send_params_association_id, 0);
+  rb_define_method(cSendParams, "context", rsctp_send_params_context, 0);
+  rb_define_method(cSendParams, "flags", rsctp_send_params_flags, 0);
+  rb_define_method(cSendParams, "ppid", rsctp_send_params_ppid, 0);
+  rb_define_method(cSendParams, "stream", rsctp_send_params_stream, 0);
+  rb_define_method(cSendParams, "ttl", rsctp_send_params_ttl, 0);
+
+  rb_define_singleton_method(cSocket, "for_fd", rsctp_s_for_fd, -1);
+
   rb_define_method(cSocket, "initialize", rsctp_init, -1);
 
   rb_define_method(cSocket, "autoclose=", rsctp_set_autoclose, 1);
@@ -3477,14 +7915,31 @@ void Init_socket(void){
   rb_define_method(cSocket, "delete_shared_key", rsctp_delete_shared_key, -1);
   rb_define_method(cSocket, "disable_fragments=", rsctp_disable_fragments, 1);
   rb_define_method(cSocket, "enable_auth_support", rsctp_enable_auth_support, -1);
+
+#ifdef SCTP_RESET_STREAMS
+  rb_define_method(cSocket, "add_streams", rsctp_add_streams, 1);
+  rb_define_method(cSocket, "enable_stream_reset", rsctp_enable_stream_reset, -1);
+  rb_define_method(cSocket, "reset_association", rsctp_reset_association, -1);
+  rb_define_method(cSocket, "reset_streams", rsctp_reset_streams, -1);
+#endif
+
   rb_define_method(cSocket, "auth_support?", rsctp_get_auth_support, -1);
   rb_define_method(cSocket, "getpeernames", rsctp_getpeernames, -1);
+  rb_define_method(cSocket, "peer_addresses", rsctp_peer_addresses, -1);
+  rb_define_method(cSocket, "track_associations?", rsctp_get_track_associations, 0);
+  rb_define_method(cSocket, "track_associations=", rsctp_set_track_associations, 1);
+  rb_define_method(cSocket, "associations", rsctp_associations, 0);
   rb_define_method(cSocket, "getlocalnames", rsctp_getlocalnames, -1);
   rb_define_method(cSocket, "get_active_shared_key", rsctp_get_active_shared_key, -1);
   rb_define_method(cSocket, "get_association_info", rsctp_get_association_info, 0);
   rb_define_method(cSocket, "get_autoclose", rsctp_get_autoclose, 0);
   rb_define_method(cSocket, "get_default_send_params", rsctp_get_default_send_params, 0);
   rb_define_method(cSocket, "get_init_msg", rsctp_get_init_msg, 0);
+  rb_define_method(cSocket, "get_fragment_interleave", rsctp_get_fragment_interleave, 0);
+  rb_define_method(cSocket, "get_maxseg", rsctp_get_maxseg, 0);
+  rb_define_method(cSocket, "get_partial_delivery_point", rsctp_get_partial_delivery_point, 0);
+  rb_define_method(cSocket, "get_receive_buffer_size", rsctp_get_receive_buffer_size, 0);
+  rb_define_method(cSocket, "get_send_buffer_size", rsctp_get_send_buffer_size, 0);
   rb_define_method(cSocket, "get_peer_address_params", rsctp_get_peer_address_params, 0);
   rb_define_method(cSocket, "get_retransmission_info", rsctp_get_retransmission_info, 0);
   rb_define_method(cSocket, "get_status", rsctp_get_status, 0);
@@ -3494,9 +7949,34 @@ void Init_socket(void){
   rb_define_method(cSocket, "map_ipv4?", rsctp_get_map_ipv4, 0);
   rb_define_method(cSocket, "nodelay?", rsctp_get_nodelay, 0);
   rb_define_method(cSocket, "nodelay=", rsctp_set_nodelay, 1);
+  rb_define_method(cSocket, "fragment_interleave=", rsctp_set_fragment_interleave, 1);
+  rb_define_method(cSocket, "maxseg=", rsctp_set_maxseg, 1);
+  rb_define_method(cSocket, "partial_delivery_point=", rsctp_set_partial_delivery_point, 1);
+  rb_define_method(cSocket, "receive_buffer_size=", rsctp_set_receive_buffer_size, 1);
+  rb_define_method(cSocket, "send_buffer_size=", rsctp_set_send_buffer_size, 1);
+  rb_define_method(cSocket, "tune_buffers", rsctp_tune_buffers, 1);
+
+#ifdef SCTP_INTERLEAVING_SUPPORTED
+  rb_define_method(cSocket, "interleaving_supported?", rsctp_get_interleaving_supported, 0);
+  rb_define_method(cSocket, "interleaving_supported=", rsctp_set_interleaving_supported, 1);
+#endif
+
+  rb_define_method(cSocket, "dispatch", rsctp_dispatch, -1);
+  rb_define_method(cSocket, "on_message", rsctp_on_message, -1);
+  rb_define_method(cSocket, "on_notification", rsctp_on_notification, 0);
   rb_define_method(cSocket, "peeloff", rsctp_peeloff, 1);
   rb_define_method(cSocket, "recvmsg", rsctp_recvmsg, -1);
-  rb_define_method(cSocket, "send", rsctp_send, 1);
+  rb_define_method(cSocket, "recv_message", rsctp_recv_message, -1);
+  rb_define_method(cSocket, "timestamps?", rsctp_get_timestamps, 0);
+  rb_define_method(cSocket, "timestamps=", rsctp_set_timestamps, 1);
+  rb_define_method(cSocket, "latency", rsctp_latency, -1);
+  rb_define_method(cSocket, "reset_latency", rsctp_reset_latency, 0);
+
+#ifdef HAVE_RB_IO_BUFFER_GET_BYTES_FOR_READING
+  rb_define_method(cSocket, "recvmsg_into", rsctp_recvmsg_into, -1);
+#endif
+
+  rb_define_method(cSocket, "send", rsctp_send, -1);
 
 #ifdef HAVE_SCTP_SENDV
   rb_define_method(cSocket, "sendv", rsctp_sendv, 1);
@@ -3504,18 +7984,58 @@ void Init_socket(void){
 
 #ifdef HAVE_SCTP_RECVV
   rb_define_method(cSocket, "recvv", rsctp_recvv, -1);
+  rb_define_method(cSocket, "next_info?", rsctp_get_next_info, 0);
+  rb_define_method(cSocket, "next_info=", rsctp_set_next_info, 1);
 #endif
 
-  rb_define_method(cSocket, "sendmsg", rsctp_sendmsg, 1);
+  rb_define_method(cSocket, "sendmsg", rsctp_sendmsg, -1);
   rb_define_method(cSocket, "set_active_shared_key", rsctp_set_active_shared_key, -1);
   rb_define_method(cSocket, "set_association_info", rsctp_set_association_info, 1);
   rb_define_method(cSocket, "set_initmsg", rsctp_set_initmsg, 1);
   rb_define_method(cSocket, "set_retransmission_info", rsctp_set_retransmission_info, 1);
   rb_define_method(cSocket, "set_default_send_params", rsctp_set_default_send_params, 1);
+
+#ifdef SCTP_DEFAULT_PRINFO
+  rb_define_method(cSocket, "get_default_prinfo", rsctp_get_default_prinfo, -1);
+  rb_define_method(cSocket, "set_default_prinfo", rsctp_set_default_prinfo, 1);
+#endif
+
+#ifdef SCTP_PR_ASSOC_STATUS
+  rb_define_method(cSocket, "get_pr_assoc_status", rsctp_get_pr_assoc_status, -1);
+  rb_define_method(cSocket, "get_pr_stream_status", rsctp_get_pr_stream_status, -1);
+#endif
+
+#ifdef SCTP_STREAM_SCHEDULER
+  rb_define_method(cSocket, "get_stream_scheduler", rsctp_get_stream_scheduler, -1);
+  rb_define_method(cSocket, "get_stream_scheduler_value", rsctp_get_stream_scheduler_value, -1);
+  rb_define_method(cSocket, "set_stream_scheduler", rsctp_set_stream_scheduler, 1);
+  rb_define_method(cSocket, "set_stream_scheduler_value", rsctp_set_stream_scheduler_value, 1);
+#endif
+
   rb_define_method(cSocket, "set_peer_address_params", rsctp_set_peer_address_params, 1);
+
+#ifdef SCTP_PEER_ADDR_THLDS
+  rb_define_method(cSocket, "get_peer_address_thresholds", rsctp_get_peer_address_thresholds, -1);
+  rb_define_method(cSocket, "set_peer_address_thresholds", rsctp_set_peer_address_thresholds, 1);
+#endif
+
+#ifdef SCTP_PRIMARY_ADDR
+  rb_define_method(cSocket, "set_primary_address", rsctp_set_primary_address, -1);
+#endif
+
+#ifdef SCTP_SET_PEER_PRIMARY_ADDR
+  rb_define_method(cSocket, "set_peer_primary_address", rsctp_set_peer_primary_address, -1);
+#endif
+
+#ifdef SCTP_EXPOSE_POTENTIALLY_FAILED_STATE
+  rb_define_method(cSocket, "expose_pf_state?", rsctp_get_expose_pf_state, 0);
+  rb_define_method(cSocket, "expose_pf_state=", rsctp_set_expose_pf_state, 1);
+#endif
   rb_define_method(cSocket, "set_shared_key", rsctp_set_shared_key, -1);
   rb_define_method(cSocket, "shutdown", rsctp_shutdown, -1);
   rb_define_method(cSocket, "subscribe", rsctp_subscribe, 1);
+  rb_define_method(cSocket, "notification_filter=", rsctp_set_notification_filter, 1);
+  rb_define_method(cSocket, "filtered_notifications", rsctp_filtered_notifications, 0);
 
   rb_define_alias(cSocket, "get_rto_info", "get_retransmission_info");
   rb_define_alias(cSocket, "set_rto_info", "set_retransmission_info");
@@ -3549,6 +8069,14 @@ void Init_socket(void){
 
   rb_define_const(cSocket, "MSG_NOTIFICATION", INT2NUM(MSG_NOTIFICATION));
 
+  /* End of a message, see SendReceiveInfo#msg_flags */
+  rb_define_const(cSocket, "MSG_EOR", INT2NUM(MSG_EOR));
+
+#ifdef HAVE_CONST_SCTP_PARTIAL_DELIVERY_ABORTED
+  /* A partial delivery was aborted, see PartialDeliveryEvent#indication */
+  rb_define_const(cSocket, "SCTP_PARTIAL_DELIVERY_ABORTED", INT2NUM(SCTP_PARTIAL_DELIVERY_ABORTED));
+#endif
+
   // ASSOCIATION STATES //
 
 #ifdef HAVE_SCTP_EMPTY
@@ -3563,6 +8091,28 @@ void Init_socket(void){
   rb_define_const(cSocket, "SCTP_SHUTDOWN_RECEIVED", INT2NUM(SCTP_SHUTDOWN_RECEIVED));
   rb_define_const(cSocket, "SCTP_SHUTDOWN_ACK_SENT", INT2NUM(SCTP_SHUTDOWN_ACK_SENT));
 
+  // ASSOCIATION CHANGE STATES //
+
+  rb_define_const(cSocket, "SCTP_COMM_UP", INT2NUM(SCTP_COMM_UP));
+  rb_define_const(cSocket, "SCTP_COMM_LOST", INT2NUM(SCTP_COMM_LOST));
+  rb_define_const(cSocket, "SCTP_RESTART", INT2NUM(SCTP_RESTART));
+  rb_define_const(cSocket, "SCTP_SHUTDOWN_COMP", INT2NUM(SCTP_SHUTDOWN_COMP));
+  rb_define_const(cSocket, "SCTP_CANT_STR_ASSOC", INT2NUM(SCTP_CANT_STR_ASSOC));
+
+  // PEER ADDRESS CHANGE STATES //
+
+  rb_define_const(cSocket, "SCTP_ADDR_AVAILABLE", INT2NUM(SCTP_ADDR_AVAILABLE));
+  rb_define_const(cSocket, "SCTP_ADDR_UNREACHABLE", INT2NUM(SCTP_ADDR_UNREACHABLE));
+  rb_define_const(cSocket, "SCTP_ADDR_REMOVED", INT2NUM(SCTP_ADDR_REMOVED));
+  rb_define_const(cSocket, "SCTP_ADDR_ADDED", INT2NUM(SCTP_ADDR_ADDED));
+  rb_define_const(cSocket, "SCTP_ADDR_MADE_PRIM", INT2NUM(SCTP_ADDR_MADE_PRIM));
+#ifdef HAVE_CONST_SCTP_ADDR_CONFIRMED
+  rb_define_const(cSocket, "SCTP_ADDR_CONFIRMED", INT2NUM(SCTP_ADDR_CONFIRMED));
+#endif
+#ifdef HAVE_CONST_SCTP_ADDR_POTENTIALLY_FAILED
+  rb_define_const(cSocket, "SCTP_ADDR_POTENTIALLY_FAILED", INT2NUM(SCTP_ADDR_POTENTIALLY_FAILED));
+#endif
+
   // BINDING //
 
   rb_define_const(cSocket, "SCTP_BINDX_ADD_ADDR", INT2NUM(SCTP_BINDX_ADD_ADDR));
@@ -3588,6 +8138,9 @@ void Init_socket(void){
 
   // PARTIAL RELIABILITY SCTP POLICY CONSTANTS //
 
+#ifdef SCTP_PR_SCTP_NONE
+  rb_define_const(cSocket, "SCTP_PR_SCTP_NONE", INT2NUM(SCTP_PR_SCTP_NONE));
+#endif
 #ifdef SCTP_PR_SCTP_TTL
   rb_define_const(cSocket, "SCTP_PR_SCTP_TTL", INT2NUM(SCTP_PR_SCTP_TTL));
 #endif
@@ -3597,4 +8150,88 @@ void Init_socket(void){
 #ifdef SCTP_PR_SCTP_BUF
   rb_define_const(cSocket, "SCTP_PR_SCTP_BUF", INT2NUM(SCTP_PR_SCTP_BUF));
 #endif
+#ifdef SCTP_PR_SCTP_PRIO
+  rb_define_const(cSocket, "SCTP_PR_SCTP_PRIO", INT2NUM(SCTP_PR_SCTP_PRIO));
+#endif
+#ifdef HAVE_CONST_SCTP_PR_SCTP_ALL
+  rb_define_const(cSocket, "SCTP_PR_SCTP_ALL", INT2NUM(SCTP_PR_SCTP_ALL));
+#endif
+
+  // STREAM RECONFIGURATION CONSTANTS //
+
+#ifdef SCTP_ENABLE_RESET_STREAM_REQ
+  rb_define_const(cSocket, "SCTP_ENABLE_RESET_STREAM_REQ", INT2NUM(SCTP_ENABLE_RESET_STREAM_REQ));
+#endif
+#ifdef SCTP_ENABLE_RESET_ASSOC_REQ
+  rb_define_const(cSocket, "SCTP_ENABLE_RESET_ASSOC_REQ", INT2NUM(SCTP_ENABLE_RESET_ASSOC_REQ));
+#endif
+#ifdef SCTP_ENABLE_CHANGE_ASSOC_REQ
+  rb_define_const(cSocket, "SCTP_ENABLE_CHANGE_ASSOC_REQ", INT2NUM(SCTP_ENABLE_CHANGE_ASSOC_REQ));
+#endif
+#ifdef SCTP_STREAM_RESET_INCOMING
+  rb_define_const(cSocket, "SCTP_STREAM_RESET_INCOMING", INT2NUM(SCTP_STREAM_RESET_INCOMING));
+#endif
+#ifdef SCTP_STREAM_RESET_OUTGOING
+  rb_define_const(cSocket, "SCTP_STREAM_RESET_OUTGOING", INT2NUM(SCTP_STREAM_RESET_OUTGOING));
+#endif
+#ifdef SCTP_STREAM_RESET_INCOMING_SSN
+  rb_define_const(cSocket, "SCTP_STREAM_RESET_INCOMING_SSN", INT2NUM(SCTP_STREAM_RESET_INCOMING_SSN));
+#endif
+#ifdef SCTP_STREAM_RESET_OUTGOING_SSN
+  rb_define_const(cSocket, "SCTP_STREAM_RESET_OUTGOING_SSN", INT2NUM(SCTP_STREAM_RESET_OUTGOING_SSN));
+#endif
+#ifdef SCTP_STREAM_RESET_DENIED
+  rb_define_const(cSocket, "SCTP_STREAM_RESET_DENIED", INT2NUM(SCTP_STREAM_RESET_DENIED));
+#endif
+#ifdef SCTP_STREAM_RESET_FAILED
+  rb_define_const(cSocket, "SCTP_STREAM_RESET_FAILED", INT2NUM(SCTP_STREAM_RESET_FAILED));
+#endif
+#ifdef SCTP_ASSOC_RESET_DENIED
+  rb_define_const(cSocket, "SCTP_ASSOC_RESET_DENIED", INT2NUM(SCTP_ASSOC_RESET_DENIED));
+#endif
+#ifdef SCTP_ASSOC_RESET_FAILED
+  rb_define_const(cSocket, "SCTP_ASSOC_RESET_FAILED", INT2NUM(SCTP_ASSOC_RESET_FAILED));
+#endif
+#ifdef SCTP_STREAM_CHANGE_DENIED
+  rb_define_const(cSocket, "SCTP_STREAM_CHANGE_DENIED", INT2NUM(SCTP_STREAM_CHANGE_DENIED));
+#endif
+#ifdef SCTP_STREAM_CHANGE_FAILED
+  rb_define_const(cSocket, "SCTP_STREAM_CHANGE_FAILED", INT2NUM(SCTP_STREAM_CHANGE_FAILED));
+#endif
+
+  // STREAM SCHEDULER CONSTANTS //
+
+#ifdef HAVE_CONST_SCTP_SS_FCFS
+  rb_define_const(cSocket, "SCTP_SS_FCFS", INT2NUM(SCTP_SS_FCFS));
+#endif
+#ifdef HAVE_CONST_SCTP_SS_PRIO
+  rb_define_const(cSocket, "SCTP_SS_PRIO", INT2NUM(SCTP_SS_PRIO));
+#endif
+#ifdef HAVE_CONST_SCTP_SS_RR
+  rb_define_const(cSocket, "SCTP_SS_RR", INT2NUM(SCTP_SS_RR));
+#endif
+#ifdef HAVE_CONST_SCTP_SS_FC
+  rb_define_const(cSocket, "SCTP_SS_FC", INT2NUM(SCTP_SS_FC));
+#endif
+#ifdef HAVE_CONST_SCTP_SS_WFQ
+  rb_define_const(cSocket, "SCTP_SS_WFQ", INT2NUM(SCTP_SS_WFQ));
+#endif
+#ifdef HAVE_CONST_SCTP_SS_DEFAULT
+  rb_define_const(cSocket, "SCTP_SS_DEFAULT", INT2NUM(SCTP_SS_DEFAULT));
+#endif
+#ifdef HAVE_CONST_SCTP_SS_ROUND_ROBIN
+  rb_define_const(cSocket, "SCTP_SS_ROUND_ROBIN", INT2NUM(SCTP_SS_ROUND_ROBIN));
+#endif
+#ifdef HAVE_CONST_SCTP_SS_ROUND_ROBIN_PACKET
+  rb_define_const(cSocket, "SCTP_SS_ROUND_ROBIN_PACKET", INT2NUM(SCTP_SS_ROUND_ROBIN_PACKET));
+#endif
+#ifdef HAVE_CONST_SCTP_SS_PRIORITY
+  rb_define_const(cSocket, "SCTP_SS_PRIORITY", INT2NUM(SCTP_SS_PRIORITY));
+#endif
+#ifdef HAVE_CONST_SCTP_SS_FAIR_BANDWITH
+  rb_define_const(cSocket, "SCTP_SS_FAIR_BANDWITH", INT2NUM(SCTP_SS_FAIR_BANDWITH));
+#endif
+#ifdef HAVE_CONST_SCTP_SS_FIRST_COME
+  rb_define_const(cSocket, "SCTP_SS_FIRST_COME", INT2NUM(SCTP_SS_FIRST_COME));
+#endif
 }
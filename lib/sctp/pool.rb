@@ -0,0 +1,295 @@
+require 'socket'
+require 'sctp/socket'
+
+module SCTP
+  # SCTP::Pool keeps established client associations open so that they can
+  # be reused, rather than paying for the four way handshake on every request.
+  #
+  # Associations are grouped by peer set, i.e. the list of addresses and the
+  # port that were passed to connectx. Each association lives on its own
+  # one-to-many socket, so that the socket's association_id, and with it
+  # methods like get_status, always refer to the leased association.
+  #
+  # Before an idle association is handed out it is health checked through
+  # get_status. Associations that are no longer established are closed and
+  # replaced with a fresh one.
+  #
+  # Example usage:
+  #
+  #   pool = SCTP::Pool.new(size: 4)
+  #
+  #   pool.with(addresses: ['10.0.4.5', '10.0.5.5'], port: 9999) do |socket, association_id|
+  #     socket.send(message: "Hello World")
+  #   end
+  #
+  #   # Or manage the lease yourself
+  #   socket, association_id = pool.checkout(addresses: ['10.0.4.5'], port: 9999)
+  #   begin
+  #     socket.send(message: "Hello World")
+  #   ensure
+  #     pool.checkin(socket)
+  #   end
+  #
+  #   pool.close
+  #
+  class Pool
+    # Raised when no association becomes available within the timeout.
+    class TimeoutError < StandardError; end
+
+    attr_reader :size, :timeout, :domain
+
+    # Create a new association pool.
+    #
+    # @param size [Integer] Maximum number of associations per peer set (default: 5)
+    # @param timeout [Numeric] Seconds to wait for a free association before
+    #   raising a Pool::TimeoutError (default: 5)
+    # @param domain [Integer] Socket domain, AF_INET or AF_INET6 (default: AF_INET)
+    # @param socket_options [Hash] Options applied to each new socket, using
+    #   the same keys as SCTP::Server, e.g. init_msg, subscriptions or nodelay
+    def initialize(size: 5, timeout: 5, domain: ::Socket::AF_INET, **socket_options)
+      raise ArgumentError, "size must be positive" unless size > 0
+
+      @size = size
+      @timeout = timeout
+      @domain = domain
+      @socket_options = socket_options.dup
+      @idle = Hash.new { |hash, key| hash[key] = [] }
+      @counts = Hash.new(0)
+      @leases = {}.compare_by_identity
+      @mutex = Mutex.new
+      @available = ConditionVariable.new
+      @closed = false
+    end
+
+    # Lease an association to the given peer set for the duration of the
+    # block. The socket and association id are yielded, and the association
+    # is returned to the pool afterwards. If the block raises a socket error
+    # the association is discarded instead.
+    #
+    # @param addresses [Array<String>, String] Peer addresses
+    # @param port [Integer] Peer port
+    # @return [Object] The value of the block
+    def with(addresses:, port:)
+      socket, association_id = checkout(addresses: addresses, port: port)
+
+      begin
+        result = yield socket, association_id
+      rescue SystemCallError, IOError
+        discard(socket)
+        raise
+      rescue Exception
+        checkin(socket)
+        raise
+      end
+
+      checkin(socket)
+      result
+    end
+
+    # Lease an association to the given peer set. An idle, healthy association
+    # is reused if there is one, otherwise a new one is established as long
+    # as the peer set is below the pool size. If not, this waits up to
+    # +timeout+ seconds for one to be checked back in.
+    #
+    # @param addresses [Array<String>, String] Peer addresses
+    # @param port [Integer] Peer port
+    # @return [Array<SCTP::Socket, Integer>] The socket and its association id
+    # @raise [Pool::TimeoutError] If no association becomes available in time
+    def checkout(addresses:, port:)
+      key = [Array(addresses).map(&:to_s).sort.freeze, Integer(port)].freeze
+      deadline = Process.clock_gettime(Process::CLOCK_MONOTONIC) + @timeout
+
+      loop do
+        socket = nil
+        create = false
+
+        @mutex.synchronize do
+          raise IOError, "pool is closed" if @closed
+
+          until (socket = @idle[key].pop) || @counts[key] < @size
+            remaining = deadline - Process.clock_gettime(Process::CLOCK_MONOTONIC)
+            raise TimeoutError, "no association available within #{@timeout} seconds" if remaining <= 0
+            @available.wait(@mutex, remaining)
+            raise IOError, "pool is closed" if @closed
+          end
+
+          unless socket
+            @counts[key] += 1
+            create = true
+          end
+        end
+
+        if create
+          begin
+            socket = connect(key)
+          rescue Exception
+            release(key)
+            raise
+          end
+        elsif !healthy?(socket)
+          close_socket(socket, abort: true)
+          release(key)
+          next
+        end
+
+        @mutex.synchronize { @leases[socket] = key }
+
+        return [socket, socket.association_id]
+      end
+    end
+
+    # Return a leased association to the pool.
+    #
+    # @param socket [SCTP::Socket] A socket returned by checkout
+    def checkin(socket)
+      key = nil
+      closed = false
+
+      @mutex.synchronize do
+        key = @leases.delete(socket)
+        raise ArgumentError, "socket was not leased from this pool" unless key
+
+        if @closed || socket.closed?
+          @counts[key] -= 1
+          closed = true
+        else
+          @idle[key].push(socket)
+        end
+
+        @available.broadcast
+      end
+
+      close_socket(socket) if closed
+
+      nil
+    end
+
+    # Abort a leased association and remove it from the pool, e.g. after an
+    # error that leaves it in an unknown state. Unlike close, any data that
+    # is still queued on it is dropped.
+    #
+    # @param socket [SCTP::Socket] A socket returned by checkout
+    def discard(socket)
+      key = @mutex.synchronize { @leases.delete(socket) }
+      raise ArgumentError, "socket was not leased from this pool" unless key
+
+      close_socket(socket, abort: true)
+      release(key)
+
+      nil
+    end
+
+    # The number of idle associations, either for a single peer set or for
+    # the whole pool.
+    #
+    # @param addresses [Array<String>, String, nil] Peer addresses
+    # @param port [Integer, nil] Peer port
+    # @return [Integer]
+    def idle(addresses: nil, port: nil)
+      @mutex.synchronize do
+        if addresses
+          key = [Array(addresses).map(&:to_s).sort, Integer(port)]
+          @idle.key?(key) ? @idle[key].size : 0
+        else
+          @idle.each_value.sum(&:size)
+        end
+      end
+    end
+
+    # The number of associations that are currently leased.
+    #
+    # @return [Integer]
+    def leased
+      @mutex.synchronize { @leases.size }
+    end
+
+    # Check if the pool is closed.
+    #
+    # @return [Boolean] true if closed, false otherwise
+    def closed?
+      @closed
+    end
+
+    # Close all idle associations. Associations that are currently leased
+    # are closed when they are checked back in.
+    def close
+      sockets = []
+
+      @mutex.synchronize do
+        @closed = true
+
+        @idle.each do |key, list|
+          @counts[key] -= list.size
+          sockets.concat(list)
+        end
+
+        @idle.clear
+        @available.broadcast
+      end
+
+      sockets.each { |socket| close_socket(socket) }
+
+      nil
+    end
+
+    private
+
+    def connect(key)
+      addresses, port = key
+      socket = SCTP::Socket.new(@domain, ::Socket::SOCK_SEQPACKET)
+
+      begin
+        setup_socket(socket)
+        socket.connectx(addresses: addresses, port: port)
+      rescue Exception
+        close_socket(socket, abort: true)
+        raise
+      end
+
+      socket
+    end
+
+    def setup_socket(socket)
+      @socket_options.each do |option, value|
+        case option
+        when :init_msg
+          socket.set_initmsg(value)
+        when :subscriptions
+          socket.subscribe(value)
+        else
+          if socket.respond_to?("#{option}=")
+            socket.public_send("#{option}=", value)
+          end
+        end
+      end
+    end
+
+    def healthy?(socket)
+      return false if socket.closed?
+      socket.get_status.state == SCTP::Socket::SCTP_ESTABLISHED
+    rescue SystemCallError, IOError
+      false
+    end
+
+    def release(key)
+      @mutex.synchronize do
+        @counts[key] -= 1 if @counts[key] > 0
+        @available.broadcast
+      end
+    end
+
+    # Healthy associations are shut down gracefully, so that any data still
+    # queued is delivered. Broken ones are aborted rather than left to linger.
+    def close_socket(socket, abort: false)
+      return if socket.closed?
+
+      if abort
+        socket.close(linger: 0)
+      else
+        socket.close
+      end
+    rescue SystemCallError, IOError
+      nil
+    end
+  end
+end
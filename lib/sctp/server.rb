@@ -32,8 +32,14 @@ module SCTP
   #     end
   #   end
   #
+  #   # Multi-threaded server, one receive loop per worker thread
+  #   server = SCTP::Server.new(['127.0.0.1'], 9999, workers: 4)
+  #   server.run do |info, socket|
+  #     socket.sendmsg(message: "Echo: #{info.message}", association_id: info.association_id)
+  #   end
+  #
   class Server
-    attr_reader :socket, :addresses, :port, :one_to_one
+    attr_reader :socket, :sockets, :addresses, :port, :one_to_one, :workers
 
     # Create a new SCTP server.
     #
@@ -43,26 +49,47 @@ module SCTP
     # @param one_to_one [Boolean] If true, uses one-to-one mode with peeloff.
     #   If false (default), uses one-to-many mode.
     # @param backlog [Integer] Listen backlog (default: 128)
+    # @param workers [Integer, nil] Number of worker threads used by #run
+    # @param reuse_port [Boolean] If true, open one listening socket per worker
+    #   with SO_REUSEPORT and let the kernel spread associations across them.
+    #   If false (default), workers are handed peeled off associations instead.
+    #   Raises NotImplementedError where SO_REUSEPORT is unsupported, including
+    #   usrsctp builds.
     # @param socket_options [Hash] Additional socket options
-    def initialize(addresses = nil, port = 0, one_to_one: false, backlog: 128, **socket_options)
+    def initialize(addresses = nil, port = 0, one_to_one: false, backlog: 128, workers: nil, reuse_port: false, **socket_options)
+      raise ArgumentError, "workers must be positive" if workers && workers < 1
+      raise ArgumentError, "reuse_port requires workers" if reuse_port && !workers
+
       @addresses = Array(addresses) if addresses
       @port = port
       @one_to_one = one_to_one
       @backlog = backlog
+      @workers = workers
+      @reuse_port = reuse_port
       @reuse_addr = socket_options.key?(:reuse_addr) ? socket_options[:reuse_addr] : true
       @socket_options = socket_options.dup
       @socket_options.delete(:reuse_addr)
       @pending_associations = {}
+      @threads = []
 
-      # Create the main server socket
-      if one_to_one
-        @socket = SCTP::Socket.new(::Socket::AF_INET, ::Socket::SOCK_STREAM)
-      else
-        @socket = SCTP::Socket.new(::Socket::AF_INET, ::Socket::SOCK_SEQPACKET)
+      # Create the main server socket, plus one more per worker if each
+      # worker gets its own listening socket.
+      count = reuse_port ? workers : 1
+
+      @sockets = Array.new(count) do
+        if one_to_one
+          SCTP::Socket.new(::Socket::AF_INET, ::Socket::SOCK_STREAM)
+        else
+          SCTP::Socket.new(::Socket::AF_INET, ::Socket::SOCK_SEQPACKET)
+        end
       end
 
-      setup_socket
-      bind_and_listen
+      @socket = @sockets.first
+
+      @sockets.each do |socket|
+        setup_socket(socket)
+        bind_and_listen(socket)
+      end
     end
 
     # Accept a new association (one-to-one mode only).
@@ -84,7 +111,7 @@ module SCTP
         client_socket = @pending_associations.delete(association_id)
       else
         # Peeloff a new socket for this association
-        client_socket = @socket.peeloff(association_id)
+        client_socket = peeloff(association_id)
       end
 
       # Store the initial message in the client socket for retrieval
@@ -115,6 +142,78 @@ module SCTP
       @socket.sendmsg(options.merge(message: data))
     end
 
+    # Run the server with a pool of worker threads, yielding each data
+    # message and the socket it arrived on to the block. Replies should be
+    # sent on that socket. This blocks until the server is closed.
+    #
+    # With reuse_port each worker runs a receive loop on its own listening
+    # socket. Otherwise a dispatcher thread receives on the server socket,
+    # peels off each new association and hands it to the next worker in
+    # turn, which then receives from all of its associations. Peeled off
+    # associations need a kernel SCTP stack, since they're waited on with
+    # IO.select.
+    #
+    # In either case the receive calls release the GVL, so the workers can
+    # receive and decode messages in parallel.
+    #
+    # @yield [info, socket] The SendReceiveInfo struct and the socket
+    # @raise [ArgumentError] If the server was created without workers
+    def run(&handler)
+      raise ArgumentError, "run requires a block" unless handler
+      raise ArgumentError, "run requires the workers option" unless @workers
+      raise "run() not available in one-to-one mode" if @one_to_one
+
+      if @reuse_port
+        @threads = @sockets.map do |socket|
+          Thread.new { listener_loop(socket, &handler) }
+        end
+      else
+        queues = Array.new(@workers) { Queue.new }
+        wakeups = Array.new(@workers) { IO.pipe }
+
+        @threads = Array.new(@workers) do |n|
+          Thread.new { worker_loop(queues[n], wakeups[n].first, &handler) }
+        end
+
+        @threads << Thread.new { dispatch_loop(queues, wakeups.map(&:last), &handler) }
+      end
+
+      @threads.each(&:join)
+    ensure
+      @threads.each(&:kill)
+      @threads.clear
+    end
+
+    # Register a handler for messages with the given ppid and/or stream on
+    # each listening socket. See SCTP::Socket#on_message.
+    #
+    # @param options [Hash] :ppid and/or :stream to match
+    # @yield [message, association_id] The payload and its association id
+    # @return [SCTP::Server] self
+    def on_message(**options, &handler)
+      @sockets.each { |socket| socket.on_message(options, &handler) }
+      self
+    end
+
+    # Receive messages on the server socket and pass them to the handlers
+    # registered with #on_message. See SCTP::Socket#dispatch.
+    #
+    # @param options [Hash] Dispatch options, e.g. :count
+    # @return [Integer] The number of messages received
+    def dispatch(**options)
+      @socket.dispatch(options)
+    end
+
+    # The association table of the server socket, a hash of association ids
+    # to Association structs. Create the server with the
+    # track_associations: true option to enable it.
+    # See SCTP::Socket#associations.
+    #
+    # @return [Hash, nil] The association table, or nil if not enabled
+    def associations
+      @socket.associations
+    end
+
     # Get local addresses bound to this server.
     #
     # @return [Array<String>] Local addresses
@@ -140,7 +239,9 @@ module SCTP
     #
     # @param options [Hash] Close options (e.g., linger: seconds)
     def close(**options)
-      @socket.close(options) unless closed?
+      @sockets.each do |socket|
+        socket.close(options) unless socket.closed?
+      end
     end
 
     # Get server socket information.
@@ -159,28 +260,28 @@ module SCTP
 
     private
 
-    def setup_socket
+    def setup_socket(socket)
       # Apply any socket options provided
       @socket_options.each do |option, value|
         case option
         when :autoclose
-          @socket.autoclose = value
+          socket.autoclose = value
         when :nodelay
-          @socket.nodelay = value
+          socket.nodelay = value
         when :init_msg
-          @socket.set_initmsg(value)
+          socket.set_initmsg(value)
         when :subscriptions
-          @socket.subscribe(value)
+          socket.subscribe(value)
         else
           # For any other options, try to call them as methods
-          if @socket.respond_to?("#{option}=")
-            @socket.send("#{option}=", value)
+          if socket.respond_to?("#{option}=")
+            socket.public_send("#{option}=", value)
           end
         end
       end
 
       # Set up default subscriptions for server operation
-      @socket.subscribe(
+      socket.subscribe(
         data_io: true,
         association: true,
         address: true,
@@ -189,18 +290,113 @@ module SCTP
       )
     end
 
-    def bind_and_listen
+    def bind_and_listen(socket)
+      options = { port: @port, reuse_addr: @reuse_addr }
+      options[:reuse_port] = true if @reuse_port
+
       if @addresses && !@addresses.empty?
-        @socket.bindx(port: @port, addresses: @addresses, reuse_addr: @reuse_addr)
+        socket.bindx(options.merge(addresses: @addresses))
       else
         # Bind to all available addresses
-        @socket.bindx(port: @port, reuse_addr: @reuse_addr)
+        socket.bindx(options)
       end
 
-      @socket.listen(@backlog)
+      socket.listen(@backlog)
+
+      # Update port if it was auto-assigned (port 0), so that any further
+      # reuse_port sockets bind to the same one.
+      @port = socket.port if @port == 0
+    end
+
+    def peeloff(association_id)
+      client = SCTP::Socket.for_fd(@socket.peeloff(association_id), @socket.domain)
+      client.association_id = association_id
+      client
+    end
+
+    # Receive loop for a worker with its own SO_REUSEPORT listening socket.
+    def listener_loop(socket)
+      until socket.closed?
+        info = socket.recvmsg
+        yield info, socket unless info.notification
+      end
+    rescue IOError, SystemCallError
+      raise unless socket.closed?
+    end
+
+    # Receive on the server socket and hand each new association to a worker.
+    def dispatch_loop(queues, wakeups)
+      next_worker = 0
+
+      until @socket.closed?
+        info = @socket.recvmsg
+        next if info.notification
+
+        # The association may already be gone, e.g. a client that sent a
+        # message and closed straight away. That must not stop the server.
+        begin
+          client = peeloff(info.association_id)
+        rescue SystemCallError
+          next
+        end
 
-      # Update port if it was auto-assigned (port 0)
-      @port = @socket.port if @port == 0
+        queues[next_worker].push([client, info])
+        wakeups[next_worker].write_nonblock(".", exception: false)
+
+        next_worker = (next_worker + 1) % queues.size
+      end
+    rescue IOError, SystemCallError
+      raise unless @socket.closed?
+    ensure
+      wakeups.each(&:close)
+    end
+
+    # Receive from every association that has been handed to this worker.
+    def worker_loop(queue, wakeup)
+      clients = {}
+
+      loop do
+        ready, = IO.select([wakeup, *clients.keys])
+
+        ready.each do |io|
+          if io == wakeup
+            # The dispatcher closes its end of the pipe when it stops
+            return if io.read_nonblock(4096, exception: false).nil?
+
+            until queue.empty?
+              client, info = queue.pop
+
+              begin
+                clients[IO.for_fd(client.fileno, autoclose: false)] = client
+              rescue Errno::EBADF, RangeError
+                client.close
+                raise NotImplementedError, "peeled off associations cannot be waited on with this SCTP stack"
+              end
+
+              yield info, client
+            end
+          else
+            client = clients[io]
+
+            begin
+              info = client.recvmsg
+            rescue IOError, SystemCallError
+              info = nil
+            end
+
+            # A closed association reads as an empty message
+            if info.nil? || (info.notification.nil? && info.message.to_s.empty?)
+              clients.delete(io)
+              client.close unless client.closed?
+            elsif info.notification.nil?
+              yield info, client
+            end
+          end
+        end
+      end
+    ensure
+      clients.each_value { |client| client.close unless client.closed? }
+      wakeup.close unless wakeup.closed?
     end
   end
 end
@@ -0,0 +1,116 @@
+require_relative 'shared_spec_helper'
+
+RSpec.describe SCTP::Socket, type: :sctp_socket do
+  include_context 'sctp_socket_helpers'
+
+  context "associations" do
+    def receive_comm_up
+      loop do
+        info = @server.recvmsg
+        break info.notification if info.notification.is_a?(Struct::AssocChange)
+      end
+    end
+
+    example "associations basic functionality" do
+      expect(@socket).to respond_to(:associations)
+      expect(@socket).to respond_to(:track_associations?)
+      expect(@socket).to respond_to(:track_associations=)
+    end
+
+    example "association tracking is off by default" do
+      expect(@socket.track_associations?).to be false
+      expect(@socket.associations).to be_nil
+    end
+
+    example "track_associations= enables and disables the table" do
+      @socket.track_associations = true
+      expect(@socket.track_associations?).to be true
+      expect(@socket.associations).to eq({})
+
+      @socket.track_associations = false
+      expect(@socket.track_associations?).to be false
+      expect(@socket.associations).to be_nil
+    end
+
+    example "track_associations= raises an error on a closed socket" do
+      @socket.close
+      expect { @socket.track_associations = true }.to raise_error(IOError)
+    end
+
+    example "sendmsg and sendv count the bytes sent as pending" do
+      @socket.track_associations = true
+      @socket.subscribe(:data_io => true, :association => true)
+      create_connection
+
+      loop do
+        info = @socket.recvmsg
+        break if info.notification.is_a?(Struct::AssocChange)
+      end
+
+      assoc = @socket.associations[@socket.association_id]
+      @socket.sendmsg(:message => "Hello")
+      expect(assoc.pending).to eq(5)
+
+      if @socket.respond_to?(:sendv)
+        @socket.sendv(:message => ["Hello", "World"])
+        expect(assoc.pending).to eq(15)
+      end
+    end
+
+    context "with a connection" do
+      before do
+        @server.track_associations = true
+        create_connection
+      end
+
+      example "an association is added when it comes up" do
+        notification = receive_comm_up
+        assoc = @server.associations[notification.association_id]
+
+        expect(assoc).to be_a(Struct::Association)
+        expect(assoc.association_id).to eq(notification.association_id)
+        expect(assoc.state).to eq(described_class::SCTP_ESTABLISHED)
+        expect(assoc.outbound_streams).to eq(notification.outbound_streams)
+        expect(assoc.inbound_streams).to eq(notification.inbound_streams)
+        expect(assoc.peer_addresses).to eq(@server.peer_addresses(notification.association_id))
+        expect(assoc.pending).to eq(0)
+      end
+
+      example "last_activity is updated when a message is received" do
+        notification = receive_comm_up
+        assoc = @server.associations[notification.association_id]
+        before = assoc.last_activity
+
+        @socket.send(:message => "Hello World")
+
+        info = @server.recvmsg
+        info = @server.recvmsg while info.notification
+
+        expect(assoc.last_activity).to be >= before
+      end
+
+      example "an association is removed when it is peeled off" do
+        notification = receive_comm_up
+        fileno = @server.peeloff(notification.association_id)
+
+        begin
+          expect(@server.associations).not_to have_key(notification.association_id)
+        ensure
+          SCTP::Socket.for_fd(fileno).close
+        end
+      end
+
+      example "an association is removed when it is shut down" do
+        notification = receive_comm_up
+        @socket.close
+
+        loop do
+          info = @server.recvmsg
+          break if info.notification.is_a?(Struct::AssocChange)
+        end
+
+        expect(@server.associations).not_to have_key(notification.association_id)
+      end
+    end
+  end
+end
@@ -46,5 +46,20 @@ RSpec.describe SCTP::Socket, type: :sctp_socket do
         )
       }.not_to raise_error
     end
+
+    example "bindx with reuse_port allows several sockets on the same port" do
+      @server.bindx(:addresses => addresses, :port => port, :reuse_addr => true, :reuse_port => true)
+      @server.listen
+
+      other = described_class.new
+      begin
+        expect{
+          other.bindx(:addresses => addresses, :port => port, :reuse_addr => true, :reuse_port => true)
+        }.not_to raise_error
+        expect(other.port).to eq(port)
+      ensure
+        other.close
+      end
+    end
   end
 end
@@ -0,0 +1,67 @@
+require_relative 'shared_spec_helper'
+
+RSpec.describe SCTP::Socket, type: :sctp_socket do
+  include_context 'sctp_socket_helpers'
+
+  context "buffer sizes" do
+    example "get_send_buffer_size basic functionality" do
+      expect(@socket).to respond_to(:get_send_buffer_size)
+      expect(@socket.get_send_buffer_size).to be_a(Integer)
+    end
+
+    example "get_receive_buffer_size basic functionality" do
+      expect(@socket).to respond_to(:get_receive_buffer_size)
+      expect(@socket.get_receive_buffer_size).to be_a(Integer)
+    end
+
+    example "send_buffer_size= sets the send buffer size" do
+      @socket.send_buffer_size = 65536
+      expect(@socket.get_send_buffer_size).to be >= 65536
+    end
+
+    example "receive_buffer_size= sets the receive buffer size" do
+      @socket.receive_buffer_size = 65536
+      expect(@socket.get_receive_buffer_size).to be >= 65536
+    end
+
+    example "buffer size setters require an integer" do
+      expect{ @socket.send_buffer_size = "big" }.to raise_error(TypeError)
+      expect{ @socket.receive_buffer_size = "big" }.to raise_error(TypeError)
+    end
+  end
+
+  context "tune_buffers" do
+    example "tune_buffers requires a bandwidth" do
+      expect{ @socket.tune_buffers({}) }.to raise_error(ArgumentError, "bandwidth parameter is required")
+      expect{ @socket.tune_buffers(:bandwidth => 0, :rtt => 10) }.to raise_error(ArgumentError)
+    end
+
+    example "tune_buffers with an explicit rtt" do
+      sizes = @socket.tune_buffers(:bandwidth => 10_000_000, :rtt => 20)
+      expect(sizes).to be_a(Struct::BufferSizes)
+      expect(sizes.send_buffer).to be_a(Integer)
+      expect(sizes.receive_buffer).to be_a(Integer)
+    end
+
+    example "tune_buffers never shrinks the buffers" do
+      before = @socket.get_receive_buffer_size
+      sizes = @socket.tune_buffers(:bandwidth => 8, :rtt => 1)
+      expect(sizes.receive_buffer).to be >= before
+    end
+
+    example "tune_buffers uses the measured rtt on a connected socket" do
+      create_connection
+      expect(@socket.tune_buffers(:bandwidth => 10_000_000)).to be_a(Struct::BufferSizes)
+    end
+
+    example "tune_buffers does not need an rtt sample" do
+      create_connection
+      expect { @socket.tune_buffers(:bandwidth => 10_000_000) }.not_to raise_error
+    end
+
+    example "tune_buffers struct members do not shadow Object#send" do
+      sizes = @socket.tune_buffers(:bandwidth => 10_000_000, :rtt => 20)
+      expect(sizes.send(:receive_buffer)).to eq(sizes.receive_buffer)
+    end
+  end
+end
@@ -34,6 +34,46 @@ RSpec.describe SCTP::Socket, type: :sctp_socket do
       expect(described_class::SCTP_SHUTDOWN_ACK_SENT).to be_a(Integer)
     end
 
+    example "SCTP_COMM_UP" do
+      expect(described_class::SCTP_COMM_UP).to be_a(Integer)
+    end
+
+    example "SCTP_COMM_LOST" do
+      expect(described_class::SCTP_COMM_LOST).to be_a(Integer)
+    end
+
+    example "SCTP_RESTART" do
+      expect(described_class::SCTP_RESTART).to be_a(Integer)
+    end
+
+    example "SCTP_SHUTDOWN_COMP" do
+      expect(described_class::SCTP_SHUTDOWN_COMP).to be_a(Integer)
+    end
+
+    example "SCTP_CANT_STR_ASSOC" do
+      expect(described_class::SCTP_CANT_STR_ASSOC).to be_a(Integer)
+    end
+
+    example "SCTP_ADDR_AVAILABLE" do
+      expect(described_class::SCTP_ADDR_AVAILABLE).to be_a(Integer)
+    end
+
+    example "SCTP_ADDR_UNREACHABLE" do
+      expect(described_class::SCTP_ADDR_UNREACHABLE).to be_a(Integer)
+    end
+
+    example "SCTP_ADDR_REMOVED" do
+      expect(described_class::SCTP_ADDR_REMOVED).to be_a(Integer)
+    end
+
+    example "SCTP_ADDR_ADDED" do
+      expect(described_class::SCTP_ADDR_ADDED).to be_a(Integer)
+    end
+
+    example "SCTP_ADDR_MADE_PRIM" do
+      expect(described_class::SCTP_ADDR_MADE_PRIM).to be_a(Integer)
+    end
+
     example "SCTP_BINDX_ADD_ADDR" do
       expect(described_class::SCTP_BINDX_ADD_ADDR).to be_a(Integer)
     end
@@ -65,5 +105,9 @@ RSpec.describe SCTP::Socket, type: :sctp_socket do
     example "MSG_NOTIFICATION" do
       expect(described_class::MSG_NOTIFICATION).to be_a(Integer)
     end
+
+    example "MSG_EOR" do
+      expect(described_class::MSG_EOR).to be_a(Integer)
+    end
   end
 end
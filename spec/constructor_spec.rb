@@ -32,4 +32,40 @@ RSpec.describe SCTP::Socket, type: :sctp_socket do
       expect(@socket.association_id).to eq(0)
     end
   end
+
+  context "for_fd" do
+    example "for_fd basic functionality" do
+      expect(described_class).to respond_to(:for_fd)
+    end
+
+    example "for_fd wraps a peeled off association" do
+      create_connection
+      @socket.send(:message => "Hello World")
+
+      info = @server.recvmsg
+      info = @server.recvmsg while info.notification
+
+      client = described_class.for_fd(@server.peeloff(info.association_id))
+
+      begin
+        expect(client).to be_a(described_class)
+        expect(client.type).to eq(Socket::SOCK_STREAM)
+        expect(client.domain).to eq(Socket::AF_INET)
+        expect(client.port).to eq(port)
+        expect(client.closed?).to be false
+      ensure
+        client.close
+      end
+    end
+
+    example "for_fd validates the domain and type" do
+      expect{ described_class.for_fd(@socket.fileno, 9999) }.to raise_error(ArgumentError)
+      expect{ described_class.for_fd(@socket.fileno, Socket::AF_INET, 9999) }.to raise_error(ArgumentError)
+    end
+
+    example "for_fd requires a descriptor" do
+      expect{ described_class.for_fd }.to raise_error(ArgumentError)
+      expect{ described_class.for_fd(-1) }.to raise_error(ArgumentError)
+    end
+  end
 end
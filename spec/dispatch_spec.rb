@@ -0,0 +1,109 @@
+require_relative 'shared_spec_helper'
+require 'timeout'
+
+RSpec.describe SCTP::Socket, type: :sctp_socket do
+  include_context 'sctp_socket_helpers'
+
+  context "dispatch" do
+    before do
+      create_connection
+    end
+
+    example "dispatch basic functionality" do
+      expect(@server).to respond_to(:dispatch)
+      expect(@server).to respond_to(:on_message)
+      expect(@server).to respond_to(:on_notification)
+    end
+
+    example "on_message requires a block" do
+      expect { @server.on_message(:ppid => 1) }.to raise_error(ArgumentError)
+    end
+
+    example "on_message returns self" do
+      expect(@server.on_message { }).to eq(@server)
+    end
+
+    example "dispatch returns when the peer of a peeled off association shuts down" do
+      @socket.send(:message => "Hello World")
+
+      info = @server.recvmsg
+      info = @server.recvmsg while info.notification
+
+      client = described_class.for_fd(@server.peeloff(info.association_id))
+
+      begin
+        @socket.send(:message => "Hello again")
+
+        received = []
+        client.on_message { |message, _| received << message }
+
+        closer = Thread.new { sleep(0.2); @socket.close }
+        result = Timeout.timeout(5) { client.dispatch }
+        closer.join
+
+        expect(result).to eq(1)
+        expect(received).to eq(["Hello again"])
+      ensure
+        client.close
+      end
+    end
+
+    example "dispatch passes the payload and association id to the handler" do
+      received = []
+      @server.on_message { |message, assoc_id| received << [message, assoc_id] }
+
+      @socket.send(:message => "Hello World")
+
+      expect(@server.dispatch(:count => 1)).to eq(1)
+      expect(received.size).to eq(1)
+      expect(received.first.first).to eq("Hello World")
+      expect(received.first.last).to be_a(Integer)
+    end
+
+    example "dispatch selects the most specific handler" do
+      received = []
+      @server.on_message(:ppid => 7, :stream => 1) { |message, _| received << [:exact, message] }
+      @server.on_message(:ppid => 7) { |message, _| received << [:ppid, message] }
+      @server.on_message(:stream => 2) { |message, _| received << [:stream, message] }
+      @server.on_message { |message, _| received << [:any, message] }
+
+      @socket.send(:message => "a", :ppid => 7, :stream => 1)
+      @socket.send(:message => "b", :ppid => 7, :stream => 3)
+      @socket.send(:message => "c", :ppid => 8, :stream => 2)
+      @socket.send(:message => "d", :ppid => 8, :stream => 3)
+
+      @server.dispatch(:count => 4)
+
+      expect(received).to eq([[:exact, "a"], [:ppid, "b"], [:stream, "c"], [:any, "d"]])
+    end
+
+    example "dispatch discards messages without a handler" do
+      @server.on_message(:ppid => 99) { raise "should not be called" }
+      @socket.send(:message => "Hello World")
+      expect(@server.dispatch(:count => 1)).to eq(1)
+    end
+
+    example "dispatch passes notifications to the notification handler" do
+      notifications = []
+      @server.on_notification { |notification| notifications << notification }
+      @server.on_message { }
+
+      @socket.send(:message => "Hello World")
+      @server.dispatch(:count => 1)
+
+      expect(notifications).not_to be_empty
+      expect(notifications.first).to be_a(Struct::AssocChange)
+    end
+
+    example "dispatch returns when a handler closes the socket" do
+      @server.on_message { @server.close }
+      @socket.send(:message => "Hello World")
+      expect(@server.dispatch).to eq(1)
+    end
+
+    example "dispatch validates its options" do
+      expect { @server.dispatch(:buffer_size => 0) }.to raise_error(ArgumentError)
+      expect { @server.dispatch(:max_message_size => 0) }.to raise_error(ArgumentError)
+    end
+  end
+end
@@ -0,0 +1,120 @@
+require_relative 'shared_spec_helper'
+
+RSpec.describe SCTP::Socket, type: :sctp_socket do
+  include_context 'sctp_socket_helpers'
+
+  context "peer address thresholds" do
+    example "peer address thresholds basic functionality" do
+      expect(@socket).to respond_to(:get_peer_address_thresholds)
+      expect(@socket).to respond_to(:set_peer_address_thresholds)
+    end
+
+    example "set_peer_address_thresholds requires a hash argument" do
+      expect { @socket.set_peer_address_thresholds("invalid") }.to raise_error(TypeError)
+      expect { @socket.set_peer_address_thresholds(nil) }.to raise_error(TypeError)
+    end
+
+    example "get_peer_address_thresholds returns the expected struct" do
+      struct = @socket.get_peer_address_thresholds
+      expect(struct).to be_a(Struct::PeerAddressThresholds)
+      expect(struct.max_retransmission_count).to be_a(Integer)
+      expect(struct.pf_threshold).to be_a(Integer)
+    end
+
+    example "set_peer_address_thresholds sets the thresholds" do
+      @socket.set_peer_address_thresholds(:pathmaxrxt => 4, :pathpfthld => 0)
+
+      struct = @socket.get_peer_address_thresholds
+      expect(struct.max_retransmission_count).to eq(4)
+      expect(struct.pf_threshold).to eq(0)
+    end
+
+    example "set_peer_address_thresholds leaves thresholds that are not passed alone" do
+      @socket.set_peer_address_thresholds(:pathmaxrxt => 4, :pathpfthld => 1)
+      @socket.set_peer_address_thresholds(:pathmaxrxt => 3)
+
+      struct = @socket.get_peer_address_thresholds
+      expect(struct.max_retransmission_count).to eq(3)
+      expect(struct.pf_threshold).to eq(1)
+    end
+
+    example "peer address thresholds can be set for a single address" do
+      create_connection
+
+      @socket.set_peer_address_thresholds(:address => addresses.last, :pathpfthld => 0)
+
+      struct = @socket.get_peer_address_thresholds(addresses.last)
+      expect(struct.address).to eq(addresses.last)
+      expect(struct.pf_threshold).to eq(0)
+    end
+
+    example "peer address thresholds accept an explicit port" do
+      create_connection
+
+      @socket.set_peer_address_thresholds(:address => addresses.last, :port => port, :pathpfthld => 1)
+
+      struct = @socket.get_peer_address_thresholds(addresses.last, nil, port)
+      expect(struct.pf_threshold).to eq(1)
+    end
+
+    example "peer address thresholds raise an error on a closed socket" do
+      @socket.close
+      expect { @socket.get_peer_address_thresholds }.to raise_error(IOError)
+      expect { @socket.set_peer_address_thresholds({}) }.to raise_error(IOError)
+    end
+  end
+
+  context "primary address" do
+    example "primary address basic functionality" do
+      expect(@socket).to respond_to(:set_primary_address)
+      expect(@socket).to respond_to(:set_peer_primary_address)
+    end
+
+    example "set_primary_address requires a valid address" do
+      expect { @socket.set_primary_address }.to raise_error(ArgumentError)
+      expect { @socket.set_primary_address("bogus") }.to raise_error(ArgumentError)
+    end
+
+    example "set_primary_address switches the primary path" do
+      create_connection
+
+      expect(@socket.set_primary_address(addresses.last)).to eq(addresses.last)
+      expect(@socket.get_status.primary).to eq(addresses.last)
+    end
+
+    example "set_primary_address accepts an explicit port" do
+      create_connection
+
+      expect(@socket.set_primary_address(addresses.last, nil, port)).to eq(addresses.last)
+      expect { @socket.set_primary_address(addresses.last, nil, port + 1) }.to raise_error(SystemCallError)
+    end
+
+    example "set_peer_primary_address requires a valid address" do
+      expect { @socket.set_peer_primary_address }.to raise_error(ArgumentError)
+      expect { @socket.set_peer_primary_address("bogus") }.to raise_error(ArgumentError)
+    end
+
+    example "primary address methods raise an error on a closed socket" do
+      @socket.close
+      expect { @socket.set_primary_address(addresses.last) }.to raise_error(IOError)
+      expect { @socket.set_peer_primary_address(addresses.last) }.to raise_error(IOError)
+    end
+  end
+
+  context "potentially failed state" do
+    example "expose_pf_state= turns potentially failed notifications on and off" do
+      skip "SCTP_EXPOSE_POTENTIALLY_FAILED_STATE is not supported" unless @socket.respond_to?(:expose_pf_state=)
+
+      @socket.expose_pf_state = true
+      expect(@socket.expose_pf_state?).to be true
+
+      @socket.expose_pf_state = false
+      expect(@socket.expose_pf_state?).to be false
+    end
+
+    example "SCTP_ADDR_POTENTIALLY_FAILED" do
+      skip "SCTP_ADDR_POTENTIALLY_FAILED is not defined" unless described_class.const_defined?(:SCTP_ADDR_POTENTIALLY_FAILED)
+      expect(described_class::SCTP_ADDR_POTENTIALLY_FAILED).to be_a(Integer)
+    end
+  end
+end
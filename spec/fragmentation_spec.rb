@@ -0,0 +1,67 @@
+require_relative 'shared_spec_helper'
+
+RSpec.describe SCTP::Socket, type: :sctp_socket do
+  include_context 'sctp_socket_helpers'
+
+  context "maxseg" do
+    example "get_maxseg basic functionality" do
+      expect(@socket).to respond_to(:get_maxseg)
+      expect(@socket.get_maxseg).to be_a(Integer)
+    end
+
+    example "maxseg= sets the maximum fragment size" do
+      expect{ @socket.maxseg = 1200 }.not_to raise_error
+      expect(@socket.get_maxseg).to be <= 1200
+    end
+
+    example "maxseg= requires an integer" do
+      expect{ @socket.maxseg = "big" }.to raise_error(TypeError)
+    end
+  end
+
+  context "partial_delivery_point" do
+    example "get_partial_delivery_point basic functionality" do
+      expect(@socket).to respond_to(:get_partial_delivery_point)
+      expect(@socket.get_partial_delivery_point).to be_a(Integer)
+    end
+
+    example "partial_delivery_point= sets the partial delivery point" do
+      @socket.partial_delivery_point = 4096
+      expect(@socket.get_partial_delivery_point).to eq(4096)
+    end
+
+    example "partial_delivery_point= requires an integer" do
+      expect{ @socket.partial_delivery_point = "big" }.to raise_error(TypeError)
+    end
+  end
+
+  context "fragment_interleave" do
+    example "get_fragment_interleave basic functionality" do
+      expect(@socket).to respond_to(:get_fragment_interleave)
+      expect(@socket.get_fragment_interleave).to be_a(Integer)
+    end
+
+    example "fragment_interleave= sets the interleave level" do
+      [0, 1, 2].each do |level|
+        @socket.fragment_interleave = level
+        expect(@socket.get_fragment_interleave).to eq(level)
+      end
+    end
+
+    example "fragment_interleave= requires an integer" do
+      expect{ @socket.fragment_interleave = "high" }.to raise_error(TypeError)
+    end
+  end
+
+  context "interleaving_supported", if: described_class.method_defined?(:interleaving_supported=) do
+    example "interleaving_supported? returns a boolean value" do
+      expect(@socket.interleaving_supported?).to eq(true).or eq(false)
+    end
+
+    example "interleaving_supported= requires fragment interleave level 2" do
+      @socket.fragment_interleave = 2
+      expect{ @socket.interleaving_supported = true }.not_to raise_error
+      expect(@socket.interleaving_supported?).to eq(true)
+    end
+  end
+end
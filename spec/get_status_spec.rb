@@ -26,5 +26,13 @@ RSpec.describe SCTP::Socket, type: :sctp_socket do
       expect(struct.fragmentation_point).to be_a(Integer)
       expect(struct.primary).to eq(addresses.first)
     end
+
+    example "status struct contains primary path values" do
+      struct = @socket.get_status
+      expect(struct.primary_srtt).to be_a(Integer)
+      expect(struct.primary_rto).to be_a(Integer)
+      expect(struct.primary_cwnd).to be_a(Integer)
+      expect(struct.primary_mtu).to be_a(Integer)
+    end
   end
 end
@@ -0,0 +1,95 @@
+require_relative 'shared_spec_helper'
+
+RSpec.describe SCTP::Socket, type: :sctp_socket do
+  include_context 'sctp_socket_helpers'
+
+  context "IO::Buffer" do
+    before do
+      create_connection
+    end
+
+    example "send accepts an IO::Buffer" do
+      buffer = IO::Buffer.for("Hello World")
+      expect(@socket.send(:message => buffer)).to eq(11)
+    end
+
+    example "send accepts offset and length options" do
+      buffer = IO::Buffer.for("Hello World")
+      expect(@socket.send(:message => buffer, :offset => 6)).to eq(5)
+      expect(@socket.send(:message => buffer, :offset => 0, :length => 5)).to eq(5)
+    end
+
+    example "send raises an error if the offset or length is out of range" do
+      buffer = IO::Buffer.for("Hello")
+      expect { @socket.send(:message => buffer, :offset => 10) }.to raise_error(ArgumentError, /offset/)
+      expect { @socket.send(:message => buffer, :length => 10) }.to raise_error(ArgumentError, /length/)
+    end
+
+    example "sendmsg accepts an IO::Buffer" do
+      buffer = IO::Buffer.for("Hello World")
+      expect(@socket.sendmsg(:message => buffer, :addresses => addresses, :port => port)).to eq(11)
+    end
+
+    example "sendv accepts IO::Buffer elements" do
+      buffers = [IO::Buffer.for("Hello "), IO::Buffer.for("World")]
+      expect(@socket.sendv(:message => buffers)).to eq(11)
+    end
+
+    example "recvmsg_into basic functionality" do
+      expect(@server).to respond_to(:recvmsg_into)
+    end
+
+    example "recvmsg_into requires an IO::Buffer" do
+      expect { @server.recvmsg_into("buffer") }.to raise_error(TypeError)
+      expect { @server.recvmsg_into(1024) }.to raise_error(TypeError)
+    end
+
+    example "recvmsg_into validates the offset" do
+      buffer = IO::Buffer.new(16)
+      expect { @server.recvmsg_into(buffer, 0, 16) }.to raise_error(ArgumentError, /offset/)
+      expect { @server.recvmsg_into(buffer, 0, -1) }.to raise_error(ArgumentError, /offset/)
+    end
+
+    example "recvmsg_into receives a message directly into the buffer" do
+      @socket.send(:message => "Hello World")
+      buffer = IO::Buffer.new(1024)
+
+      info = nil
+      loop do
+        info = @server.recvmsg_into(buffer)
+        break unless info.notification
+      end
+
+      expect(info.message).to eq(11)
+      expect(buffer.get_string(0, info.message)).to eq("Hello World")
+    end
+
+    example "recvmsg_into honors the offset" do
+      @socket.send(:message => "Hello World")
+      buffer = IO::Buffer.new(1024)
+
+      info = nil
+      loop do
+        info = @server.recvmsg_into(buffer, 0, 100)
+        break unless info.notification
+      end
+
+      expect(buffer.get_string(100, info.message)).to eq("Hello World")
+    end
+
+    example "recvv accepts an IO::Buffer" do
+      @socket.send(:message => "Hello World")
+      buffer = IO::Buffer.new(1024)
+
+      info = nil
+      info = @server.recvv(0, buffer) while info.nil?
+
+      expect(info.message).to eq(11)
+      expect(buffer.get_string(0, info.message)).to eq("Hello World")
+    end
+
+    example "recvv only accepts an offset with an IO::Buffer" do
+      expect { @server.recvv(0, 1024, 10) }.to raise_error(ArgumentError)
+    end
+  end
+end
@@ -0,0 +1,117 @@
+require_relative 'shared_spec_helper'
+
+RSpec.describe SCTP::Socket, type: :sctp_socket do
+  include_context 'sctp_socket_helpers'
+
+  context "timestamps and latency" do
+    example "timestamps basic functionality" do
+      expect(@socket).to respond_to(:timestamps?)
+      expect(@socket).to respond_to(:timestamps=)
+      expect(@socket).to respond_to(:latency)
+      expect(@socket).to respond_to(:reset_latency)
+    end
+
+    example "timestamps are off by default" do
+      expect(@socket.timestamps?).to be false
+      expect(@socket.latency).to be_nil
+    end
+
+    example "timestamps= turns the latency histograms on and off" do
+      @socket.timestamps = true
+      expect(@socket.timestamps?).to be true
+      expect(@socket.latency).to be_a(Struct::Latency)
+      expect(@socket.latency.count).to eq(0)
+
+      @socket.timestamps = false
+      expect(@socket.timestamps?).to be false
+      expect(@socket.latency).to be_nil
+    end
+
+    example "latency only accepts :receive or :send" do
+      @socket.timestamps = true
+      expect { @socket.latency(:send) }.not_to raise_error
+      expect { @socket.latency(:bogus) }.to raise_error(ArgumentError)
+    end
+
+    example "timestamps= raises an error on a closed socket" do
+      @socket.close
+      expect { @socket.timestamps = true }.to raise_error(IOError)
+    end
+
+    context "with a connection" do
+      before do
+        create_connection
+        @socket.timestamps = true
+        @server.timestamps = true
+      end
+
+      example "send records the time spent sending" do
+        3.times { @socket.send(:message => "Hello World") }
+
+        latency = @socket.latency(:send)
+        expect(latency.count).to eq(3)
+        expect(latency.min).to be <= latency.p50
+        expect(latency.p50).to be <= latency.max
+      end
+
+      example "recv_message returns the kernel arrival time" do
+        @socket.send(:message => "Hello World")
+
+        msg = @server.recv_message
+        msg = @server.recv_message while msg.notification?
+
+        # The usrsctp backend has no kernel timestamps to report
+        if msg.timestamp
+          expect(msg.timestamp).to be_a(Time)
+          expect(msg.timestamp).to be <= Time.now
+          expect(@server.latency(:receive).count).to eq(1)
+        end
+      end
+
+      example "recvmsg keeps the send info and records the receive delay" do
+        @socket.send(:message => "Hello World", :stream => 2, :ppid => 46)
+
+        info = @server.recvmsg
+        info = @server.recvmsg while info.notification
+
+        expect(info.message).to eq("Hello World")
+        expect(info.stream).to eq(2)
+        expect(info.ppid).to eq(46)
+
+        # The usrsctp backend has no kernel timestamps to report
+        expect(@server.latency(:receive).count).to be <= 1
+      end
+
+      example "recvmsg with a max size keeps the send info" do
+        @socket.send(:message => "Hello World", :stream => 3, :ppid => 47)
+
+        info = @server.recvmsg(0, 4, 1024)
+        info = @server.recvmsg(0, 4, 1024) while info.notification
+
+        expect(info.message).to eq("Hello World")
+        expect(info.stream).to eq(3)
+        expect(info.ppid).to eq(47)
+      end
+
+      example "recvv still returns the next message info" do
+        @server.next_info = true
+        @socket.send(:message => "Hello", :stream => 1)
+        @socket.send(:message => "World!", :stream => 2)
+        sleep(0.1)
+
+        info = nil
+        info = @server.recvv while info.nil?
+
+        expect(info.message).to eq("Hello")
+        expect(info.next).to be_a(Struct::NextInfo)
+        expect(info.next.sid).to eq(2)
+      end
+
+      example "reset_latency clears the histograms" do
+        @socket.send(:message => "Hello World")
+        @socket.reset_latency
+        expect(@socket.latency(:send).count).to eq(0)
+      end
+    end
+  end
+end
@@ -0,0 +1,57 @@
+require_relative 'shared_spec_helper'
+
+RSpec.describe SCTP::Socket, type: :sctp_socket do
+  include_context 'sctp_socket_helpers'
+
+  context "next_info" do
+    before do
+      create_connection
+    end
+
+    example "next_info basic functionality" do
+      expect(@server).to respond_to(:next_info?)
+      expect(@server).to respond_to(:next_info=)
+    end
+
+    example "next_info is disabled by default" do
+      expect(@server.next_info?).to eq(false)
+    end
+
+    example "next_info can be enabled and disabled" do
+      @server.next_info = true
+      expect(@server.next_info?).to eq(true)
+      @server.next_info = false
+      expect(@server.next_info?).to eq(false)
+    end
+
+    example "recvv returns info about the next queued message" do
+      @server.next_info = true
+      @socket.send(:message => "Hello", :stream => 1)
+      @socket.send(:message => "World!", :stream => 2)
+      sleep(0.1)
+
+      info = nil
+      info = @server.recvv while info.nil?
+
+      expect(info.message).to eq("Hello")
+      expect(info.next).to be_a(Struct::NextInfo)
+      expect(info.next.sid).to eq(2)
+      expect(info.next.length).to eq(6)
+    end
+
+    example "recvv returns a nil next member if next_info is disabled" do
+      @socket.send(:message => "Hello")
+
+      info = nil
+      info = @server.recvv while info.nil?
+
+      expect(info.next).to be_nil
+    end
+
+    example "next_info raises an error on a closed socket" do
+      @server.close
+      expect { @server.next_info? }.to raise_error(IOError, "socket is closed")
+      expect { @server.next_info = true }.to raise_error(IOError, "socket is closed")
+    end
+  end
+end
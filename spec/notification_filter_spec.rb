@@ -0,0 +1,65 @@
+require_relative 'shared_spec_helper'
+
+RSpec.describe SCTP::Socket, type: :sctp_socket do
+  include_context 'sctp_socket_helpers'
+
+  context "notification_filter" do
+    example "notification_filter basic functionality" do
+      expect(@socket).to respond_to(:notification_filter=)
+      expect(@socket).to respond_to(:filtered_notifications)
+    end
+
+    example "notification_filter= requires a hash or nil" do
+      expect { @socket.notification_filter = 1 }.to raise_error(TypeError)
+      expect { @socket.notification_filter = nil }.not_to raise_error
+    end
+
+    example "notification_filter= rejects invalid states" do
+      expect { @socket.notification_filter = { :association => [99] } }.to raise_error(ArgumentError)
+    end
+
+    example "notification_filter= raises an error on a closed socket" do
+      @socket.close
+      expect { @socket.notification_filter = {} }.to raise_error(IOError)
+    end
+
+    example "filtered_notifications is zero without a filter" do
+      expect(@socket.filtered_notifications).to eq(0)
+    end
+
+    context "with a connection" do
+      before do
+        @server.notification_filter = { :association => [described_class::SCTP_COMM_LOST] }
+        create_connection
+      end
+
+      example "notifications that are filtered out are swallowed and counted" do
+        @socket.send(:message => "Hello World")
+
+        info = @server.recvmsg
+
+        expect(info.notification).to be_nil
+        expect(info.message).to eq("Hello World")
+        expect(@server.filtered_notifications).to eq(1)
+      end
+
+      example "notifications that pass the filter are returned" do
+        @server.notification_filter = { :association => true }
+        @socket.send(:message => "Hello World")
+
+        info = @server.recvmsg
+
+        expect(info.notification).to be_a(Struct::AssocChange)
+        expect(@server.filtered_notifications).to eq(0)
+      end
+
+      example "filtered notifications still update the association caches" do
+        @socket.send(:message => "Hello World")
+        info = @server.recvmsg
+
+        addresses = @server.peer_addresses(info.association_id)
+        expect(@server.peer_addresses(info.association_id)).to equal(addresses)
+      end
+    end
+  end
+end
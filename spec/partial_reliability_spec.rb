@@ -0,0 +1,82 @@
+require_relative 'shared_spec_helper'
+
+RSpec.describe SCTP::Socket, type: :sctp_socket do
+  include_context 'sctp_socket_helpers'
+
+  context "partial reliability" do
+    before do
+      create_connection
+    end
+
+    example "send accepts pr_policy and pr_value options" do
+      options = { message: "Hello World", pr_policy: described_class::SCTP_PR_SCTP_RTX, pr_value: 2 }
+      expect(@socket.send(options)).to eq(11)
+    end
+
+    example "sendmsg accepts pr_policy and pr_value options" do
+      options = { message: "Hello World", pr_policy: described_class::SCTP_PR_SCTP_TTL, pr_value: 50 }
+      expect(@socket.sendmsg(options)).to eq(11)
+    end
+
+    example "sendv accepts pr_policy and pr_value options" do
+      options = { message: ["Hello ", "World"], pr_policy: described_class::SCTP_PR_SCTP_TTL, pr_value: 50 }
+      expect(@socket.sendv(options)).to eq(11)
+    end
+
+    example "pr_policy must be an integer" do
+      expect{ @socket.send(message: "Hello", pr_policy: "ttl") }.to raise_error(TypeError)
+    end
+
+    example "pr_policy must be a valid policy" do
+      options = { message: "Hello", pr_policy: described_class::SCTP_UNORDERED }
+      expect{ @socket.send(options) }.to raise_error(ArgumentError, /pr_policy/)
+      expect{ @socket.sendmsg(options) }.to raise_error(ArgumentError, /pr_policy/)
+
+      if @socket.respond_to?(:sendv)
+        expect{ @socket.sendv(options.merge(message: ["Hello"])) }.to raise_error(ArgumentError, /pr_policy/)
+      end
+
+      if @socket.respond_to?(:set_default_prinfo)
+        expect{ @socket.set_default_prinfo(policy: described_class::SCTP_UNORDERED) }.to raise_error(ArgumentError, /pr_policy/)
+      end
+    end
+
+    context "default prinfo", if: described_class.method_defined?(:set_default_prinfo) do
+      example "get_default_prinfo returns a struct" do
+        info = @socket.get_default_prinfo
+        expect(info).to be_a(Struct::DefaultPRInfo)
+        expect(info.policy).to be_a(Integer)
+      end
+
+      example "set_default_prinfo requires a policy" do
+        expect{ @socket.set_default_prinfo({}) }.to raise_error(ArgumentError, "policy parameter is required")
+      end
+
+      example "set_default_prinfo sets the default policy" do
+        @socket.set_default_prinfo(policy: described_class::SCTP_PR_SCTP_TTL, value: 50)
+        info = @socket.get_default_prinfo
+        expect(info.policy).to eq(described_class::SCTP_PR_SCTP_TTL)
+        expect(info.value).to eq(50)
+      end
+    end
+
+    context "abandoned message counters", if: described_class.method_defined?(:get_pr_assoc_status) do
+      example "get_pr_assoc_status returns a struct" do
+        status = @socket.get_pr_assoc_status
+        expect(status).to be_a(Struct::PRStatus)
+        expect(status.abandoned_unsent).to be_a(Integer)
+        expect(status.abandoned_sent).to be_a(Integer)
+      end
+
+      example "get_pr_stream_status returns a struct" do
+        status = @socket.get_pr_stream_status(0)
+        expect(status).to be_a(Struct::PRStatus)
+        expect(status.stream).to eq(0)
+      end
+
+      example "get_pr_stream_status requires a stream" do
+        expect{ @socket.get_pr_stream_status }.to raise_error(ArgumentError)
+      end
+    end
+  end
+end
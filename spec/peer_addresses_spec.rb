@@ -0,0 +1,68 @@
+require_relative 'shared_spec_helper'
+
+RSpec.describe SCTP::Socket, type: :sctp_socket do
+  include_context 'sctp_socket_helpers'
+
+  context "peer_addresses" do
+    before do
+      create_connection
+    end
+
+    def receive_comm_up
+      loop do
+        info = @server.recvmsg
+        break info.notification if info.notification.is_a?(Struct::AssocChange)
+      end
+    end
+
+    example "peer_addresses basic functionality" do
+      expect(@socket).to respond_to(:peer_addresses)
+    end
+
+    example "peer_addresses accepts at most one argument" do
+      expect { @socket.peer_addresses(1, 2) }.to raise_error(ArgumentError)
+    end
+
+    example "peer_addresses falls back to a lookup for an uncached association" do
+      addresses = @socket.peer_addresses
+      expect(addresses).to be_frozen
+      expect(addresses.sort).to eq(@socket.getpeernames.sort)
+    end
+
+    example "peer_addresses is filled from the comm up notification" do
+      @server.track_associations = true
+      notification = receive_comm_up
+      addresses = @server.peer_addresses(notification.association_id)
+
+      expect(addresses).to be_frozen
+      expect(addresses).to all(be_frozen)
+      expect(addresses).not_to be_empty
+    end
+
+    example "peer_addresses returns the same cached array on every call" do
+      @server.track_associations = true
+      notification = receive_comm_up
+      first = @server.peer_addresses(notification.association_id)
+      expect(@server.peer_addresses(notification.association_id)).to equal(first)
+    end
+
+    example "peer_addresses forgets an association that is peeled off" do
+      @server.track_associations = true
+      notification = receive_comm_up
+      @server.peer_addresses(notification.association_id)
+
+      fileno = @server.peeloff(notification.association_id)
+
+      begin
+        expect { @server.peer_addresses(notification.association_id) }.to raise_error(SystemCallError)
+      ensure
+        SCTP::Socket.for_fd(fileno).close
+      end
+    end
+
+    example "peer_addresses raises an error on a closed socket" do
+      @socket.close
+      expect { @socket.peer_addresses }.to raise_error(IOError)
+    end
+  end
+end
@@ -0,0 +1,145 @@
+require 'spec_helper'
+require 'sctp/server'
+require 'sctp/pool'
+
+RSpec.describe SCTP::Pool do
+  let(:addresses) { %w[1.1.1.1 1.1.1.2] }
+
+  before do
+    @server = SCTP::Server.new(addresses, 0)
+    @pool = described_class.new(size: 2, timeout: 0.5)
+  end
+
+  after do
+    @pool.close if @pool
+    @server.close if @server
+  end
+
+  describe '#initialize' do
+    it 'creates a pool with default options' do
+      pool = described_class.new
+      expect(pool.size).to eq(5)
+      expect(pool.timeout).to eq(5)
+      expect(pool.domain).to eq(Socket::AF_INET)
+      pool.close
+    end
+
+    it 'requires a positive size' do
+      expect { described_class.new(size: 0) }.to raise_error(ArgumentError)
+    end
+  end
+
+  describe '#checkout' do
+    it 'returns a connected socket and its association id' do
+      socket, association_id = @pool.checkout(addresses: addresses, port: @server.port)
+      expect(socket).to be_a(SCTP::Socket)
+      expect(association_id).to eq(socket.association_id)
+      expect(@pool.leased).to eq(1)
+      @pool.checkin(socket)
+    end
+
+    it 'reuses an idle association' do
+      socket, association_id = @pool.checkout(addresses: addresses, port: @server.port)
+      @pool.checkin(socket)
+      expect(@pool.idle(addresses: addresses, port: @server.port)).to eq(1)
+
+      sleep(0.1)
+
+      reused, reused_id = @pool.checkout(addresses: addresses, port: @server.port)
+      expect(reused).to equal(socket)
+      expect(reused_id).to eq(association_id)
+      @pool.checkin(reused)
+    end
+
+    it 'applies the socket options to new sockets' do
+      pool = described_class.new(size: 1, nodelay: true)
+      socket, _ = pool.checkout(addresses: addresses, port: @server.port)
+      expect(socket.nodelay?).to be true
+      pool.checkin(socket)
+    ensure
+      pool.close if pool
+    end
+
+    it 'raises a TimeoutError when the peer set is exhausted' do
+      first, _ = @pool.checkout(addresses: addresses, port: @server.port)
+      second, _ = @pool.checkout(addresses: addresses, port: @server.port)
+
+      expect {
+        @pool.checkout(addresses: addresses, port: @server.port)
+      }.to raise_error(SCTP::Pool::TimeoutError)
+
+      @pool.checkin(first)
+      @pool.checkin(second)
+    end
+
+    it 'replaces an association that is no longer established' do
+      socket, _ = @pool.checkout(addresses: addresses, port: @server.port)
+      @pool.checkin(socket)
+      socket.close
+
+      fresh, _ = @pool.checkout(addresses: addresses, port: @server.port)
+      expect(fresh).not_to equal(socket)
+      expect(fresh.closed?).to be false
+      @pool.checkin(fresh)
+    end
+
+    it 'raises an error if the pool is closed' do
+      @pool.close
+      expect {
+        @pool.checkout(addresses: addresses, port: @server.port)
+      }.to raise_error(IOError, /closed/)
+    end
+  end
+
+  describe '#checkin' do
+    it 'raises an error for a socket that was not leased' do
+      socket = SCTP::Socket.new
+      expect { @pool.checkin(socket) }.to raise_error(ArgumentError)
+      socket.close
+    end
+  end
+
+  describe '#with' do
+    it 'yields the socket and association id and returns the block value' do
+      result = @pool.with(addresses: addresses, port: @server.port) do |socket, association_id|
+        expect(association_id).to eq(socket.association_id)
+        socket.send(message: "Hello World")
+      end
+
+      expect(result).to eq(11)
+      expect(@pool.leased).to eq(0)
+      expect(@pool.idle).to eq(1)
+    end
+
+    it 'discards the association if the block raises a socket error' do
+      expect {
+        @pool.with(addresses: addresses, port: @server.port) { raise Errno::ECONNRESET }
+      }.to raise_error(Errno::ECONNRESET)
+
+      expect(@pool.leased).to eq(0)
+      expect(@pool.idle).to eq(0)
+    end
+  end
+
+  describe '#close' do
+    it 'closes idle associations' do
+      socket, _ = @pool.checkout(addresses: addresses, port: @server.port)
+      @pool.checkin(socket)
+      @pool.close
+      expect(@pool.closed?).to be true
+      expect(socket.closed?).to be true
+    end
+
+    it 'delivers data that is still queued on idle associations' do
+      @pool.with(addresses: addresses, port: @server.port) do |socket, _|
+        socket.send(message: "Hello World")
+      end
+
+      @pool.close
+
+      info = @server.recvmsg
+      info = @server.recvmsg while info.notification
+      expect(info.message).to eq("Hello World")
+    end
+  end
+end
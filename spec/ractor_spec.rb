@@ -0,0 +1,63 @@
+require_relative 'shared_spec_helper'
+
+RSpec.describe SCTP::Socket, type: :sctp_socket do
+  include_context 'sctp_socket_helpers'
+
+  # Ractor#take was replaced by Ractor#value in Ruby 3.5
+  def ractor_result(ractor)
+    ractor.respond_to?(:value) ? ractor.value : ractor.take
+  end
+
+  context "ractors", if: defined?(Ractor) do
+    before do
+      create_connection
+      @socket.send(:message => "Hello World")
+
+      @info = @server.recvmsg
+      @info = @server.recvmsg while @info.notification
+    end
+
+    example "a socket can be created and used inside a ractor" do
+      ractor = Ractor.new do
+        socket = SCTP::Socket.new
+        domain = socket.domain
+        socket.close
+        domain
+      end
+
+      expect(ractor_result(ractor)).to eq(Socket::AF_INET)
+    end
+
+    example "a peeled off association can be moved into a ractor" do
+      client = described_class.for_fd(@server.peeloff(@info.association_id))
+      @socket.send(:message => "Moved")
+
+      ractor = Ractor.new do
+        socket = Ractor.receive
+        info = socket.recvmsg
+        info = socket.recvmsg while info.notification
+        socket.close
+        info.message
+      end
+
+      ractor.send(client, move: true)
+
+      expect(ractor_result(ractor)).to eq("Moved")
+    end
+
+    example "a peeled off descriptor can be wrapped inside a ractor" do
+      fileno = @server.peeloff(@info.association_id)
+      @socket.send(:message => "Wrapped")
+
+      ractor = Ractor.new(fileno) do |fd|
+        socket = SCTP::Socket.for_fd(fd)
+        info = socket.recvmsg
+        info = socket.recvmsg while info.notification
+        socket.close
+        [info.message, info.class.name]
+      end
+
+      expect(ractor_result(ractor)).to eq(["Wrapped", "Struct::SendReceiveInfo"])
+    end
+  end
+end
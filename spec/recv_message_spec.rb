@@ -0,0 +1,59 @@
+require_relative 'shared_spec_helper'
+
+RSpec.describe SCTP::Socket, type: :sctp_socket do
+  include_context 'sctp_socket_helpers'
+
+  context "recv_message" do
+    before do
+      create_connection
+    end
+
+    example "recv_message basic functionality" do
+      expect(@server).to respond_to(:recv_message)
+    end
+
+    example "recv_message validates its arguments" do
+      expect { @server.recv_message("flags") }.to raise_error(TypeError)
+      expect { @server.recv_message(0, 0) }.to raise_error(ArgumentError, "buffer size must be positive")
+    end
+
+    example "recv_message returns an SCTP::Message" do
+      @socket.send(:message => "Hello World", :stream => 2, :ppid => 46)
+
+      msg = @server.recv_message
+      msg = @server.recv_message while msg.notification?
+
+      expect(msg).to be_a(SCTP::Message)
+      expect(msg.message).to eq("Hello World")
+      expect(msg.stream).to eq(2)
+      expect(msg.ppid).to eq(46)
+      expect(msg.association_id).to be_a(Integer)
+      expect(msg.msg_flags & described_class::MSG_EOR).not_to eq(0)
+      expect(msg.notification).to be_nil
+    end
+
+    example "recv_message decodes the client address on demand" do
+      @socket.send(:message => "Hello World")
+
+      msg = @server.recv_message
+      msg = @server.recv_message while msg.notification?
+
+      expect(msg.client).to be_a(Struct::SockAddrIn)
+      expect(addresses).to include(msg.client.address)
+      expect(msg.client).to equal(msg.client)
+    end
+
+    example "recv_message decodes notifications on demand" do
+      msg = @server.recv_message
+
+      expect(msg.notification?).to be true
+      expect(msg.message).to be_nil
+      expect(msg.notification).to be_a(Struct::AssocChange)
+      expect(msg.notification).to equal(msg.notification)
+    end
+
+    example "SCTP::Message cannot be instantiated directly" do
+      expect { SCTP::Message.new }.to raise_error(TypeError)
+    end
+  end
+end
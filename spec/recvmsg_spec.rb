@@ -184,5 +184,97 @@ RSpec.describe SCTP::Socket, type: :sctp_socket do
         expect(e.message).to match(/Resource temporarily unavailable|would block|Connection refused|Broken pipe/)
       end
     end
+
+    example "recvmsg validates max_message_size parameter" do
+      expect { @socket.recvmsg(0, 1024, "big") }.to raise_error(TypeError)
+      expect { @socket.recvmsg(0, 1024, 0) }.to raise_error(ArgumentError, "max message size must be positive")
+      expect { @socket.recvmsg(0, 1024, -1) }.to raise_error(ArgumentError, "max message size must be positive")
+    end
+
+    example "recvmsg returns msg_flags" do
+      @socket.send(:message => "Hello World")
+
+      info = @server.recvmsg
+      info = @server.recvmsg while info.notification
+
+      expect(info.msg_flags).to be_a(Integer)
+      expect(info.msg_flags & described_class::MSG_EOR).not_to eq(0)
+    end
+
+    example "recvmsg with a max_message_size reassembles large messages" do
+      message = "x" * 200_000
+      sender = Thread.new { @socket.send(:message => message) }
+
+      info = @server.recvmsg(0, 1024, 1_000_000)
+      info = @server.recvmsg(0, 1024, 1_000_000) while info.notification
+      sender.join
+
+      expect(info.message.bytesize).to eq(message.bytesize)
+      expect(info.message).to eq(message)
+      expect(info.msg_flags & described_class::MSG_EOR).not_to eq(0)
+    end
+
+    example "recvmsg raises an error if a message exceeds max_message_size" do
+      sender = Thread.new { @socket.send(:message => "x" * 4096) }
+      expect {
+        loop { break unless @server.recvmsg(0, 1024, 2048).notification }
+      }.to raise_error(RangeError, /maximum size/)
+      sender.join
+    end
+
+    example "recvmsg reports the stream of each message across repeated calls" do
+      3.times { |n| @socket.send(:message => "Hello #{n}", :stream => n) }
+
+      streams = []
+      while streams.size < 3
+        info = @server.recvmsg
+        streams << info.stream unless info.notification
+      end
+
+      expect(streams).to eq([0, 1, 2])
+    end
+
+    example "recvmsg reuses the frozen client struct for a known peer address" do
+      2.times { @socket.send(:message => "Hello World") }
+
+      clients = []
+      while clients.size < 2
+        info = @server.recvmsg
+        clients << info.client unless info.notification
+      end
+
+      expect(clients.first).to be_frozen
+      expect(clients.first.address).to be_frozen
+      expect(clients.last).to equal(clients.first)
+    end
+  end
+
+  context "recvmsg over IPv6" do
+    before do
+      @socket.close
+      @server.close
+
+      @socket = described_class.new(Socket::AF_INET6)
+      @server = described_class.new(Socket::AF_INET6)
+
+      @server.bindx(:addresses => ['::1'], :port => port, :reuse_addr => true)
+      @server.listen
+
+      @socket.bindx(:addresses => ['::1'], :port => port + 1, :reuse_addr => true)
+      @socket.connectx(:addresses => ['::1'], :port => port)
+
+      sleep(0.1)
+    end
+
+    example "recvmsg returns the IPv6 address and port of the peer" do
+      @socket.send(:message => "Hello World")
+
+      info = @server.recvmsg
+      info = @server.recvmsg while info.notification
+
+      expect(info.client.family).to eq(Socket::AF_INET6)
+      expect(info.client.address).to eq('::1')
+      expect(info.client.port).to eq(port + 1)
+    end
   end
 end
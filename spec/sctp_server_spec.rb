@@ -118,6 +118,80 @@ RSpec.describe SCTP::Server do
     # which is beyond the scope of basic unit tests
   end
 
+  describe 'workers' do
+    it 'validates the workers option' do
+      expect { SCTP::Server.new(['127.0.0.1'], 0, workers: 0) }.to raise_error(ArgumentError)
+      expect { SCTP::Server.new(['127.0.0.1'], 0, reuse_port: true) }.to raise_error(ArgumentError)
+    end
+
+    it 'opens a single socket without reuse_port' do
+      server = SCTP::Server.new(['127.0.0.1'], 0, workers: 2)
+      expect(server.workers).to eq(2)
+      expect(server.sockets.size).to eq(1)
+      server.close
+    end
+
+    it 'opens one socket per worker on the same port with reuse_port' do
+      server = SCTP::Server.new(['127.0.0.1'], 0, workers: 3, reuse_port: true)
+      expect(server.sockets.size).to eq(3)
+      expect(server.sockets.map(&:port).uniq).to eq([server.port])
+      server.close
+      expect(server.sockets).to all(be_closed)
+    end
+
+    it 'requires a block and the workers option to run' do
+      server = SCTP::Server.new(['127.0.0.1'], 0)
+      expect { server.run { } }.to raise_error(ArgumentError, /workers/)
+      server.close
+
+      server = SCTP::Server.new(['127.0.0.1'], 0, workers: 2)
+      expect { server.run }.to raise_error(ArgumentError, /block/)
+      server.close
+    end
+
+    it 'hands messages to the workers' do
+      server = SCTP::Server.new(['127.0.0.1'], 0, workers: 2)
+      received = Queue.new
+      runner = Thread.new { server.run { |info, _socket| received.push(info.message) } }
+
+      client = SCTP::Socket.new
+      client.connectx(addresses: ['127.0.0.1'], port: server.port)
+      client.send(message: "Hello World")
+
+      expect(received.pop).to eq("Hello World")
+
+      client.close
+      runner.kill
+      server.close
+    end
+
+    it 'keeps running when an association is gone before it is peeled off' do
+      server = SCTP::Server.new(['127.0.0.1'], 0, workers: 2)
+
+      gone = SCTP::Socket.new
+      gone.connectx(addresses: ['127.0.0.1'], port: server.port)
+      gone.send(message: "Goodbye")
+      gone.close(linger: 0)
+      sleep(0.1)
+
+      received = Queue.new
+      runner = Thread.new { server.run { |info, _socket| received.push(info.message) } }
+
+      client = SCTP::Socket.new
+      client.connectx(addresses: ['127.0.0.1'], port: server.port)
+      client.send(message: "Hello World")
+
+      message = received.pop
+      message = received.pop if message == "Goodbye"
+      expect(message).to eq("Hello World")
+      expect(runner).to be_alive
+
+      client.close
+      runner.kill
+      server.close
+    end
+  end
+
   describe 'socket options' do
     it 'accepts socket options during initialization' do
       expect {
@@ -125,5 +199,30 @@ RSpec.describe SCTP::Server do
         server.close
       }.not_to raise_error
     end
+
+    it 'applies setter options such as nodelay' do
+      server = SCTP::Server.new(['127.0.0.1'], 0, nodelay: true, maxseg: 1200)
+      expect(server.socket.nodelay?).to be true
+      server.close
+    end
+
+    it 'enables the association table with track_associations' do
+      server = SCTP::Server.new(['127.0.0.1'], 0, track_associations: true)
+      expect(server.associations).to eq({})
+
+      client = SCTP::Socket.new
+      client.connectx(addresses: ['127.0.0.1'], port: server.port)
+      client.send(message: "Hello World")
+
+      info = server.recvmsg
+      info = server.recvmsg while info.notification
+
+      assoc = server.associations[info.association_id]
+      expect(assoc).to be_a(Struct::Association)
+      expect(assoc.state).to eq(SCTP::Socket::SCTP_ESTABLISHED)
+
+      client.close
+      server.close
+    end
   end
 end
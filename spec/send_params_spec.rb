@@ -0,0 +1,91 @@
+require_relative 'shared_spec_helper'
+
+RSpec.describe SCTP::SendParams do
+  context "constructor" do
+    example "constructor with no arguments uses defaults" do
+      params = described_class.new
+      expect(params.stream).to eq(0)
+      expect(params.ppid).to eq(0)
+      expect(params.flags).to eq(0)
+      expect(params.ttl).to eq(0)
+      expect(params.context).to eq(0)
+      expect(params.association_id).to be_nil
+    end
+
+    example "constructor accepts send options" do
+      params = described_class.new(:stream => 2, :ppid => 46, :context => 7, :association_id => 3)
+      expect(params.stream).to eq(2)
+      expect(params.ppid).to eq(46)
+      expect(params.context).to eq(7)
+      expect(params.association_id).to eq(3)
+    end
+
+    example "a ttl sets the timed reliability flag" do
+      params = described_class.new(:ttl => 100)
+      expect(params.ttl).to eq(100)
+      expect(params.flags & SCTP::Socket::SCTP_PR_SCTP_TTL).not_to eq(0)
+    end
+
+    example "constructor accepts a partial reliability policy" do
+      params = described_class.new(:pr_policy => SCTP::Socket::SCTP_PR_SCTP_RTX, :pr_value => 2)
+      expect(params.flags & SCTP::Socket::SCTP_PR_SCTP_RTX).not_to eq(0)
+      expect(params.ttl).to eq(2)
+    end
+
+    example "constructor validates its arguments" do
+      expect { described_class.new("stream") }.to raise_error(TypeError)
+      expect { described_class.new(:stream => "1") }.to raise_error(TypeError)
+    end
+
+    example "send params are frozen" do
+      params = described_class.new(:stream => 1)
+      expect(params).to be_frozen
+      expect { params.send(:initialize, :stream => 2) }.to raise_error(FrozenError)
+    end
+
+    example "send params are shareable between ractors", if: defined?(Ractor) do
+      expect(Ractor.shareable?(described_class.new(:stream => 1))).to be true
+    end
+  end
+end
+
+RSpec.describe SCTP::Socket, type: :sctp_socket do
+  include_context 'sctp_socket_helpers'
+
+  context "send params" do
+    before do
+      create_connection
+    end
+
+    example "send accepts a message and send params" do
+      params = SCTP::SendParams.new(:stream => 1, :ppid => 46)
+      expect(@socket.send("Hello World", params)).to eq(11)
+    end
+
+    example "sendmsg accepts a message and send params" do
+      params = SCTP::SendParams.new(:stream => 1, :ppid => 46)
+      expect(@socket.sendmsg("Hello World", params)).to eq(11)
+    end
+
+    example "the receiver sees the stream and ppid from the send params" do
+      @socket.send("Hello World", SCTP::SendParams.new(:stream => 2, :ppid => 46))
+
+      info = @server.recvmsg
+      info = @server.recvmsg while info.notification
+
+      expect(info.message).to eq("Hello World")
+      expect(info.stream).to eq(2)
+      expect(info.ppid).to eq(46)
+    end
+
+    example "the second argument must be send params" do
+      expect { @socket.send("Hello World", {:stream => 1}) }.to raise_error(TypeError)
+      expect { @socket.sendmsg("Hello World", 1) }.to raise_error(TypeError)
+    end
+
+    example "an options hash cannot be combined with send params" do
+      params = SCTP::SendParams.new
+      expect { @socket.send({:message => "Hello World"}, params) }.to raise_error(ArgumentError)
+    end
+  end
+end
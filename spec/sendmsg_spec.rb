@@ -155,6 +155,16 @@ RSpec.describe SCTP::Socket, type: :sctp_socket do
         end
       end
 
+      example "sendmsg accepts binary messages with embedded null bytes" do
+        binary_msg = "\x30\x00\x02\x01\x00\xFF".b * 1024
+
+        begin
+          expect(@socket.sendmsg({ message: binary_msg })).to eq(binary_msg.bytesize)
+        rescue SystemCallError
+          # Expected in test environment
+        end
+      end
+
       example "sendmsg with zero values for numeric parameters" do
         options = {
           message: "Zero Test",
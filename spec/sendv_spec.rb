@@ -65,6 +65,11 @@ RSpec.describe SCTP::Socket, type: :sctp_socket do
       expect(@socket.sendv(options)).to eq(options[:message].sum(&:size))
     end
 
+    example "sendv accepts binary message parts with embedded null bytes" do
+      options = { message: ["\x00\x01".b, "\x02\x00\x03".b * 512] }
+      expect(@socket.sendv(options)).to eq(options[:message].sum(&:bytesize))
+    end
+
     example "sendv with nil optional parameters" do
       options = {
         message: ["test"],
@@ -0,0 +1,51 @@
+require_relative 'shared_spec_helper'
+
+RSpec.describe SCTP::Socket, type: :sctp_socket do
+  include_context 'sctp_socket_helpers'
+
+  context "stream reconfiguration", if: described_class.method_defined?(:reset_streams) do
+    before do
+      @server.enable_stream_reset
+      @socket.enable_stream_reset
+      create_connection
+    end
+
+    example "enable_stream_reset basic functionality" do
+      expect(@socket).to respond_to(:enable_stream_reset)
+      expect(@socket.enable_stream_reset(described_class::SCTP_ENABLE_RESET_STREAM_REQ)).to eq(@socket)
+    end
+
+    example "enable_stream_reset validates flags parameter type" do
+      expect{ @socket.enable_stream_reset("all") }.to raise_error(TypeError)
+    end
+
+    example "reset_streams resets all outgoing streams by default" do
+      expect(@socket.reset_streams).to eq(@socket)
+    end
+
+    example "reset_streams accepts a list of streams" do
+      expect(@socket.reset_streams(:streams => [0, 1])).to eq(@socket)
+    end
+
+    example "reset_streams validates the streams parameter" do
+      expect{ @socket.reset_streams(:streams => 1) }.to raise_error(TypeError)
+      expect{ @socket.reset_streams(:streams => ["one"]) }.to raise_error(TypeError)
+    end
+
+    example "add_streams requires a stream count" do
+      expect{ @socket.add_streams({}) }.to raise_error(ArgumentError)
+    end
+
+    example "add_streams adds outgoing streams" do
+      expect(@socket.add_streams(:output_streams => 2)).to eq(@socket)
+    end
+
+    example "reset_association basic functionality" do
+      expect(@socket).to respond_to(:reset_association)
+    end
+
+    example "subscribe accepts the reconfiguration events" do
+      expect{ @server.subscribe(:data_io => true, :stream_reset => true, :assoc_reset => true, :stream_change => true) }.not_to raise_error
+    end
+  end
+end
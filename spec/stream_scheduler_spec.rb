@@ -0,0 +1,52 @@
+require_relative 'shared_spec_helper'
+
+RSpec.describe SCTP::Socket, type: :sctp_socket do
+  include_context 'sctp_socket_helpers'
+
+  context "stream scheduler", if: described_class.method_defined?(:set_stream_scheduler) do
+    before do
+      create_connection
+    end
+
+    let(:priority) do
+      if described_class.const_defined?(:SCTP_SS_PRIO)
+        described_class::SCTP_SS_PRIO
+      else
+        described_class::SCTP_SS_PRIORITY
+      end
+    end
+
+    example "get_stream_scheduler basic functionality" do
+      expect(@socket).to respond_to(:get_stream_scheduler)
+      expect(@socket.get_stream_scheduler).to be_a(Integer)
+    end
+
+    example "set_stream_scheduler requires a hash argument" do
+      expect{ @socket.set_stream_scheduler(1) }.to raise_error(TypeError)
+    end
+
+    example "set_stream_scheduler requires a scheduler" do
+      expect{ @socket.set_stream_scheduler({}) }.to raise_error(ArgumentError, "scheduler parameter is required")
+    end
+
+    example "set_stream_scheduler changes the scheduler" do
+      @socket.set_stream_scheduler(:scheduler => priority)
+      expect(@socket.get_stream_scheduler).to eq(priority)
+    end
+
+    example "set_stream_scheduler_value requires stream and value" do
+      expect{ @socket.set_stream_scheduler_value(:value => 1) }.to raise_error(ArgumentError, "stream parameter is required")
+      expect{ @socket.set_stream_scheduler_value(:stream => 1) }.to raise_error(ArgumentError, "value parameter is required")
+    end
+
+    example "set_stream_scheduler_value sets a per stream priority" do
+      @socket.set_stream_scheduler(:scheduler => priority)
+      @socket.set_stream_scheduler_value(:stream => 1, :value => 7)
+
+      info = @socket.get_stream_scheduler_value(1)
+      expect(info).to be_a(Struct::StreamValue)
+      expect(info.stream).to eq(1)
+      expect(info.value).to eq(7)
+    end
+  end
+end
@@ -15,6 +15,29 @@ RSpec.describe SCTP::Socket, type: :sctp_socket do
     end
   end
 
+  context "subscribe per association" do
+    before do
+      create_connection
+    end
+
+    example "subscribe accepts an association_id" do
+      association_id = @socket.association_id
+      expect{ @socket.subscribe(:sender_dry => true, :association_id => association_id) }.not_to raise_error
+      expect{ @socket.subscribe(:sender_dry => false, :association_id => association_id) }.not_to raise_error
+    end
+
+    example "subscribe does not accept data_io with an association_id" do
+      expect{ @socket.subscribe(:data_io => true, :association_id => @socket.association_id) }.to raise_error(ArgumentError)
+    end
+
+    example "a per association subscription leaves other events alone" do
+      @server.subscribe(:partial_delivery => true, :association_id => 0)
+      subscriptions = @server.get_subscriptions
+      expect(subscriptions[:data_io]).to be true
+      expect(subscriptions[:association]).to be true
+    end
+  end
+
   context "get_subscriptions" do
     let(:subscriptions){ {:data_io => true, :shutdown => true} }
 